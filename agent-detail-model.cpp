@@ -34,9 +34,13 @@ void AgentDetailModel::newAgent(const qmf::Agent& agent)
     if (!agent.isValid())
         return;
 
-    clear();
+    newAttributes(agent.getAttributes());
+}
+
 
-    const qpid::types::Variant::Map& attrs(agent.getAttributes());
+void AgentDetailModel::newAttributes(const qpid::types::Variant::Map& attrs)
+{
+    clear();
 
     beginInsertRows(QModelIndex(), 0, attrs.size() - 1);
     for (qpid::types::Variant::Map::const_iterator iter = attrs.begin();
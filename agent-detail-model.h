@@ -41,6 +41,7 @@ public:
 
 public slots:
     void newAgent(const qmf::Agent&);
+    void newAttributes(const qpid::types::Variant::Map&);
     void clear();
 
 private:
@@ -0,0 +1,148 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "agent-filter.h"
+#include <QSettings>
+#include <QVariantMap>
+#include <qmf/Query.h>
+#include <qpid/types/Variant.h>
+
+namespace {
+    //
+    // Deepest nesting of and/or/not accepted.
+    //
+    const int MAX_DEPTH = 16;
+
+    bool checkTerm(const qpid::types::Variant::List& term, QString& error, int depth)
+    {
+        if (depth > MAX_DEPTH) {
+            error = "filter is nested too deeply";
+            return false;
+        }
+        if (term.empty() || term.front().getType() != qpid::types::VAR_STRING) {
+            error = "each term must start with an operator";
+            return false;
+        }
+
+        std::string op(term.front().asString());
+        size_t operands(term.size() - 1);
+        qpid::types::Variant::List::const_iterator iter(term.begin());
+        iter++;
+
+        if (op == "and" || op == "or" || op == "not") {
+            if (op == "not" ? operands != 1 : operands == 0) {
+                error = QString("'%1' has the wrong number of terms").arg(op.c_str());
+                return false;
+            }
+            for (; iter != term.end(); iter++) {
+                if (iter->getType() != qpid::types::VAR_LIST) {
+                    error = QString("'%1' takes only terms").arg(op.c_str());
+                    return false;
+                }
+                if (!checkTerm(iter->asList(), error, depth + 1))
+                    return false;
+            }
+            return true;
+        }
+
+        size_t expected;
+        if (op == "true" || op == "false")
+            expected = 0;
+        else if (op == "exists")
+            expected = 1;
+        else if (op == "eq" || op == "ne" || op == "lt" || op == "le" || op == "gt" || op == "ge" || op == "re_match")
+            expected = 2;
+        else {
+            error = QString("unknown operator '%1'").arg(op.c_str());
+            return false;
+        }
+
+        if (operands != expected) {
+            error = QString("'%1' takes %2 operand(s)").arg(op.c_str()).arg(expected);
+            return false;
+        }
+        return true;
+    }
+}
+
+
+const char* const AgentFilter::DEFAULT_FILTER = "[eq, _product, [quote, 'qpidd']]";
+
+
+bool AgentFilter::validate(const QString& predicate, QString& error)
+{
+    if (predicate.trimmed().isEmpty())
+        return true;
+
+    //
+    // The query parses the text the same way the console session will.
+    //
+    try {
+        qmf::Query query(qmf::QUERY_OBJECT, predicate.toStdString());
+        return checkTerm(query.getPredicate(), error, 0);
+    } catch (std::exception& ex) {
+        error = QString("syntax error: %1").arg(ex.what());
+    }
+    return false;
+}
+
+
+AgentFilter::PresetMap AgentFilter::presets()
+{
+    QSettings settings;
+    PresetMap result;
+
+    if (!settings.contains("Agents/filterPresets")) {
+        result["All agents"] = "";
+        result["Brokers"] = DEFAULT_FILTER;
+        result["Non-broker agents"] = "[ne, _product, [quote, 'qpidd']]";
+        return result;
+    }
+
+    QVariantMap stored(settings.value("Agents/filterPresets").toMap());
+    for (QVariantMap::const_iterator iter = stored.begin(); iter != stored.end(); iter++)
+        result[iter.key()] = iter.value().toString();
+    return result;
+}
+
+
+void AgentFilter::savePresets(const PresetMap& presets)
+{
+    QVariantMap stored;
+    for (PresetMap::const_iterator iter = presets.begin(); iter != presets.end(); iter++)
+        stored[iter.key()] = iter.value();
+
+    QSettings settings;
+    settings.setValue("Agents/filterPresets", stored);
+}
+
+
+QString AgentFilter::current()
+{
+    QSettings settings;
+    return settings.value("Agents/filter", DEFAULT_FILTER).toString();
+}
+
+
+void AgentFilter::setCurrent(const QString& predicate)
+{
+    QSettings settings;
+    settings.setValue("Agents/filter", predicate);
+}
+
@@ -0,0 +1,59 @@
+#ifndef _qe_agent_filter_h
+#define _qe_agent_filter_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QString>
+#include <QMap>
+
+//
+// Agent filters are QMF query predicates, such as
+// [eq, _product, [quote, 'qpidd']], handed to the console session so agents that
+// do not match are never reported.  Filters are checked here, on the GUI thread,
+// before they reach a QMF thread, and are kept by name as presets.
+//
+namespace AgentFilter {
+    //
+    // The filter used when none has been chosen: the brokers themselves.
+    //
+    extern const char* const DEFAULT_FILTER;
+
+    //
+    // Parse the predicate and check its operators and operand counts.  An empty
+    // filter matches every agent.
+    //
+    bool validate(const QString& predicate, QString& error);
+
+    //
+    // Named presets, kept in the settings.  A few defaults are offered until the
+    // user saves their own.
+    //
+    typedef QMap<QString, QString> PresetMap;
+    PresetMap presets();
+    void savePresets(const PresetMap&);
+
+    //
+    // The filter last applied, used for new connections.
+    //
+    QString current();
+    void setCurrent(const QString&);
+}
+
+#endif
+
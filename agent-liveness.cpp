@@ -0,0 +1,190 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "agent-liveness.h"
+#include <algorithm>
+
+namespace {
+    //
+    // Heartbeat interval, in milliseconds, assumed for agents that do not
+    // advertise one.
+    //
+    const qint64 DEFAULT_HEARTBEAT = 10000;
+
+    //
+    // How many intervals of silence, with a probe unanswered, make an agent late
+    // and how many make it stale.  A probe is sent after one interval.
+    //
+    const double LATE_INTERVALS = 1.5;
+    const double STALE_INTERVALS = 3.0;
+}
+
+
+AgentLiveness::AgentLiveness()
+{
+    // Intentionally Left Blank
+}
+
+
+qint64 AgentLiveness::heartbeatInterval(const qmf::Agent& agent)
+{
+    const qpid::types::Variant::Map& attrs(agent.getAttributes());
+    qpid::types::Variant::Map::const_iterator iter(attrs.find("_heartbeat_interval"));
+    if (iter != attrs.end()) {
+        try {
+            qint64 seconds(iter->second.asInt64());
+            if (seconds > 0)
+                return seconds * 1000;
+        } catch (std::exception&) {}
+    }
+    return DEFAULT_HEARTBEAT;
+}
+
+
+void AgentLiveness::add(const qmf::Agent& agent, qint64 now)
+{
+    Entry entry;
+    entry.agent = agent;
+    entry.lastSeen = now;
+    entry.lastProbe = 0;
+    entry.interval = heartbeatInterval(agent);
+    entry.epoch = agent.getEpoch();
+    entry.restarts = 0;
+    entry.probe = 0;
+    entry.state = LIVE;
+
+    index_t::const_iterator iter(index.find(agent.getName()));
+    if (iter != index.end()) {
+        entries[iter->second] = entry;
+        return;
+    }
+    index[agent.getName()] = entries.size();
+    entries.push_back(entry);
+}
+
+
+void AgentLiveness::remove(const std::string& name)
+{
+    index_t::iterator iter(index.find(name));
+    if (iter == index.end())
+        return;
+
+    //
+    // Fill the hole with the last entry so the table stays dense.
+    //
+    size_t slot(iter->second);
+    index.erase(iter);
+    if (slot != entries.size() - 1) {
+        entries[slot] = entries.back();
+        index[entries[slot].agent.getName()] = slot;
+    }
+    entries.pop_back();
+}
+
+
+void AgentLiveness::clear()
+{
+    entries.clear();
+    index.clear();
+}
+
+
+void AgentLiveness::seen(const qmf::Agent& agent, qint64 now, ChangeList& changes)
+{
+    index_t::const_iterator iter(index.find(agent.getName()));
+    if (iter == index.end())
+        return;
+    Entry& entry(entries[iter->second]);
+    entry.lastSeen = now;
+
+    //
+    // The handle is shared with the console, which updates the epoch in place,
+    // so the entry keeps its own copy to compare against.
+    //
+    bool restarted(agent.getEpoch() != entry.epoch);
+    if (restarted) {
+        entry.epoch = agent.getEpoch();
+        entry.restarts++;
+    }
+
+    if (!restarted && entry.state == LIVE)
+        return;
+
+    Change change;
+    change.agent = entry.agent;
+    change.state = LIVE;
+    change.restarts = entry.restarts;
+    change.requery = restarted || entry.state == STALE;
+    change.restarted = restarted;
+    changes.push_back(change);
+    entry.state = LIVE;
+}
+
+
+void AgentLiveness::sweep(qint64 now, qint64 minInterval, ChangeList& changes, std::vector<qmf::Agent>& probe)
+{
+    for (std::vector<Entry>::iterator iter = entries.begin(); iter != entries.end(); iter++) {
+        qint64 interval(std::max(iter->interval, minInterval));
+        qint64 quiet(now - iter->lastSeen);
+
+        //
+        // A quiet agent is asked before it is marked: a healthy one answers and
+        // never changes state.  One probe per interval at most, so a dead agent
+        // costs a query per heartbeat rather than one per sweep.
+        //
+        if (quiet >= interval && now - iter->lastProbe >= interval)
+            probe.push_back(iter->agent);
+
+        bool unanswered(iter->lastProbe > iter->lastSeen);
+        State state(LIVE);
+        if (unanswered && quiet >= interval * STALE_INTERVALS)
+            state = STALE;
+        else if (unanswered && quiet >= interval * LATE_INTERVALS)
+            state = LATE;
+
+        if (state != iter->state) {
+            iter->state = state;
+            Change change;
+            change.agent = iter->agent;
+            change.state = state;
+            change.restarts = iter->restarts;
+            change.requery = false;
+            change.restarted = false;
+            changes.push_back(change);
+        }
+    }
+}
+
+
+void AgentLiveness::probed(const std::string& name, uint32_t correlator, qint64 now)
+{
+    index_t::const_iterator iter(index.find(name));
+    if (iter == index.end())
+        return;
+    entries[iter->second].probe = correlator;
+    entries[iter->second].lastProbe = now;
+}
+
+
+bool AgentLiveness::isProbe(const std::string& name, uint32_t correlator) const
+{
+    index_t::const_iterator iter(index.find(name));
+    return iter != index.end() && correlator != 0 && entries[iter->second].probe == correlator;
+}
+
@@ -0,0 +1,97 @@
+#ifndef _qe_agent_liveness_h
+#define _qe_agent_liveness_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QtGlobal>
+#include <qmf/Agent.h>
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+
+//
+// Liveness of the agents on one broker connection, kept by its QMF thread.
+//
+// The console does not report heartbeats individually, so any traffic from an
+// agent (responses, events, restarts) counts as one.  An agent that has been
+// quiet for longer than its heartbeat interval is probed with a single small
+// query while it is still shown live; only an unanswered probe makes it late.
+// Only overdue agents are probed, never the whole list.  Entries live in
+// a flat table with a hashed name index so each agent event costs O(1).
+//
+class AgentLiveness {
+public:
+    typedef enum { LIVE, LATE, STALE } State;
+
+    struct Change {
+        qmf::Agent agent;
+        State state;
+        quint32 restarts;
+
+        //
+        // The agent restarted or came back from being stale, and its objects
+        // should be read again.
+        //
+        bool requery;
+        bool restarted;
+    };
+    typedef std::vector<Change> ChangeList;
+
+    AgentLiveness();
+
+    void add(const qmf::Agent&, qint64 now);
+    void remove(const std::string& name);
+    void clear();
+
+    //
+    // Record traffic from an agent, noting a restart when its epoch has moved.
+    //
+    void seen(const qmf::Agent&, qint64 now, ChangeList&);
+
+    //
+    // Age every agent against the time it was last heard from.  Agents quiet for
+    // an interval are returned for probing, at most once per interval; an agent
+    // turns late or stale only while a probe sent to it is unanswered.
+    //
+    void sweep(qint64 now, qint64 minInterval, ChangeList&, std::vector<qmf::Agent>& probe);
+
+    void probed(const std::string& name, uint32_t correlator, qint64 now);
+    bool isProbe(const std::string& name, uint32_t correlator) const;
+
+private:
+    struct Entry {
+        qmf::Agent agent;
+        qint64 lastSeen;
+        qint64 lastProbe;
+        qint64 interval;
+        quint32 epoch;
+        quint32 restarts;
+        uint32_t probe;
+        State state;
+    };
+    typedef boost::unordered_map<std::string, size_t> index_t;
+
+    std::vector<Entry> entries;
+    index_t index;
+
+    static qint64 heartbeatInterval(const qmf::Agent&);
+};
+
+#endif
+
@@ -18,6 +18,13 @@
  */
 
 #include "agent-model.h"
+#include "qmf-thread.h"
+#include "agent-liveness.h"
+#include "explorer-stats.h"
+#include "trace.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QColor>
 #include <iostream>
 
 using std::cout;
@@ -44,9 +51,10 @@ AgentModel::findOrInsertNode(IndexList& list, NodeType nodeType, AgentIndexPtr p
                              const std::string& text, const qmf::Agent& agent, QModelIndex parentIndex,
                              IndexList::iterator& listPosition)
 {
+    QE_TRACE_SCOPE("AgentModel::findOrInsertNode");
     AgentIndexPtr node;
     int rowCount;
-    std::string insertText(text.empty() ? agent.getInstance() : text);
+    std::string insertText(text.empty() && agent.isValid() ? agent.getInstance() : text);
 
     IndexList::iterator iter(list.begin());
     rowCount = 0;
@@ -66,6 +74,10 @@ AgentModel::findOrInsertNode(IndexList& list, NodeType nodeType, AgentIndexPtr p
         node->text = insertText;
         node->parent = parent;
         node->agent = agent;
+        node->liveness = -1;
+        node->livenessSince = 0;
+        node->restarts = 0;
+        node->staleBelow = 0;
         linkage[node->id] = node;
 
         if (iter == list.end())
@@ -87,19 +99,100 @@ AgentModel::findOrInsertNode(IndexList& list, NodeType nodeType, AgentIndexPtr p
 }
 
 
+AgentModel::AgentIndexPtr AgentModel::brokerNode(const std::string& broker)
+{
+    IndexList::iterator unused;
+    return findOrInsertNode(brokers, NODE_BROKER, AgentIndexPtr(), broker, qmf::Agent(), QModelIndex(), unused);
+}
+
+
 void AgentModel::addAgent(const qmf::Agent& agent)
 {
+    QE_TRACE_SCOPE("AgentModel::addAgent");
+    ExplorerStats::ScopedTimer timer(ExplorerStats::HIST_AGENT_INSERT);
     const std::string& vendor(agent.getVendor());
     const std::string& product(agent.getProduct());
     const std::string& instance(agent.getInstance());
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
     IndexList::iterator unused;
 
-    AgentIndexPtr vptr(findOrInsertNode(vendors, NODE_VENDOR, AgentIndexPtr(),
-                                        vendor, agent, QModelIndex(), unused));
+    //
+    // Agents are grouped under the broker connection that reported them.
+    //
+    AgentIndexPtr bptr(brokerNode(broker));
+    AgentIndexPtr vptr(findOrInsertNode(bptr->children, NODE_VENDOR, bptr,
+                                        vendor, agent, createIndex(bptr->row, 0, bptr->id), unused));
     AgentIndexPtr pptr(findOrInsertNode(vptr->children, NODE_PRODUCT, vptr,
                                         product, agent, createIndex(vptr->row, 0, vptr->id), unused));
     AgentIndexPtr iptr(findOrInsertNode(pptr->children, NODE_INSTANCE, pptr,
                                         instance, agent, createIndex(pptr->row, 0, pptr->id), unused));
+
+    //
+    // An agent seen again after a reconnect keeps its node; only the handle, which
+    // belongs to the new session, is replaced.
+    //
+    iptr->agent = agent;
+    setLiveness(iptr, AgentLiveness::LIVE);
+    StaleMap::iterator siter(stale.find(broker));
+    if (siter != stale.end())
+        siter->second.erase(iptr->id);
+}
+
+
+AgentModel::AgentIndexPtr AgentModel::findInstance(const std::string& broker, const qmf::Agent& agent) const
+{
+    std::string path[4] = { broker, agent.getVendor(), agent.getProduct(), agent.getInstance() };
+    const IndexList* list(&brokers);
+    AgentIndexPtr node;
+
+    for (int level = 0; level < 4; level++) {
+        IndexList::const_iterator iter(list->begin());
+        while (iter != list->end() && (*iter)->text != path[level])
+            iter++;
+        if (iter == list->end())
+            return AgentIndexPtr();
+        node = *iter;
+        list = &node->children;
+    }
+    return node;
+}
+
+
+void AgentModel::setLiveness(const AgentIndexPtr& node, int state)
+{
+    if (node->liveness == state)
+        return;
+
+    int delta((state == AgentLiveness::STALE ? 1 : 0) - (node->liveness == AgentLiveness::STALE ? 1 : 0));
+    node->liveness = state;
+    node->livenessSince = QDateTime::currentMSecsSinceEpoch();
+    QModelIndex index(createIndex(node->row, 0, node->id));
+    emit dataChanged(index, index);
+
+    if (delta == 0)
+        return;
+    for (AgentIndexPtr ptr = node->parent; ptr; ptr = ptr->parent) {
+        ptr->staleBelow += delta;
+        index = createIndex(ptr->row, 0, ptr->id);
+        emit dataChanged(index, index);
+    }
+}
+
+
+void AgentModel::agentLiveness(const qmf::Agent& agent, int state, uint restarts)
+{
+    AgentIndexPtr iptr(findInstance(QmfThread::brokerName(sender()), agent));
+    if (!iptr)
+        return;
+
+    if (iptr->restarts != restarts) {
+        iptr->restarts = restarts;
+        QModelIndex index(createIndex(iptr->row, 0, iptr->id));
+        emit dataChanged(index, index);
+    }
+    setLiveness(iptr, state);
 }
 
 
@@ -112,13 +205,20 @@ void AgentModel::delAgent(const qmf::Agent& agent)
     IndexList::iterator piter;
     IndexList::iterator iiter;
 
-    AgentIndexPtr vptr(findOrInsertNode(vendors, NODE_VENDOR, AgentIndexPtr(), vendor, agent, QModelIndex(), viter));
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+    AgentIndexPtr bptr(brokerNode(broker));
+
+    QModelIndex vindex(createIndex(bptr->row, 0, bptr->id));
+    AgentIndexPtr vptr(findOrInsertNode(bptr->children, NODE_VENDOR, bptr, vendor, agent, vindex, viter));
 
     QModelIndex pindex(createIndex(vptr->row, 0, vptr->id));
     AgentIndexPtr pptr(findOrInsertNode(vptr->children, NODE_PRODUCT, vptr, product, agent, pindex, piter));
 
     QModelIndex iindex(createIndex(pptr->row, 0, pptr->id));
     AgentIndexPtr iptr(findOrInsertNode(pptr->children, NODE_INSTANCE, pptr, instance, agent, iindex, iiter));
+    setLiveness(iptr, -1);
 
     beginRemoveRows(iindex, iptr->row, iptr->row);
     pptr->children.erase(iiter);
@@ -134,21 +234,161 @@ void AgentModel::delAgent(const qmf::Agent& agent)
         endRemoveRows();
 
         if (vptr->children.size() == 0) {
-            beginRemoveRows(QModelIndex(), vptr->row, vptr->row);
-            vendors.erase(viter);
+            beginRemoveRows(vindex, vptr->row, vptr->row);
+            bptr->children.erase(viter);
             linkage.erase(linkage.find(vptr->id));
-            renumber(vendors);
+            renumber(bptr->children);
             endRemoveRows();
         }
     }
 }
 
 
+void AgentModel::unlink(const AgentIndexPtr& node)
+{
+    for (IndexList::const_iterator iter = node->children.begin(); iter != node->children.end(); iter++)
+        unlink(*iter);
+    linkage.erase(node->id);
+}
+
+
+void AgentModel::brokerConnected(bool isConnected)
+{
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+
+    //
+    // Drop whatever was known from this broker.  A fresh connection gets an empty
+    // broker node that its agents are added under.  The agent details are cleared
+    // only when they show one of this broker's agents.
+    //
+    IndexList::iterator iter(brokers.begin());
+    while (iter != brokers.end() && (*iter)->text != broker)
+        iter++;
+
+    stale.erase(broker);
+    if (iter != brokers.end()) {
+        AgentIndexPtr bptr(*iter);
+        beginRemoveRows(QModelIndex(), bptr->row, bptr->row);
+        unlink(bptr);
+        brokers.erase(iter);
+        renumber(brokers);
+        endRemoveRows();
+    }
+    if (broker == selectedBroker) {
+        selectedBroker.clear();
+        emit selectionCleared();
+    }
+
+    if (isConnected)
+        brokerNode(broker);
+}
+
+
+void AgentModel::markStale(const AgentIndexPtr& node, std::set<quint32>& ids)
+{
+    for (IndexList::const_iterator iter = node->children.begin(); iter != node->children.end(); iter++)
+        markStale(*iter, ids);
+    if (node->nodeType == NODE_INSTANCE)
+        ids.insert(node->id);
+}
+
+
+void AgentModel::beginResync()
+{
+    //
+    // The broker has reconnected.  Everything known from it is kept but marked
+    // stale until the new session reports it again.
+    //
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+    std::set<quint32>& ids(stale[broker]);
+    ids.clear();
+    markStale(brokerNode(broker), ids);
+}
+
+
+void AgentModel::endResync()
+{
+    //
+    // Agents the new session did not report have gone away while the broker was
+    // unreachable.  Remove them as if they had been deleted.
+    //
+    StaleMap::iterator siter(stale.find(QmfThread::brokerName(sender())));
+    if (siter == stale.end())
+        return;
+    std::set<quint32> ids;
+    ids.swap(siter->second);
+    stale.erase(siter);
+
+    for (std::set<quint32>::const_iterator iter = ids.begin(); iter != ids.end(); iter++) {
+        IndexMap::const_iterator link(linkage.find(*iter));
+        if (link != linkage.end())
+            delAgent(qmf::Agent(link->second->agent));
+    }
+}
+
+
+void AgentModel::loadSnapshot(const SnapshotFile& file)
+{
+    clear();
+
+    //
+    // Recorded agents all go under one node for the file; the broker each was
+    // reported by is kept as an extra attribute.
+    //
+    IndexList::iterator unused;
+    AgentIndexPtr bptr(brokerNode("snapshot:" + QFileInfo(file.fileName()).fileName().toStdString()));
+    const std::vector<SnapshotFile::AgentRecord>& records(file.agents());
+    for (std::vector<SnapshotFile::AgentRecord>::const_iterator iter = records.begin(); iter != records.end(); iter++) {
+        AgentIndexPtr vptr(findOrInsertNode(bptr->children, NODE_VENDOR, bptr, iter->vendor, qmf::Agent(),
+                                            createIndex(bptr->row, 0, bptr->id), unused));
+        AgentIndexPtr pptr(findOrInsertNode(vptr->children, NODE_PRODUCT, vptr, iter->product, qmf::Agent(),
+                                            createIndex(vptr->row, 0, vptr->id), unused));
+        AgentIndexPtr iptr(findOrInsertNode(pptr->children, NODE_INSTANCE, pptr,
+                                            iter->instance.empty() ? iter->name : iter->instance, qmf::Agent(),
+                                            createIndex(pptr->row, 0, pptr->id), unused));
+        iptr->attributes = iter->attributes;
+        iptr->attributes["_broker"] = iter->broker;
+    }
+}
+
+
+void AgentModel::allAgents(BrokerAgentList& agents) const
+{
+    for (IndexMap::const_iterator iter = linkage.begin(); iter != linkage.end(); iter++) {
+        if (iter->second->nodeType != NODE_INSTANCE || !iter->second->agent.isValid())
+            continue;
+        AgentIndexPtr broker(iter->second);
+        while (broker->parent)
+            broker = broker->parent;
+        agents.push_back(std::make_pair(broker->text, iter->second->agent));
+    }
+}
+
+
+size_t AgentModel::memoryUsage() const
+{
+    //
+    // An estimate: each node, its shared-pointer control block and its list and
+    // map entries, plus the node text.  The agent handles are shared with qpid.
+    //
+    size_t total(0);
+    for (IndexMap::const_iterator iter = linkage.begin(); iter != linkage.end(); iter++)
+        total += sizeof(AgentIndex) + 96 + iter->second->text.capacity();
+    return total;
+}
+
+
 void AgentModel::clear()
 {
-    beginRemoveRows(QModelIndex(), 0, vendors.size() - 1);
-    vendors.clear();
+    beginRemoveRows(QModelIndex(), 0, brokers.size() - 1);
+    brokers.clear();
     linkage.clear();
+    stale.clear();
+    selectedBroker.clear();
     endRemoveRows();
 }
 
@@ -167,18 +407,26 @@ void AgentModel::selected(const QModelIndex& index)
     //
     // The selected tree row is a valid instance.  Relay it outbound.
     //
-    if (ptr->nodeType == NODE_INSTANCE)
-        emit instSelected(ptr->agent);
+    if (ptr->nodeType == NODE_INSTANCE) {
+        AgentIndexPtr bptr(ptr);
+        while (bptr->parent)
+            bptr = bptr->parent;
+        selectedBroker = bptr->text;
+        if (ptr->agent.isValid())
+            emit instSelected(ptr->agent);
+        else
+            emit attributesSelected(ptr->attributes);
+    }
 }
 
 
 int AgentModel::rowCount(const QModelIndex &parent) const
 {
     //
-    // If the parent is invalid (top-level), return the number of vendors.
+    // If the parent is invalid (top-level), return the number of brokers.
     //
     if (!parent.isValid())
-        return (int) vendors.size();
+        return (int) brokers.size();
 
     //
     // Get the data record linked to the ID.
@@ -190,12 +438,13 @@ int AgentModel::rowCount(const QModelIndex &parent) const
     const AgentIndexPtr ptr(iter->second);
 
     //
-    // For parents that are vendor or product, return the number of children.
+    // For parents that are broker, vendor or product, return the number of children.
     //
     switch (ptr->nodeType) {
     case NODE_INSTANCE:
         // For instance nodes, return 0 because there are no children.
         return 0;
+    case NODE_BROKER:
     case NODE_VENDOR:
     case NODE_PRODUCT:
         return (int) ptr->children.size();
@@ -214,9 +463,6 @@ int AgentModel::columnCount(const QModelIndex &parent) const
 
 QVariant AgentModel::data(const QModelIndex &index, int role) const
 {
-    if (role != Qt::DisplayRole)
-        return QVariant();
-
     if (!index.isValid())
         return QVariant();
 
@@ -234,7 +480,49 @@ QVariant AgentModel::data(const QModelIndex &index, int role) const
     if (liter == linkage.end())
         return QVariant();
     const AgentIndexPtr ptr(liter->second);
-    return QString(ptr->text.c_str());
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString(ptr->text.c_str());
+
+    case Qt::DecorationRole:
+        //
+        // A colored marker per agent, and on every level above a stale one.
+        //
+        if (ptr->nodeType != NODE_INSTANCE)
+            return ptr->staleBelow > 0 ? QVariant(QColor(Qt::red)) : QVariant();
+        switch (ptr->liveness) {
+        case AgentLiveness::LIVE:  return QColor(Qt::darkGreen);
+        case AgentLiveness::LATE:  return QColor(255, 165, 0);
+        case AgentLiveness::STALE: return QColor(Qt::red);
+        }
+        return QVariant();
+
+    case Qt::ForegroundRole:
+        if (ptr->nodeType == NODE_INSTANCE && ptr->liveness == AgentLiveness::STALE)
+            return QColor(Qt::gray);
+        return QVariant();
+
+    case Qt::ToolTipRole:
+        if (ptr->nodeType != NODE_INSTANCE) {
+            if (ptr->staleBelow > 0)
+                return QString("%1 stale agent(s)").arg(ptr->staleBelow);
+            return QVariant();
+        }
+        if (ptr->liveness >= 0) {
+            static const char* names[] = { "Live", "Late", "Stale" };
+            QString tip(QString("%1 since %2").arg(names[ptr->liveness])
+                        .arg(QDateTime::fromMSecsSinceEpoch(ptr->livenessSince).toString("hh:mm:ss")));
+            if (ptr->agent.isValid())
+                tip += QString(", epoch %1").arg(ptr->agent.getEpoch());
+            if (ptr->restarts > 0)
+                tip += QString(", restarted %1 time(s)").arg(ptr->restarts);
+            return tip;
+        }
+        return QVariant();
+    }
+
+    return QVariant();
 }
 
 
@@ -262,13 +550,13 @@ QModelIndex AgentModel::parent(const QModelIndex& index) const
     AgentIndexPtr ptr(iter->second);
 
     //
-    // Handle the vendor case
+    // Handle the broker case
     //
-    if (ptr->nodeType == NODE_VENDOR)
+    if (ptr->nodeType == NODE_BROKER)
         return QModelIndex();
 
     //
-    // Handle the product and instance level cases
+    // Handle the vendor, product and instance level cases
     //
     return createIndex(ptr->parent->row, 0, ptr->parent->id);
 }
@@ -281,16 +569,16 @@ QModelIndex AgentModel::index(int row, int column, const QModelIndex &parent) co
 
     if (!parent.isValid()) {
         //
-        // Handle the vendor-level case
+        // Handle the broker-level case
         //
         count = 0;
-        iter = vendors.begin();
-        while (iter != vendors.end() && count < row) {
+        iter = brokers.begin();
+        while (iter != brokers.end() && count < row) {
             count++;
             iter++;
         }
 
-        if (iter == vendors.end())
+        if (iter == brokers.end())
             return QModelIndex();
         return createIndex(row, 0, (*iter)->id);
     }
@@ -310,16 +598,17 @@ QModelIndex AgentModel::index(int row, int column, const QModelIndex &parent) co
     switch (ptr->nodeType) {
     case NODE_INSTANCE:
         return QModelIndex();
+    case NODE_BROKER:
     case NODE_VENDOR:
     case NODE_PRODUCT:
         count = 0;
         iter = ptr->children.begin();
-        while (count < row) {
+        while (iter != ptr->children.end() && count < row) {
             iter++;
             count++;
         }
 
-        if (iter == vendors.end())
+        if (iter == ptr->children.end())
             return QModelIndex();
         return createIndex(row, 0, (*iter)->id);
     }
@@ -23,10 +23,13 @@
 #include <QModelIndex>
 #include <QMutex>
 #include <qmf/Agent.h>
+#include "snapshot-file.h"
 #include <sstream>
 #include <string>
 #include <map>
+#include <set>
 #include <list>
+#include <vector>
 #include <deque>
 #include <boost/shared_ptr.hpp>
 
@@ -46,17 +49,41 @@ public:
     QModelIndex parent(const QModelIndex& index) const;
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
 
+    size_t memoryUsage() const;
+
+    //
+    // Replace the tree with the agents recorded in a snapshot file.  These have
+    // no live handle, only their attributes.
+    //
+    void loadSnapshot(const SnapshotFile&);
+
+    //
+    // Every known agent with the broker it was reported by.
+    //
+    typedef std::vector<std::pair<std::string, qmf::Agent> > BrokerAgentList;
+    void allAgents(BrokerAgentList&) const;
+
 public slots:
     void addAgent(const qmf::Agent&);
     void delAgent(const qmf::Agent&);
+    void agentLiveness(const qmf::Agent&, int, uint);
+    void brokerConnected(bool);
+    void beginResync();
+    void endResync();
     void clear();
     void selected(const QModelIndex&);
 
 signals:
     void instSelected(const qmf::Agent&);
+    void attributesSelected(const qpid::types::Variant::Map&);
+
+    //
+    // The broker of the last selected agent has dropped its agents.
+    //
+    void selectionCleared();
 
 private:
-    typedef enum { NODE_VENDOR, NODE_PRODUCT, NODE_INSTANCE } NodeType;
+    typedef enum { NODE_BROKER, NODE_VENDOR, NODE_PRODUCT, NODE_INSTANCE } NodeType;
     struct AgentIndex;
     typedef boost::shared_ptr<AgentIndex> AgentIndexPtr;
     typedef std::map<quint32, AgentIndexPtr> IndexMap;
@@ -70,13 +97,36 @@ private:
         AgentIndexPtr parent;
         IndexList children;
         qmf::Agent agent;
+        qpid::types::Variant::Map attributes;
+
+        //
+        // Instance nodes: the AgentLiveness state (-1 when not tracked), when it
+        // was entered and how often the agent has restarted.  Other nodes count
+        // the stale instances beneath them so a collapsed tree still shows them.
+        //
+        int liveness;
+        qint64 livenessSince;
+        quint32 restarts;
+        int staleBelow;
     };
 
-    IndexList vendors;
+    //
+    // Instance nodes not yet seen again since their broker reconnected, by broker.
+    //
+    typedef std::map<std::string, std::set<quint32> > StaleMap;
+
+    IndexList brokers;
     IndexMap linkage;
+    StaleMap stale;
+    std::string selectedBroker;
     quint32 nextId;
 
     void renumber(IndexList&);
+    void unlink(const AgentIndexPtr&);
+    void markStale(const AgentIndexPtr&, std::set<quint32>&);
+    void setLiveness(const AgentIndexPtr&, int);
+    AgentIndexPtr findInstance(const std::string&, const qmf::Agent&) const;
+    AgentIndexPtr brokerNode(const std::string&);
     AgentIndexPtr findOrInsertNode(IndexList&, NodeType, AgentIndexPtr, const std::string&,
                                    const qmf::Agent&, QModelIndex, IndexList::iterator&);
 };
@@ -0,0 +1,508 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "class-table-model.h"
+#include "explorer-stats.h"
+#include "trace.h"
+#include "object-model.h"
+#include "rate-engine.h"
+#include "qmf-variant.h"
+#include <qmf/SchemaId.h>
+#include <qmf/DataAddr.h>
+#include <algorithm>
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+namespace {
+    const qpid::types::Variant voidValue;
+}
+
+//
+// Ordering of rows by the typed value in the sort column.  Column 0 is the
+// instance name, the remaining columns are properties.
+//
+class ClassTableModel::RowLess {
+public:
+    RowLess(const ClassTableModel* m, int c, Qt::SortOrder o) : model(m), column(c), order(o) {}
+
+    bool operator()(const ClassRowPtr& left, const ClassRowPtr& right) const
+    {
+        int result(model->compareCells(left, right, column));
+
+        //
+        // Break ties on the instance name so the order is stable across updates.
+        //
+        if (result == 0)
+            result = left->text.compare(right->text);
+
+        return order == Qt::AscendingOrder ? result < 0 : result > 0;
+    }
+
+private:
+    const ClassTableModel* model;
+    int column;
+    Qt::SortOrder order;
+};
+
+
+ClassTableModel::ClassTableModel(ObjectModel* o, RateEngine* r, QObject* parent) :
+    QAbstractItemModel(parent), objectModel(o), rateEngine(r), sortColumn(-1), sortOrder(Qt::AscendingOrder)
+{
+    // Intentionally Left Blank
+}
+
+
+void ClassTableModel::renumber(int first)
+{
+    for (int idx = first; idx < (int) rows.size(); idx++)
+        rows[idx]->row = idx;
+}
+
+
+const qpid::types::Variant& ClassTableModel::cellValue(const ClassRowPtr& ptr, int column) const
+{
+    const qpid::types::Variant::Map& props(ptr->object.getProperties());
+    qpid::types::Variant::Map::const_iterator iter(props.find(columns[column - 1].property));
+    if (iter == props.end())
+        return voidValue;
+    return iter->second;
+}
+
+
+bool ClassTableModel::cellRate(const ClassRowPtr& ptr, int column, double& perSecond) const
+{
+    RateEngine::Rate rate;
+    if (!rateEngine || !rateEngine->rate(package + "/" + schema + "/" + ptr->text,
+                                         columns[column - 1].property, rate))
+        return false;
+    perSecond = rate.perSecond;
+    return true;
+}
+
+
+int ClassTableModel::compareCells(const ClassRowPtr& left, const ClassRowPtr& right, int column) const
+{
+    if (column == 0)
+        return left->text.compare(right->text);
+
+    if (!columns[column - 1].derived)
+        return QmfVariant::compare(cellValue(left, column), cellValue(right, column));
+
+    //
+    // Rate columns compare numerically, with rows that have no rate yet first.
+    //
+    double l;
+    double r;
+    bool hasLeft(cellRate(left, column, l));
+    bool hasRight(cellRate(right, column, r));
+    if (!hasLeft || !hasRight)
+        return (hasLeft ? 1 : 0) - (hasRight ? 1 : 0);
+    return l < r ? -1 : (r < l ? 1 : 0);
+}
+
+
+void ClassTableModel::addColumn(const std::string& property)
+{
+    Column column;
+    column.property = property;
+    column.derived = false;
+    columnsByName[property] = (int) columns.size() + 1;
+    columns.push_back(column);
+
+    if (rateEngine && rateEngine->isCounter(property)) {
+        column.derived = true;
+        columns.push_back(column);
+    }
+}
+
+
+void ClassTableModel::selectClass(const QString& p, const QString& s)
+{
+    std::string newPackage(p.toStdString());
+    std::string newSchema(s.toStdString());
+
+    if (newPackage == package && newSchema == schema)
+        return;
+
+    //
+    // Rebuild the table from the objects already known for this class.  This is a
+    // full reset because both the row and column sets are replaced.
+    //
+    std::vector<qmf::Data> objects;
+    objectModel->classObjects(newPackage, newSchema, objects);
+
+    beginResetModel();
+    package = newPackage;
+    schema = newSchema;
+    rows.clear();
+    rowsByKey.clear();
+    columns.clear();
+    columnsByName.clear();
+
+    for (std::vector<qmf::Data>::const_iterator iter = objects.begin(); iter != objects.end(); iter++) {
+        const qmf::DataAddr& addr(iter->getAddr());
+        const qpid::types::Variant::Map& props(iter->getProperties());
+        for (qpid::types::Variant::Map::const_iterator piter = props.begin(); piter != props.end(); piter++)
+            if (columnsByName.find(piter->first) == columnsByName.end())
+                addColumn(piter->first);
+
+        ClassRowPtr ptr(new ClassRow());
+        ptr->text = addr.getAgentName() + ":" + addr.getName();
+        ptr->object = *iter;
+        rowsByKey[ptr->text] = ptr;
+        rows.push_back(ptr);
+    }
+
+    if (sortColumn > (int) columns.size())
+        sortColumn = -1;
+    if (sortColumn >= 0)
+        std::stable_sort(rows.begin(), rows.end(), RowLess(this, sortColumn, sortOrder));
+    renumber();
+    endResetModel();
+}
+
+
+void ClassTableModel::addColumns(const qmf::Data& object)
+{
+    const qpid::types::Variant::Map& props(object.getProperties());
+    std::vector<std::string> added;
+    int addedColumns(0);
+
+    for (qpid::types::Variant::Map::const_iterator iter = props.begin(); iter != props.end(); iter++)
+        if (columnsByName.find(iter->first) == columnsByName.end()) {
+            added.push_back(iter->first);
+            addedColumns += (rateEngine && rateEngine->isCounter(iter->first)) ? 2 : 1;
+        }
+
+    if (added.empty())
+        return;
+
+    //
+    // New properties are appended as columns so existing column numbers stay valid.
+    //
+    int first((int) columns.size() + 1);
+    beginInsertColumns(QModelIndex(), first, first + addedColumns - 1);
+    for (std::vector<std::string>::const_iterator iter = added.begin(); iter != added.end(); iter++)
+        addColumn(*iter);
+    endInsertColumns();
+}
+
+
+void ClassTableModel::insertRow(const std::string& key, const qmf::Data& object)
+{
+    ClassRowPtr ptr(new ClassRow());
+    ptr->text = key;
+    ptr->object = object;
+
+    //
+    // Keep the sorted order by placing the new row with a binary search rather
+    // than re-sorting the whole table.
+    //
+    RowList::iterator iter(rows.end());
+    if (sortColumn >= 0)
+        iter = std::upper_bound(rows.begin(), rows.end(), ptr, RowLess(this, sortColumn, sortOrder));
+    int row(iter - rows.begin());
+
+    beginInsertRows(QModelIndex(), row, row);
+    rows.insert(iter, ptr);
+    rowsByKey[key] = ptr;
+    renumber(row);
+    endInsertRows();
+}
+
+
+void ClassTableModel::updateRow(const ClassRowPtr& ptr, const qmf::Data& object)
+{
+    const qpid::types::Variant::Map& oldProps(ptr->object.getProperties());
+    const qpid::types::Variant::Map& newProps(object.getProperties());
+    int firstChanged(-1);
+    int lastChanged(-1);
+
+    //
+    // Find the range of columns whose values actually changed so only those
+    // cells are repainted.
+    //
+    for (qpid::types::Variant::Map::const_iterator iter = newProps.begin(); iter != newProps.end(); iter++) {
+        int column(columnsByName[iter->first]);
+        int last(column);
+        bool derived(column < (int) columns.size() && columns[column].derived);
+
+        //
+        // A counter's rate column can change even when the raw value does not
+        // (a busy queue going idle).
+        //
+        qpid::types::Variant::Map::const_iterator old(oldProps.find(iter->first));
+        bool rawChanged(old == oldProps.end() || !(old->second == iter->second));
+        bool rateChanged(derived && rateEngine->rateChanged(package + "/" + schema + "/" + ptr->text, iter->first));
+        if (!rawChanged && !rateChanged)
+            continue;
+        if (!rawChanged)
+            column++;
+        if (derived)
+            last++;
+
+        if (firstChanged < 0 || column < firstChanged)
+            firstChanged = column;
+        if (last > lastChanged)
+            lastChanged = last;
+    }
+
+    ptr->object = object;
+    if (firstChanged < 0)
+        return;
+
+    emit dataChanged(createIndex(ptr->row, firstChanged), createIndex(ptr->row, lastChanged));
+
+    //
+    // If the sort column changed, move just this row to its new position.
+    //
+    if (sortColumn >= firstChanged && sortColumn <= lastChanged) {
+        RowList::iterator iter(rows.begin() + ptr->row);
+        RowLess less(this, sortColumn, sortOrder);
+        bool inPlace((iter == rows.begin() || !less(ptr, *(iter - 1))) &&
+                     (iter + 1 == rows.end() || !less(*(iter + 1), ptr)));
+        if (inPlace)
+            return;
+
+        int from(ptr->row);
+        rows.erase(iter);
+        int to(std::upper_bound(rows.begin(), rows.end(), ptr, less) - rows.begin());
+        rows.insert(rows.begin() + from, ptr);
+
+        //
+        // beginMoveRows takes the destination as the row before which the row is
+        // placed in the original numbering.
+        //
+        int dest(to > from ? to + 1 : to);
+        if (dest == from || dest == from + 1)
+            return;
+        if (!beginMoveRows(QModelIndex(), from, from, QModelIndex(), dest))
+            return;
+        rows.erase(rows.begin() + from);
+        rows.insert(rows.begin() + to, ptr);
+        renumber(std::min(from, to));
+        endMoveRows();
+    }
+}
+
+
+void ClassTableModel::addObject(const qmf::Data& object)
+{
+    QE_TRACE_SCOPE("ClassTableModel::addObject");
+    ExplorerStats::ScopedTimer timer(ExplorerStats::HIST_CLASS_INSERT);
+    if (!object.hasAddr() || schema.empty())
+        return;
+
+    const qmf::SchemaId& schemaId(object.getSchemaId());
+    if (schemaId.getName() != schema || schemaId.getPackageName() != package)
+        return;
+
+    const qmf::DataAddr& addr(object.getAddr());
+    std::string key(addr.getAgentName() + ":" + addr.getName());
+
+    addColumns(object);
+
+    RowMap::iterator iter(rowsByKey.find(key));
+    if (iter == rowsByKey.end())
+        insertRow(key, object);
+    else
+        updateRow(iter->second, object);
+}
+
+
+void ClassTableModel::delObject(const qmf::Data& object)
+{
+    if (!object.hasAddr() || schema.empty())
+        return;
+
+    const qmf::SchemaId& schemaId(object.getSchemaId());
+    if (schemaId.getName() != schema || schemaId.getPackageName() != package)
+        return;
+
+    const qmf::DataAddr& addr(object.getAddr());
+    RowMap::iterator iter(rowsByKey.find(addr.getAgentName() + ":" + addr.getName()));
+    if (iter == rowsByKey.end())
+        return;
+
+    int row(iter->second->row);
+    beginRemoveRows(QModelIndex(), row, row);
+    rows.erase(rows.begin() + row);
+    rowsByKey.erase(iter);
+    renumber(row);
+    endRemoveRows();
+}
+
+
+void ClassTableModel::clear()
+{
+    beginResetModel();
+    package.clear();
+    schema.clear();
+    rows.clear();
+    rowsByKey.clear();
+    columns.clear();
+    columnsByName.clear();
+    endResetModel();
+}
+
+
+void ClassTableModel::selected(const QModelIndex& index)
+{
+    if (!index.isValid() || index.row() >= (int) rows.size())
+        return;
+    emit instSelected(rows[index.row()]->object);
+}
+
+
+qmf::Data ClassTableModel::objectAt(const QModelIndex& index) const
+{
+    if (!index.isValid() || index.row() >= (int) rows.size())
+        return qmf::Data();
+    return rows[index.row()]->object;
+}
+
+
+void ClassTableModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column > (int) columns.size())
+        return;
+
+    sortColumn = column;
+    sortOrder = order;
+
+    emit layoutAboutToBeChanged();
+    QModelIndexList oldList(persistentIndexList());
+    std::vector<ClassRowPtr> persistentRows;
+    for (QModelIndexList::const_iterator iter = oldList.begin(); iter != oldList.end(); iter++)
+        persistentRows.push_back(rows[iter->row()]);
+
+    std::stable_sort(rows.begin(), rows.end(), RowLess(this, sortColumn, sortOrder));
+    renumber();
+
+    QModelIndexList newList;
+    for (int idx = 0; idx < oldList.size(); idx++)
+        newList << createIndex(persistentRows[idx]->row, oldList.at(idx).column());
+    changePersistentIndexList(oldList, newList);
+    emit layoutChanged();
+}
+
+
+int ClassTableModel::rowCount(const QModelIndex &parent) const
+{
+    //
+    // If the parent is invalid (top-level), return the number of instances.
+    //
+    if (!parent.isValid())
+        return (int) rows.size();
+
+    //
+    // This is not a tree so there are not child rows.
+    //
+    return 0;
+}
+
+
+int ClassTableModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return (int) columns.size() + 1;
+}
+
+
+QVariant ClassTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= (int) rows.size())
+        return QVariant();
+
+    const ClassRowPtr& ptr(rows[index.row()]);
+
+    if (index.column() == 0) {
+        if (role == Qt::DisplayRole || role == Qt::UserRole)
+            return QString(ptr->text.c_str());
+        return QVariant();
+    }
+
+    if (columns[index.column() - 1].derived) {
+        double perSecond;
+        if (role == Qt::TextAlignmentRole)
+            return (int) (Qt::AlignRight | Qt::AlignVCenter);
+        if ((role != Qt::DisplayRole && role != Qt::UserRole) || !cellRate(ptr, index.column(), perSecond))
+            return QVariant();
+        if (role == Qt::UserRole)
+            return perSecond;
+        return QString::number(perSecond, 'f', 1);
+    }
+
+    const qpid::types::Variant& value(cellValue(ptr, index.column()));
+
+    switch (role) {
+    case Qt::DisplayRole:
+        if (value.isVoid())
+            return QVariant();
+        return QString(value.asString().c_str());
+    case Qt::UserRole:
+        return QmfVariant::toQVariant(value);
+    case Qt::TextAlignmentRole:
+        if (QmfVariant::isNumeric(value))
+            return (int) (Qt::AlignRight | Qt::AlignVCenter);
+        break;
+    }
+
+    return QVariant();
+}
+
+
+QVariant ClassTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        if (section == 0)
+            return QString("Object");
+        if (section <= (int) columns.size()) {
+            const Column& column(columns[section - 1]);
+            if (column.derived)
+                return QString(column.property.c_str()) + "/s";
+            return QString(column.property.c_str());
+        }
+    }
+
+    return QVariant();
+}
+
+
+QModelIndex ClassTableModel::parent(const QModelIndex& index) const
+{
+    QModelIndex i = index;
+    //
+    // Not a tree structure, no parents.
+    //
+    return QModelIndex();
+}
+
+
+QModelIndex ClassTableModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return createIndex(row, column);
+
+    return QModelIndex();
+}
+
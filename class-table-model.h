@@ -0,0 +1,110 @@
+#ifndef _qe_class_table_model_h
+#define _qe_class_table_model_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QAbstractItemModel>
+#include <QModelIndex>
+#include <QStringList>
+#include <qmf/Data.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <boost/shared_ptr.hpp>
+
+class ObjectModel;
+class RateEngine;
+
+//
+// Table of every instance of one schema class.  Each object is a row and each
+// property is a column.  Cell contents are produced on demand from the stored
+// qmf::Data so the model holds nothing per cell; the views only ever ask for
+// the rows and columns that are visible.  Counter properties are followed by
+// a derived per-second rate column.
+//
+class ClassTableModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    ClassTableModel(ObjectModel* objects, RateEngine* rates, QObject* parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    QModelIndex parent(const QModelIndex& index) const;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+    qmf::Data objectAt(const QModelIndex&) const;
+
+public slots:
+    void selectClass(const QString&, const QString&);
+    void addObject(const qmf::Data&);
+    void delObject(const qmf::Data&);
+    void clear();
+    void selected(const QModelIndex&);
+
+signals:
+    void instSelected(const qmf::Data&);
+
+private:
+    struct ClassRow;
+    typedef boost::shared_ptr<ClassRow> ClassRowPtr;
+    typedef std::vector<ClassRowPtr> RowList;
+    typedef std::map<std::string, ClassRowPtr> RowMap;
+    typedef std::map<std::string, int> ColumnMap;
+
+    struct Column {
+        std::string property;
+        bool derived;
+    };
+    typedef std::vector<Column> ColumnList;
+
+    struct ClassRow {
+        int row;
+        std::string text;
+        qmf::Data object;
+    };
+
+    class RowLess;
+
+    ObjectModel* objectModel;
+    RateEngine* rateEngine;
+    std::string package;
+    std::string schema;
+    RowList rows;
+    RowMap rowsByKey;
+    ColumnList columns;
+    ColumnMap columnsByName;
+    int sortColumn;
+    Qt::SortOrder sortOrder;
+
+    void renumber(int first = 0);
+    void addColumn(const std::string&);
+    void addColumns(const qmf::Data&);
+    void insertRow(const std::string&, const qmf::Data&);
+    void updateRow(const ClassRowPtr&, const qmf::Data&);
+    const qpid::types::Variant& cellValue(const ClassRowPtr&, int column) const;
+    bool cellRate(const ClassRowPtr&, int column, double&) const;
+    int compareCells(const ClassRowPtr&, const ClassRowPtr&, int column) const;
+};
+
+#endif
+
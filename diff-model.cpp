@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "diff-model.h"
+#include <QColor>
+
+DiffModel::DiffModel(QObject* parent) : QAbstractItemModel(parent)
+{
+    // Intentionally Left Blank
+}
+
+
+void DiffModel::setChanges(SnapshotDiff::ChangeList& list)
+{
+    beginResetModel();
+    changes.swap(list);
+    list.clear();
+    endResetModel();
+}
+
+
+std::string DiffModel::keyAt(const QModelIndex& index) const
+{
+    if (!index.isValid() || index.row() >= (int) changes.size())
+        return std::string();
+    return changes[index.row()].key;
+}
+
+
+void DiffModel::clear()
+{
+    beginResetModel();
+    SnapshotDiff::ChangeList().swap(changes);
+    endResetModel();
+}
+
+
+int DiffModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return (int) changes.size();
+    return 0;
+}
+
+
+int DiffModel::columnCount(const QModelIndex &parent) const
+{
+    return 5;
+}
+
+
+QVariant DiffModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const SnapshotDiff::Change& change(changes[index.row()]);
+
+    if (role == Qt::ForegroundRole && index.column() == 0) {
+        switch (change.type) {
+        case SnapshotDiff::ADDED:   return QColor(Qt::darkGreen);
+        case SnapshotDiff::REMOVED: return QColor(Qt::red);
+        case SnapshotDiff::CHANGED: break;
+        }
+        return QVariant();
+    }
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (index.column()) {
+    case 0:
+        switch (change.type) {
+        case SnapshotDiff::ADDED:   return QString("Added");
+        case SnapshotDiff::REMOVED: return QString("Removed");
+        case SnapshotDiff::CHANGED: return QString("Changed");
+        }
+        break;
+    case 1: return QString::fromUtf8(change.key.c_str());
+    case 2: return QString::fromUtf8(change.property.c_str());
+    case 3: return QString::fromUtf8(change.before.c_str());
+    case 4: return QString::fromUtf8(change.after.c_str());
+    }
+    return QVariant();
+}
+
+
+QVariant DiffModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
+    switch (section) {
+    case 0: return QString("Change");
+    case 1: return QString("Object");
+    case 2: return QString("Property");
+    case 3: return QString("Before");
+    case 4: return QString("After");
+    }
+
+    return QVariant();
+}
+
+
+QModelIndex DiffModel::parent(const QModelIndex& index) const
+{
+    //
+    // Not a tree structure, no parents.
+    //
+    return QModelIndex();
+}
+
+
+QModelIndex DiffModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return createIndex(row, column);
+
+    return QModelIndex();
+}
+
@@ -0,0 +1,57 @@
+#ifndef _qe_diff_model_h
+#define _qe_diff_model_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QAbstractItemModel>
+#include <QModelIndex>
+#include "snapshot-diff.h"
+
+//
+// The result of a SnapshotDiff, one row per added or removed object and one per
+// changed property, in object-key order.
+//
+class DiffModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    DiffModel(QObject* parent = 0);
+
+    //
+    // Take over the changes, leaving the list empty.
+    //
+    void setChanges(SnapshotDiff::ChangeList&);
+    std::string keyAt(const QModelIndex&) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    QModelIndex parent(const QModelIndex& index) const;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+
+public slots:
+    void clear();
+
+private:
+    SnapshotDiff::ChangeList changes;
+};
+
+#endif
+
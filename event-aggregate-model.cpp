@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "event-aggregate-model.h"
+#include "event-detail-model.h"
+#include "trace.h"
+#include <qmf/Data.h>
+#include <qmf/SchemaId.h>
+#include <QDateTime>
+
+EventAggregateModel::EventAggregateModel(QObject* parent) : QAbstractItemModel(parent), bucketNanos(0)
+{
+    // Intentionally Left Blank
+}
+
+
+void EventAggregateModel::setGrouping(const QString& property, int bucketSeconds)
+{
+    std::string newKey(property.trimmed().toStdString());
+    qint64 newBucket(bucketSeconds > 0 ? (qint64) bucketSeconds * 1000000000 : 0);
+    if (newKey == keyProperty && newBucket == bucketNanos)
+        return;
+
+    beginResetModel();
+    groups.clear();
+    rowsByGroup.clear();
+    keyProperty = newKey;
+    bucketNanos = newBucket;
+    endResetModel();
+}
+
+
+void EventAggregateModel::newEvent(const qmf::ConsoleEvent& event)
+{
+    QE_TRACE_SCOPE("EventAggregateModel::newEvent");
+    uint32_t pcount(event.getDataCount());
+    qint64 timestamp((qint64) event.getTimestamp());
+    int severity((int) event.getSeverity());
+
+    for (uint32_t idx = 0; idx < pcount; idx++) {
+        qmf::Data data(event.getData(idx));
+        const qmf::SchemaId& schemaId(data.getSchemaId());
+        QString name((schemaId.getPackageName() + ":" + schemaId.getName()).c_str());
+
+        QString key;
+        if (!keyProperty.empty()) {
+            const qpid::types::Variant::Map& props(data.getProperties());
+            qpid::types::Variant::Map::const_iterator iter(props.find(keyProperty));
+            if (iter != props.end())
+                key = QString(iter->second.asString().c_str());
+        }
+
+        //
+        // The group's identity; the separator cannot occur in the parts.
+        //
+        QString group(name);
+        group += QChar(0x1f);
+        group += QString::number(severity);
+        group += QChar(0x1f);
+        group += key;
+        if (bucketNanos > 0) {
+            group += QChar(0x1f);
+            group += QString::number(timestamp / bucketNanos);
+        }
+
+        QHash<QString, int>::const_iterator found(rowsByGroup.find(group));
+        if (found != rowsByGroup.end()) {
+            Group& existing(groups[found.value()]);
+            existing.count++;
+            existing.firstSeen = qMin(existing.firstSeen, timestamp);
+            existing.lastSeen = qMax(existing.lastSeen, timestamp);
+            emit dataChanged(createIndex(found.value(), 3), createIndex(found.value(), 5));
+            continue;
+        }
+
+        Group added;
+        added.name = name;
+        added.severity = severity;
+        added.key = key;
+        added.count = 1;
+        added.firstSeen = timestamp;
+        added.lastSeen = timestamp;
+
+        beginInsertRows(QModelIndex(), groups.size(), groups.size());
+        rowsByGroup[group] = groups.size();
+        groups.append(added);
+        endInsertRows();
+    }
+}
+
+
+size_t EventAggregateModel::memoryUsage() const
+{
+    //
+    // An estimate: each group, its two strings and its hash entry, whose key is
+    // about as long as the strings together.
+    //
+    size_t total(groups.capacity() * sizeof(Group));
+    for (QVector<Group>::const_iterator iter = groups.begin(); iter != groups.end(); iter++)
+        total += (iter->name.capacity() + iter->key.capacity()) * 2 * sizeof(QChar) + 3 * 24 + 32;
+    return total;
+}
+
+
+void EventAggregateModel::clear()
+{
+    beginResetModel();
+    groups.clear();
+    rowsByGroup.clear();
+    endResetModel();
+}
+
+
+int EventAggregateModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return groups.size();
+    return 0;
+}
+
+
+int EventAggregateModel::columnCount(const QModelIndex &parent) const
+{
+    return 6;
+}
+
+
+QVariant EventAggregateModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const Group& group(groups.at(index.row()));
+
+    //
+    // The user role carries the raw value of typed columns for sorting.
+    //
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+        case 0: return group.name;
+        case 1: return group.severity;
+        case 2: return group.key;
+        case 3: return group.count;
+        case 4: return group.firstSeen;
+        case 5: return group.lastSeen;
+        }
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole && index.column() == 3)
+        return (int) (Qt::AlignRight | Qt::AlignVCenter);
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (index.column()) {
+    case 0: return group.name;
+    case 1: return EventDetailModel::severityName(group.severity);
+    case 2: return group.key;
+    case 3: return group.count;
+    case 4: return QDateTime::fromMSecsSinceEpoch(group.firstSeen / 1000000).toString();
+    case 5: return QDateTime::fromMSecsSinceEpoch(group.lastSeen / 1000000).toString();
+    }
+    return QVariant();
+}
+
+
+QVariant EventAggregateModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
+    switch (section) {
+    case 0: return QString("Name");
+    case 1: return QString("Severity");
+    case 2: return keyProperty.empty() ? QString("Key") : QString(keyProperty.c_str());
+    case 3: return QString("Count");
+    case 4: return QString("First Seen");
+    case 5: return QString("Last Seen");
+    }
+
+    return QVariant();
+}
+
+
+QModelIndex EventAggregateModel::parent(const QModelIndex& index) const
+{
+    //
+    // Not a tree structure, no parents.
+    //
+    return QModelIndex();
+}
+
+
+QModelIndex EventAggregateModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return createIndex(row, column);
+
+    return QModelIndex();
+}
+
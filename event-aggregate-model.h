@@ -0,0 +1,77 @@
+#ifndef _qe_event_aggregate_model_h
+#define _qe_event_aggregate_model_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QAbstractItemModel>
+#include <QModelIndex>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <qmf/ConsoleEvent.h>
+
+//
+// Events grouped by package:class, severity, the value of a chosen key property
+// and a time bucket, one row per group with its count and first and last times.
+// Groups are found by hash as events arrive, so a burst of identical events
+// updates one row instead of adding thousands.
+//
+class EventAggregateModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    EventAggregateModel(QObject* parent = 0);
+
+    //
+    // Change what events are grouped by.  An empty key property groups on class
+    // and severity alone; a bucket of zero seconds does not split by time.
+    // Existing groups are discarded.
+    //
+    void setGrouping(const QString& keyProperty, int bucketSeconds);
+    size_t memoryUsage() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    QModelIndex parent(const QModelIndex& index) const;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+
+public slots:
+    void newEvent(const qmf::ConsoleEvent&);
+    void clear();
+
+private:
+    struct Group {
+        QString name;
+        int severity;
+        QString key;
+        quint64 count;
+        qint64 firstSeen;
+        qint64 lastSeen;
+    };
+
+    std::string keyProperty;
+    qint64 bucketNanos;
+    QVector<Group> groups;
+    QHash<QString, int> rowsByGroup;
+};
+
+#endif
+
@@ -18,6 +18,8 @@
  */
 
 #include "event-detail-model.h"
+#include "explorer-stats.h"
+#include "trace.h"
 #include <iostream>
 #include <sstream>
 #include <QDateTime>
@@ -26,18 +28,40 @@
 using std::cout;
 using std::endl;
 
-EventDetailModel::EventDetailModel(QObject *parent) : QAbstractItemModel(parent)
+EventDetailModel::EventDetailModel(QObject *parent) : QAbstractItemModel(parent), reversed(true), nextSequence(1)
 {
     // Intentionally Left Blank
 }
 
+QString EventDetailModel::severityName(int severity)
+{
+    switch (severity) {
+    case qmf::SEV_EMERG  : return "EMERG";
+    case qmf::SEV_ALERT  : return "ALERT";
+    case qmf::SEV_CRIT   : return "CRITICAL";
+    case qmf::SEV_ERROR  : return "ERROR";
+    case qmf::SEV_WARN   : return "WARN";
+    case qmf::SEV_NOTICE : return "NOTICE";
+    case qmf::SEV_INFORM : return "INFO";
+    }
+    return QString();
+}
+
 void EventDetailModel::newEvent(const qmf::ConsoleEvent& event)
 {
+    QE_TRACE_SCOPE("EventDetailModel::newEvent");
+    ExplorerStats::ScopedTimer timer(ExplorerStats::HIST_EVENT_INSERT);
     uint32_t pcount = event.getDataCount();
     if (pcount < 1)
         return;
 
-    beginInsertRows(QModelIndex(), 0, pcount - 1);
+    //
+    // The rows are always appended to storage.  The notification names the rows
+    // where they appear, the top or the bottom depending on the order shown, so
+    // views and proxies only place the new rows.
+    //
+    int first(reversed ? 0 : sequences.size());
+    beginInsertRows(QModelIndex(), first, first + pcount - 1);
     // each data in event is a new row
     for (uint32_t idx = 0; idx < pcount; idx++) {
         qmf::Data d = event.getData(idx);
@@ -47,19 +71,10 @@ void EventDetailModel::newEvent(const qmf::ConsoleEvent& event)
         // event.timestamp is in nano seconds, we need to convert to seconds
         time_t ts = (time_t) event.getTimestamp() / 1000000000;
         timeStamps << QString(ctime(&ts));
+        rawTimeStamps << (qint64) event.getTimestamp();
+        rawSeverities << (int) event.getSeverity();
 
-        QString sevName;
-        switch (event.getSeverity()) {
-        case qmf::SEV_EMERG  : sevName = "EMERG";    break;
-        case qmf::SEV_ALERT  : sevName = "ALERT";    break;
-        case qmf::SEV_CRIT   : sevName = "CRITICAL"; break;
-        case qmf::SEV_ERROR  : sevName = "ERROR";    break;
-        case qmf::SEV_WARN   : sevName = "WARN";     break;
-        case qmf::SEV_NOTICE : sevName = "NOTICE";   break;
-        case qmf::SEV_INFORM : sevName = "INFO";     break;
-        }
-
-        severities << sevName;
+        severities << severityName(event.getSeverity());
         QString name(d.getSchemaId().getPackageName().c_str());
         name += ":";
         name += d.getSchemaId().getName().c_str();
@@ -80,14 +95,57 @@ void EventDetailModel::newEvent(const qmf::ConsoleEvent& event)
             prop += QString(iter->second.asString().c_str());
         }
         properties << prop;
+        sequences << nextSequence++;
     }
+
+    //
+    // Relay the text of the new rows for searching.  This is done before the
+    // insert completes so an active search can accept the rows as they are placed;
+    // receivers must not read the model here.
+    //
+    for (int row = sequences.size() - pcount; row < sequences.size(); row++)
+        emit eventAdded(sequences.at(row), names.at(row) + " " + severities.at(row) + " " + properties.at(row));
     endInsertRows();
 }
 
 
+size_t EventDetailModel::memoryUsage() const
+{
+    size_t total((sizeof(quint64) * 2 + sizeof(int)) * sequences.size());
+    for (int row = 0; row < sequences.size(); row++)
+        total += (timeStamps.at(row).capacity() + severities.at(row).capacity() +
+                  names.at(row).capacity() + properties.at(row).capacity()) * sizeof(QChar) + 4 * 24;
+    return total;
+}
+
+
+void EventDetailModel::setNewestFirst(bool newest)
+{
+    if (newest == reversed)
+        return;
+
+    //
+    // Persistent indexes follow their rows to the mirrored positions.
+    //
+    emit layoutAboutToBeChanged();
+    QModelIndexList before(persistentIndexList());
+    QModelIndexList after;
+    for (QModelIndexList::const_iterator iter = before.begin(); iter != before.end(); iter++)
+        after << createIndex(sequences.size() - 1 - iter->row(), iter->column());
+    reversed = newest;
+    changePersistentIndexList(before, after);
+    emit layoutChanged();
+}
+
+
 void EventDetailModel::clear()
 {
+    if (sequences.isEmpty())
+        return;
     beginRemoveRows(QModelIndex(), 0, timeStamps.size() - 1);
+    sequences.clear();
+    rawTimeStamps.clear();
+    rawSeverities.clear();
     timeStamps.clear();
     severities.clear();
     names.clear();
@@ -119,18 +177,39 @@ int EventDetailModel::columnCount(const QModelIndex &parent) const
 
 QVariant EventDetailModel::data(const QModelIndex &index, int role) const
 {
-    if (role != Qt::DisplayRole)
+    if (!index.isValid())
         return QVariant();
 
-    if (!index.isValid())
+    int row(storageRow(index.row()));
+    if (row < 0 || row >= sequences.size())
+        return QVariant();
+
+    if (role == SequenceRole)
+        return sequences.at(row);
+
+    //
+    // The user role carries the raw value of typed columns for sorting.
+    //
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+        case 0: return rawTimeStamps.at(row);
+        case 1: return rawSeverities.at(row);
+        case 2: return names.at(row);
+        case 3: return properties.at(row);
+        }
+        return QVariant();
+    }
+
+    if (role != Qt::DisplayRole)
         return QVariant();
 
     switch (index.column()) {
-    case 0: return timeStamps.at(index.row());
-    case 1: return severities.at(index.row());
-    case 2: return names.at(index.row());
-    case 3: return properties.at(index.row());
+    case 0: return timeStamps.at(row);
+    case 1: return severities.at(row);
+    case 2: return names.at(row);
+    case 3: return properties.at(row);
     }
+    return QVariant();
 }
 
 
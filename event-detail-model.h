@@ -38,6 +38,17 @@ class EventDetailModel : public QAbstractItemModel
 public:
     explicit EventDetailModel(QObject *parent = 0);
 
+    //
+    // Role carrying the sequence number assigned to each row when it arrived.
+    //
+    enum { SequenceRole = Qt::UserRole + 1 };
+
+    static QString severityName(int);
+
+    size_t memoryUsage() const;
+
+    bool newestFirst() const { return reversed; }
+
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
@@ -49,12 +60,27 @@ public slots:
     void newEvent(const qmf::ConsoleEvent&);
     void clear();
 
+    //
+    // Rows are stored in arrival order.  Newest-first presents them reversed, so
+    // new events are inserted at the top rather than appended at the bottom.
+    //
+    void setNewestFirst(bool);
+
+signals:
+    void eventAdded(quint64, const QString&);
+
 private:
+    bool reversed;
+    quint64 nextSequence;
+    QList<quint64> sequences;
+    QList<qint64> rawTimeStamps;
+    QList<int> rawSeverities;
     QStringList timeStamps;
     QStringList severities;
     QStringList names;
     QStringList properties;
 
+    int storageRow(int row) const { return reversed ? sequences.size() - 1 - row : row; }
 };
 
 #endif // EVENTDETAILMODEL_H
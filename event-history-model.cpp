@@ -0,0 +1,174 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "event-history-model.h"
+#include "event-detail-model.h"
+#include <QDateTime>
+
+namespace {
+    //
+    // Events read from the journal per fetch.
+    //
+    const int PAGE_SIZE = 500;
+}
+
+
+EventHistoryModel::EventHistoryModel(const EventJournal* j, QObject* parent) :
+    QAbstractItemModel(parent), journal(j), exhausted(true)
+{
+    // Intentionally Left Blank
+}
+
+
+void EventHistoryModel::setQuery(const EventJournal::Query& q)
+{
+    clear();
+    query = q;
+    cursor = EventJournal::Cursor();
+    exhausted = !journal;
+    fetchMore(QModelIndex());
+}
+
+
+void EventHistoryModel::clear()
+{
+    beginResetModel();
+    rawTimeStamps.clear();
+    rawSeverities.clear();
+    timeStamps.clear();
+    severities.clear();
+    names.clear();
+    properties.clear();
+    exhausted = true;
+    endResetModel();
+}
+
+
+bool EventHistoryModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && !exhausted;
+}
+
+
+void EventHistoryModel::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    std::vector<EventJournal::Record> records;
+    exhausted = !journal->read(query, cursor, PAGE_SIZE, records);
+    if (records.empty())
+        return;
+
+    beginInsertRows(QModelIndex(), timeStamps.size(), timeStamps.size() + records.size() - 1);
+    for (std::vector<EventJournal::Record>::const_iterator iter = records.begin(); iter != records.end(); iter++) {
+        rawTimeStamps << iter->timestamp;
+        rawSeverities << iter->severity;
+        timeStamps << QDateTime::fromMSecsSinceEpoch(iter->timestamp / 1000000).toString();
+        severities << EventDetailModel::severityName(iter->severity);
+        names << QString((iter->package + ":" + iter->cls).c_str());
+
+        QString prop;
+        for (qpid::types::Variant::Map::const_iterator piter = iter->properties.begin();
+             piter != iter->properties.end(); piter++) {
+            if (piter != iter->properties.begin())
+                prop += QString(", ");
+            prop += QString(piter->first.c_str());
+            prop += QString("=");
+            prop += QString(piter->second.asString().c_str());
+        }
+        properties << prop;
+    }
+    endInsertRows();
+}
+
+
+int EventHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return timeStamps.size();
+    return 0;
+}
+
+
+int EventHistoryModel::columnCount(const QModelIndex &parent) const
+{
+    return 4;
+}
+
+
+QVariant EventHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+        case 0: return rawTimeStamps.at(index.row());
+        case 1: return rawSeverities.at(index.row());
+        case 2: return names.at(index.row());
+        case 3: return properties.at(index.row());
+        }
+        return QVariant();
+    }
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (index.column()) {
+    case 0: return timeStamps.at(index.row());
+    case 1: return severities.at(index.row());
+    case 2: return names.at(index.row());
+    case 3: return properties.at(index.row());
+    }
+    return QVariant();
+}
+
+
+QVariant EventHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
+    switch (section) {
+    case 0: return QString("Time Stamp");
+    case 1: return QString("Severity");
+    case 2: return QString("Name");
+    case 3: return QString("Properties");
+    }
+
+    return QVariant();
+}
+
+
+QModelIndex EventHistoryModel::parent(const QModelIndex& index) const
+{
+    //
+    // Not a tree structure, no parents.
+    //
+    return QModelIndex();
+}
+
+
+QModelIndex EventHistoryModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return createIndex(row, column);
+
+    return QModelIndex();
+}
+
@@ -0,0 +1,67 @@
+#ifndef _qe_event_history_model_h
+#define _qe_event_history_model_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QAbstractItemModel>
+#include <QModelIndex>
+#include <QStringList>
+#include "event-journal.h"
+
+//
+// Events read back from the journal for a query, in the order they arrived.
+// Rows are read a page at a time as the view scrolls, through
+// canFetchMore/fetchMore.
+//
+class EventHistoryModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    EventHistoryModel(const EventJournal*, QObject* parent = 0);
+
+    void setQuery(const EventJournal::Query&);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    QModelIndex parent(const QModelIndex& index) const;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+public slots:
+    void clear();
+
+private:
+    const EventJournal* journal;
+    EventJournal::Query query;
+    EventJournal::Cursor cursor;
+    bool exhausted;
+
+    QList<qint64> rawTimeStamps;
+    QList<int> rawSeverities;
+    QStringList timeStamps;
+    QStringList severities;
+    QStringList names;
+    QStringList properties;
+};
+
+#endif
+
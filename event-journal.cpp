@@ -0,0 +1,525 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "event-journal.h"
+#include "qmf-thread.h"
+#include "json-writer.h"
+#include "json-reader.h"
+#include "trace.h"
+#include <qmf/Data.h>
+#include <qmf/Agent.h>
+#include <qmf/SchemaId.h>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QDateTime>
+#include <QStringList>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <limits>
+
+using qpid::types::Variant;
+
+namespace {
+    //
+    // A segment is closed once its log grows past this size.
+    //
+    const qint64 SEGMENT_BYTES = 64 << 20;
+
+    //
+    // Segments whose newest event is older than this are deleted.
+    //
+    const int DEFAULT_RETENTION_DAYS = 28;
+
+    //
+    // Index entry layout: time (ms), log offset, class hash, severity, padding.
+    //
+    const int ENTRY_SIZE = 24;
+
+    //
+    // Index entries read per file access when scanning a segment.
+    //
+    const int SCAN_CHUNK = 4096;
+
+    struct IndexEntry {
+        qint64 time;
+        qint64 offset;
+        quint32 classHash;
+        quint8 severity;
+    };
+
+    void packEntry(const IndexEntry& entry, char* out)
+    {
+        std::memset(out, 0, ENTRY_SIZE);
+        std::memcpy(out, &entry.time, 8);
+        std::memcpy(out + 8, &entry.offset, 8);
+        std::memcpy(out + 16, &entry.classHash, 4);
+        out[20] = (char) entry.severity;
+    }
+
+    void unpackEntry(const char* in, IndexEntry& entry)
+    {
+        std::memcpy(&entry.time, in, 8);
+        std::memcpy(&entry.offset, in + 8, 8);
+        std::memcpy(&entry.classHash, in + 16, 4);
+        entry.severity = (quint8) in[20];
+    }
+
+    std::string stringField(const Variant::Map& map, const char* name)
+    {
+        Variant::Map::const_iterator iter(map.find(name));
+        if (iter == map.end() || iter->second.getType() != qpid::types::VAR_STRING)
+            return std::string();
+        return iter->second.asString();
+    }
+}
+
+
+EventJournal::EventJournal(const QString& d, QObject* parent) :
+    QThread(parent), directory(d), nextSegment(1), stopping(false)
+{
+    loadSegments();
+}
+
+
+EventJournal::~EventJournal()
+{
+    stop();
+    wait();
+}
+
+
+quint32 EventJournal::classHash(const std::string& name)
+{
+    //
+    // FNV-1a.  Zero is kept free to mean "any class".
+    //
+    quint32 hash(2166136261u);
+    for (std::string::const_iterator iter = name.begin(); iter != name.end(); iter++) {
+        hash ^= (unsigned char) *iter;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+
+void EventJournal::loadSegments()
+{
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        fail("Event journal disabled: cannot create " + directory);
+        return;
+    }
+
+    //
+    // Segment numbers are zero-padded, so name order is creation order.
+    //
+    QStringList names(dir.entryList(QStringList() << "events-*.log", QDir::Files, QDir::Name));
+    for (QStringList::const_iterator iter = names.begin(); iter != names.end(); iter++) {
+        Segment segment;
+        segment.number = iter->mid(7, iter->length() - 11).toInt();
+        segment.base = dir.filePath(iter->left(iter->length() - 4));
+        if (!loadSummary(segment)) {
+            //
+            // The segment was not closed cleanly; its index is still complete up
+            // to the last batch written.
+            //
+            rebuildSummary(segment);
+            writeSummary(segment);
+        }
+        segments.push_back(segment);
+        if (segment.number >= nextSegment)
+            nextSegment = segment.number + 1;
+    }
+}
+
+
+bool EventJournal::loadSummary(Segment& segment)
+{
+    std::ifstream in(QString(segment.base + ".sum").toLocal8Bit().constData());
+    if (!in)
+        return false;
+    in >> segment.firstTime >> segment.lastTime >> segment.count >> segment.severities;
+    if (!in)
+        return false;
+    quint32 hash;
+    while (in >> hash)
+        segment.classes.insert(hash);
+    return true;
+}
+
+
+void EventJournal::rebuildSummary(Segment& segment)
+{
+    QFile file(segment.base + ".idx");
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    segment.count = 0;
+    segment.severities = 0;
+    segment.classes.clear();
+    QByteArray chunk;
+    while (!(chunk = file.read(SCAN_CHUNK * ENTRY_SIZE)).isEmpty()) {
+        for (int pos = 0; pos + ENTRY_SIZE <= chunk.size(); pos += ENTRY_SIZE) {
+            IndexEntry entry;
+            unpackEntry(chunk.constData() + pos, entry);
+            if (segment.count++ == 0)
+                segment.firstTime = segment.lastTime = entry.time;
+            segment.firstTime = qMin(segment.firstTime, entry.time);
+            segment.lastTime = qMax(segment.lastTime, entry.time);
+            segment.severities |= 1u << entry.severity;
+            segment.classes.insert(entry.classHash);
+        }
+    }
+}
+
+
+void EventJournal::writeSummary(const Segment& segment)
+{
+    std::ofstream out(QString(segment.base + ".sum").toLocal8Bit().constData());
+    out << segment.firstTime << ' ' << segment.lastTime << ' ' << segment.count << ' ' << segment.severities << '\n';
+    for (std::set<quint32>::const_iterator iter = segment.classes.begin(); iter != segment.classes.end(); iter++)
+        out << *iter << '\n';
+}
+
+
+void EventJournal::expireSegments(qint64 now)
+{
+    QSettings settings;
+    qint64 retention((qint64) settings.value("Events/retentionDays", DEFAULT_RETENTION_DAYS).toInt() * 86400000);
+    if (retention <= 0)
+        return;
+
+    QMutexLocker locker(&lock);
+    while (!segments.empty() && segments.front().lastTime < now - retention) {
+        const QString& base(segments.front().base);
+        QFile::remove(base + ".log");
+        QFile::remove(base + ".idx");
+        QFile::remove(base + ".sum");
+        segments.erase(segments.begin());
+    }
+}
+
+
+void EventJournal::fail(const QString& message)
+{
+    //
+    // Events already queued and any that follow are dropped.  The message is
+    // reported as the thread ends, since this may be called from the constructor
+    // before anything is connected.
+    //
+    QMutexLocker locker(&lock);
+    if (failure.isEmpty())
+        failure = message;
+    queue.clear();
+}
+
+
+bool EventJournal::openSegment(QFile& log, QFile& idx)
+{
+    expireSegments(QDateTime::currentMSecsSinceEpoch());
+
+    Segment segment;
+    segment.number = nextSegment++;
+    segment.base = QDir(directory).filePath(QString("events-%1").arg(segment.number, 8, 10, QChar('0')));
+
+    log.setFileName(segment.base + ".log");
+    idx.setFileName(segment.base + ".idx");
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append) || !idx.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        log.close();
+        idx.close();
+        fail("Event journal stopped: cannot open " + segment.base);
+        return false;
+    }
+
+    QMutexLocker locker(&lock);
+    segments.push_back(segment);
+    return true;
+}
+
+
+void EventJournal::closeSegment(QFile& log, QFile& idx)
+{
+    if (!log.isOpen())
+        return;
+    log.close();
+    idx.close();
+
+    Segment segment;
+    {
+        QMutexLocker locker(&lock);
+        segment = segments.back();
+    }
+    writeSummary(segment);
+}
+
+
+void EventJournal::newEvent(const qmf::ConsoleEvent& event)
+{
+    //
+    // Only the handle is queued here; the record is built and written on the
+    // journal thread.
+    //
+    Pending pending;
+    pending.broker = QmfThread::brokerName(sender());
+    if (pending.broker.empty())
+        return;
+    pending.event = event;
+
+    QMutexLocker locker(&lock);
+    if (!failure.isEmpty())
+        return;
+    queue.push_back(pending);
+    wake.wakeOne();
+}
+
+
+void EventJournal::stop()
+{
+    QMutexLocker locker(&lock);
+    stopping = true;
+    wake.wakeAll();
+}
+
+
+size_t EventJournal::segmentCount() const
+{
+    QMutexLocker locker(&lock);
+    return segments.size();
+}
+
+
+void EventJournal::run()
+{
+    QFile log;
+    QFile idx;
+
+    while (true) {
+        std::deque<Pending> batch;
+        {
+            QMutexLocker locker(&lock);
+            while (queue.empty() && !stopping && failure.isEmpty())
+                wake.wait(&lock);
+            if (queue.empty() || !failure.isEmpty())
+                break;
+            batch.swap(queue);
+        }
+
+        QE_TRACE_SCOPE("EventJournal::write");
+        if (log.isOpen() && log.size() >= SEGMENT_BYTES)
+            closeSegment(log, idx);
+        if (!log.isOpen() && !openSegment(log, idx))
+            break;
+
+        //
+        // The whole batch is formatted first and written with one call per file.
+        // The log is flushed before the index so an entry never points past the
+        // end of the log.
+        //
+        std::ostringstream text;
+        JsonWriter json(text);
+        std::string entries;
+        qint64 base(log.size());
+        Segment update;
+        {
+            QMutexLocker locker(&lock);
+            update = segments.back();
+        }
+
+        for (std::deque<Pending>::const_iterator iter = batch.begin(); iter != batch.end(); iter++) {
+            const qmf::ConsoleEvent& event(iter->event);
+            uint32_t pcount(event.getDataCount());
+            for (uint32_t item = 0; item < pcount; item++) {
+                qmf::Data data(event.getData(item));
+                const qmf::SchemaId& schemaId(data.getSchemaId());
+                std::string className(schemaId.getPackageName() + ":" + schemaId.getName());
+
+                IndexEntry entry;
+                entry.time = (qint64) (event.getTimestamp() / 1000000);
+                entry.offset = base + (qint64) text.tellp();
+                entry.classHash = classHash(className);
+                entry.severity = (quint8) qBound(0, (int) event.getSeverity(), 31);
+
+                json.beginObject();
+                json.field("timestamp", (qint64) event.getTimestamp());
+                json.field("severity", (qint64) entry.severity);
+                json.field("broker", iter->broker);
+                json.field("agent", event.getAgent().getName());
+                json.field("package", schemaId.getPackageName());
+                json.field("class", schemaId.getName());
+                json.field("properties", data.getProperties());
+                json.endObject();
+                json.endLine();
+
+                char packed[ENTRY_SIZE];
+                packEntry(entry, packed);
+                entries.append(packed, ENTRY_SIZE);
+
+                if (update.count++ == 0)
+                    update.firstTime = update.lastTime = entry.time;
+                update.firstTime = qMin(update.firstTime, entry.time);
+                update.lastTime = qMax(update.lastTime, entry.time);
+                update.severities |= 1u << entry.severity;
+                update.classes.insert(entry.classHash);
+            }
+        }
+
+        //
+        // A short write (a full disk, say) stops the journal.  The partial batch is
+        // cut off again so the segment stays readable up to the previous one.
+        //
+        std::string output(text.str());
+        qint64 idxBase(idx.size());
+        if (log.write(output.data(), output.size()) != (qint64) output.size() || !log.flush() ||
+            idx.write(entries.data(), entries.size()) != (qint64) entries.size() || !idx.flush()) {
+            log.resize(base);
+            idx.resize(idxBase);
+            fail("Event journal stopped: cannot write " + log.fileName());
+            break;
+        }
+
+        QMutexLocker locker(&lock);
+        segments.back() = update;
+    }
+
+    closeSegment(log, idx);
+
+    QString message;
+    {
+        QMutexLocker locker(&lock);
+        message = failure;
+    }
+    if (!message.isEmpty())
+        emit failed(message);
+}
+
+
+bool EventJournal::read(const Query& query, Cursor& cursor, int count, std::vector<Record>& records) const
+{
+    QE_TRACE_SCOPE("EventJournal::read");
+    std::vector<Segment> list;
+    {
+        QMutexLocker locker(&lock);
+        list = segments;
+    }
+
+    quint32 wantedClass(query.className.empty() ? 0 : classHash(query.className));
+    quint32 wantedSeverities(query.maxSeverity >= 31 ? ~0u : (1u << (query.maxSeverity + 1)) - 1);
+    int added(0);
+
+    //
+    // The earliest event time of each segment and every one after it.  Segments
+    // do not start in time order, so the range is only exhausted once no segment
+    // left starts inside it.
+    //
+    std::vector<qint64> earliestAfter(list.size() + 1, std::numeric_limits<qint64>::max());
+    for (size_t position = list.size(); position > 0; position--) {
+        const Segment& segment(list[position - 1]);
+        earliestAfter[position - 1] = segment.count > 0 ? qMin(segment.firstTime, earliestAfter[position])
+                                                        : earliestAfter[position];
+    }
+
+    for (size_t position = 0; position < list.size(); position++) {
+        const Segment& segment(list[position]);
+        if (segment.number < cursor.segment)
+            continue;
+        if (segment.number > cursor.segment) {
+            cursor.segment = segment.number;
+            cursor.entry = -1;
+        }
+        bool last(position + 1 == list.size());
+
+        //
+        // Whole segments are passed over on their summary alone.
+        //
+        if (segment.count == 0 || segment.lastTime < query.from || segment.firstTime > query.to ||
+            !(segment.severities & wantedSeverities) ||
+            (wantedClass && segment.classes.find(wantedClass) == segment.classes.end())) {
+            if (earliestAfter[position] > query.to)
+                return false;
+            if (!last) {
+                cursor.segment = segment.number + 1;
+                cursor.entry = -1;
+            }
+            continue;
+        }
+
+        QFile idx(segment.base + ".idx");
+        QFile log(segment.base + ".log");
+        if (!idx.open(QIODevice::ReadOnly) || !log.open(QIODevice::ReadOnly))
+            continue;
+
+        qint64 entries(idx.size() / ENTRY_SIZE);
+        if (cursor.entry < 0)
+            cursor.entry = 0;
+
+        while (cursor.entry < entries && added < count) {
+            if (!idx.seek(cursor.entry * ENTRY_SIZE))
+                break;
+            QByteArray chunk(idx.read(qMin((qint64) SCAN_CHUNK, entries - cursor.entry) * ENTRY_SIZE));
+            if (chunk.isEmpty())
+                break;
+
+            for (int pos = 0; pos + ENTRY_SIZE <= chunk.size() && added < count; pos += ENTRY_SIZE) {
+                IndexEntry entry;
+                unpackEntry(chunk.constData() + pos, entry);
+                cursor.entry++;
+                if (entry.time < query.from || entry.time > query.to)
+                    continue;
+                if (!(wantedSeverities & (1u << entry.severity)) || (wantedClass && entry.classHash != wantedClass))
+                    continue;
+
+                Variant value;
+                QByteArray line;
+                if (log.seek(entry.offset))
+                    line = log.readLine();
+                if (line.isEmpty() || !JsonReader::parse(line.constData(), line.constData() + line.size(), value) ||
+                    value.getType() != qpid::types::VAR_MAP)
+                    continue;
+
+                const Variant::Map& map(value.asMap());
+                Record record;
+                record.package = stringField(map, "package");
+                record.cls = stringField(map, "class");
+                if (!query.className.empty() && record.package + ":" + record.cls != query.className)
+                    continue;
+                Variant::Map::const_iterator field(map.find("timestamp"));
+                record.timestamp = field != map.end() ? field->second.asInt64() : 0;
+                record.severity = entry.severity;
+                record.broker = stringField(map, "broker");
+                record.agent = stringField(map, "agent");
+                field = map.find("properties");
+                if (field != map.end() && field->second.getType() == qpid::types::VAR_MAP)
+                    record.properties = field->second.asMap();
+                records.push_back(record);
+                added++;
+            }
+        }
+
+        if (added >= count)
+            return true;
+        if (!last) {
+            cursor.segment = segment.number + 1;
+            cursor.entry = -1;
+        }
+    }
+    return false;
+}
+
@@ -0,0 +1,150 @@
+#ifndef _qe_event_journal_h
+#define _qe_event_journal_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <qmf/ConsoleEvent.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+
+//
+// Append-only on-disk log of every event received, kept across runs.
+//
+// The journal is a directory of numbered segments.  Each segment has:
+//
+//   events-N.log   one NDJSON record per event, as the headless monitor writes them
+//   events-N.idx   fixed-size entries (time, log offset, class hash, severity) in
+//                  arrival order
+//   events-N.sum   written when the segment is closed: its earliest and latest
+//                  event times, count, the severities and the class hashes it contains
+//
+// Arrival order is not event time order: several brokers, or one with a skewed
+// clock, interleave their timestamps.  Queries skip whole segments by their
+// summary and otherwise scan only the small index entries, passing over those out
+// of range; log records are read just for the events returned.  Events are queued
+// by the GUI thread and written on the journal's own thread.
+//
+class EventJournal : public QThread {
+    Q_OBJECT
+
+public:
+    EventJournal(const QString& directory, QObject* parent = 0);
+    ~EventJournal();
+
+    //
+    // Events between two times (ms since the epoch, inclusive) at or above a
+    // severity (the lower the number the more severe), optionally of one
+    // "package:class".
+    //
+    struct Query {
+        qint64 from;
+        qint64 to;
+        int maxSeverity;
+        std::string className;
+    };
+
+    //
+    // Position of a paged read.  A new cursor starts at the beginning of the range.
+    //
+    struct Cursor {
+        int segment;
+        qint64 entry;
+        Cursor() : segment(0), entry(-1) {}
+    };
+
+    struct Record {
+        qint64 timestamp;
+        int severity;
+        std::string broker;
+        std::string agent;
+        std::string package;
+        std::string cls;
+        qpid::types::Variant::Map properties;
+    };
+
+    //
+    // Append up to count matching events after the cursor to the list.  Returns
+    // false once the range is exhausted.
+    //
+    bool read(const Query&, Cursor&, int count, std::vector<Record>&) const;
+
+    size_t segmentCount() const;
+    void stop();
+
+public slots:
+    void newEvent(const qmf::ConsoleEvent&);
+
+signals:
+    //
+    // The journal cannot be written and has stopped; later events are not kept.
+    //
+    void failed(const QString& message);
+
+protected:
+    void run();
+
+private:
+    struct Segment {
+        int number;
+        QString base;
+
+        //
+        // The earliest and the latest event time in the segment.
+        //
+        qint64 firstTime;
+        qint64 lastTime;
+        qint64 count;
+        quint32 severities;
+        std::set<quint32> classes;
+        Segment() : number(0), firstTime(0), lastTime(0), count(0), severities(0) {}
+    };
+
+    struct Pending {
+        std::string broker;
+        qmf::ConsoleEvent event;
+    };
+
+    QString directory;
+    mutable QMutex lock;
+    QWaitCondition wake;
+    std::deque<Pending> queue;
+    std::vector<Segment> segments;
+    int nextSegment;
+    bool stopping;
+    QString failure;
+
+    void loadSegments();
+    void fail(const QString&);
+    bool openSegment(QFile&, QFile&);
+    void closeSegment(QFile&, QFile&);
+    bool loadSummary(Segment&);
+    void rebuildSummary(Segment&);
+    void writeSummary(const Segment&);
+    void expireSegments(qint64 now);
+    static quint32 classHash(const std::string&);
+};
+
+#endif
+
@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "event-rate-widget.h"
+#include "event-detail-model.h"
+#include <QPainter>
+#include <QStringList>
+#include <QSettings>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    //
+    // How often the histogram is redrawn, in milliseconds.
+    //
+    const int REFRESH_INTERVAL = 1000;
+
+    //
+    // Classes listed beside the histogram.
+    //
+    const int TOP_CLASSES = 4;
+
+    QColor severityColor(int severity)
+    {
+        switch (severity) {
+        case qmf::SEV_EMERG  :
+        case qmf::SEV_ALERT  :
+        case qmf::SEV_CRIT   : return QColor(160, 0, 0);
+        case qmf::SEV_ERROR  : return QColor(220, 40, 40);
+        case qmf::SEV_WARN   : return QColor(230, 150, 30);
+        case qmf::SEV_NOTICE : return QColor(70, 130, 200);
+        }
+        return QColor(150, 150, 150);
+    }
+
+    bool busier(const std::pair<std::string, double>& left, const std::pair<std::string, double>& right)
+    {
+        return left.second > right.second;
+    }
+}
+
+
+EventRateWidget::EventRateWidget(QWidget* parent) : QWidget(parent)
+{
+    setMinimumHeight(80);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(refresh()));
+    timer.start(REFRESH_INTERVAL);
+    EventRates::instance().snapshot(snap);
+}
+
+
+QSize EventRateWidget::sizeHint() const
+{
+    return QSize(400, 100);
+}
+
+
+void EventRateWidget::setThresholds(const QString& text)
+{
+    thresholds.clear();
+    QStringList items(text.split(",", QString::SkipEmptyParts));
+    for (QStringList::const_iterator iter = items.begin(); iter != items.end(); iter++) {
+        int split(iter->indexOf('>'));
+        if (split < 1)
+            continue;
+        bool ok;
+        Threshold threshold;
+        threshold.name = iter->left(split).trimmed();
+        threshold.rate = iter->mid(split + 1).trimmed().toDouble(&ok);
+        threshold.exceeded = false;
+        if (ok && !threshold.name.isEmpty())
+            thresholds.append(threshold);
+    }
+
+    QSettings settings;
+    settings.setValue("Events/alertThresholds", text);
+}
+
+
+double EventRateWidget::currentRate(const QString& name) const
+{
+    if (name == "*")
+        return snap.total;
+    for (int severity = 0; severity < EventRates::SEVERITIES; severity++)
+        if (name == EventDetailModel::severityName(severity))
+            return snap.severities[severity];
+    std::map<std::string, double>::const_iterator iter(snap.classes.find(name.toStdString()));
+    return iter == snap.classes.end() ? 0.0 : iter->second;
+}
+
+
+bool EventRateWidget::overThreshold(const QString& name, double rate) const
+{
+    for (QVector<Threshold>::const_iterator iter = thresholds.begin(); iter != thresholds.end(); iter++)
+        if (iter->name == name && rate > iter->rate)
+            return true;
+    return false;
+}
+
+
+void EventRateWidget::refresh()
+{
+    EventRates::instance().snapshot(snap);
+
+    //
+    // Signal each threshold once when it is crossed, not on every refresh while
+    // the rate stays above it.
+    //
+    for (QVector<Threshold>::iterator iter = thresholds.begin(); iter != thresholds.end(); iter++) {
+        double rate(currentRate(iter->name));
+        bool exceeded(rate > iter->rate);
+        if (exceeded && !iter->exceeded)
+            emit thresholdExceeded(QString("Event rate of %1 is %2/s, above %3/s")
+                                   .arg(iter->name).arg(rate, 0, 'f', 1).arg(iter->rate));
+        iter->exceeded = exceeded;
+    }
+
+    if (isVisible())
+        update();
+}
+
+
+void EventRateWidget::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    QRect area(rect().adjusted(2, 2, -2, -2));
+    painter.fillRect(rect(), palette().base());
+
+    //
+    // The histogram takes the left part, the busiest classes the right.
+    //
+    int listWidth(qMin(area.width() / 2, 320));
+    QRect bars(area.adjusted(0, 0, -listWidth - 8, -fontMetrics().height()));
+    QRect list(area.adjusted(area.width() - listWidth, 0, 0, 0));
+
+    quint32 peak(1);
+    for (int second = 0; second < EventRates::WINDOW; second++) {
+        quint32 total(0);
+        for (int severity = 0; severity < EventRates::SEVERITIES; severity++)
+            total += snap.perSecond[second][severity];
+        peak = qMax(peak, total);
+    }
+
+    double width((double) bars.width() / EventRates::WINDOW);
+    for (int second = 0; second < EventRates::WINDOW; second++) {
+        double bottom(bars.bottom());
+        for (int severity = 0; severity < EventRates::SEVERITIES; severity++) {
+            quint32 count(snap.perSecond[second][severity]);
+            if (count == 0)
+                continue;
+            double height((double) count / peak * bars.height());
+            painter.fillRect(QRectF(bars.left() + second * width, bottom - height, qMax(width - 1, 1.0), height),
+                             severityColor(severity));
+            bottom -= height;
+        }
+    }
+
+    //
+    // A threshold on all events is drawn as a line at its per-second height.
+    //
+    for (QVector<Threshold>::const_iterator iter = thresholds.begin(); iter != thresholds.end(); iter++)
+        if (iter->name == "*" && iter->rate <= peak) {
+            int y(bars.bottom() - (int) (iter->rate / peak * bars.height()));
+            painter.setPen(QPen(Qt::red, 1, Qt::DashLine));
+            painter.drawLine(bars.left(), y, bars.right(), y);
+        }
+
+    painter.setPen(overThreshold("*", snap.total) ? Qt::red : palette().text().color());
+    painter.drawText(area.left(), area.bottom(),
+                     QString("%1 events/s over %2 s, peak %3/s").arg(snap.total, 0, 'f', 1)
+                     .arg((int) EventRates::WINDOW).arg(peak));
+
+    std::vector<std::pair<std::string, double> > busiest(snap.classes.begin(), snap.classes.end());
+    std::sort(busiest.begin(), busiest.end(), busier);
+
+    int line(list.top() + fontMetrics().ascent());
+    for (int severity = 0; severity < EventRates::SEVERITIES; severity++) {
+        QString name(EventDetailModel::severityName(severity));
+        if (snap.severities[severity] <= 0.0 || !overThreshold(name, snap.severities[severity]))
+            continue;
+        painter.setPen(Qt::red);
+        painter.drawText(list.left(), line, QString("%1: %2/s").arg(name).arg(snap.severities[severity], 0, 'f', 1));
+        line += fontMetrics().lineSpacing();
+    }
+    for (int idx = 0; idx < (int) busiest.size() && idx < TOP_CLASSES && line <= list.bottom(); idx++) {
+        QString name(busiest[idx].first.c_str());
+        painter.setPen(overThreshold(name, busiest[idx].second) ? Qt::red : palette().text().color());
+        painter.drawText(list.left(), line,
+                         fontMetrics().elidedText(QString("%1/s  %2").arg(busiest[idx].second, 0, 'f', 1).arg(name),
+                                                  Qt::ElideRight, list.width()));
+        line += fontMetrics().lineSpacing();
+    }
+}
+
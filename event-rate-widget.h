@@ -0,0 +1,71 @@
+#ifndef _qe_event_rate_widget_h
+#define _qe_event_rate_widget_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QWidget>
+#include <QTimer>
+#include <QString>
+#include <QVector>
+#include "event-rates.h"
+
+//
+// Histogram of the events received per second over the rate window, stacked by
+// severity, with the busiest classes listed alongside.
+//
+// Thresholds are given as a comma-separated list of name>rate, where the name is
+// a package:class, a severity (e.g. ERROR) or * for all events, and the rate is in
+// events per second averaged over the window.  A class or severity over its
+// threshold is drawn in red, and crossing a threshold is signalled once.
+//
+class EventRateWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    EventRateWidget(QWidget* parent = 0);
+
+    QSize sizeHint() const;
+
+public slots:
+    void setThresholds(const QString&);
+    void refresh();
+
+signals:
+    void thresholdExceeded(const QString&);
+
+protected:
+    void paintEvent(QPaintEvent*);
+
+private:
+    struct Threshold {
+        QString name;
+        double rate;
+        bool exceeded;
+    };
+
+    QTimer timer;
+    EventRates::Snapshot snap;
+    QVector<Threshold> thresholds;
+
+    double currentRate(const QString&) const;
+    bool overThreshold(const QString&, double) const;
+};
+
+#endif
+
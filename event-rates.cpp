@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "event-rates.h"
+#include <QDateTime>
+
+EventRates& EventRates::instance()
+{
+    static EventRates* rates(0);
+    if (!rates)
+        rates = new EventRates();
+    return *rates;
+}
+
+
+EventRates::EventRates()
+{
+    // Intentionally Left Blank
+}
+
+
+EventRates::Window::Window()
+{
+    for (int slot = 0; slot < WINDOW; slot++) {
+        seconds[slot] = -1;
+        counts[slot] = 0;
+    }
+}
+
+
+void EventRates::Window::add(qint64 second)
+{
+    //
+    // A slot still holding an older second is reused for this one.
+    //
+    int slot((int) (second % WINDOW));
+    if (seconds[slot] != second) {
+        if (seconds[slot] > second)
+            return;
+        seconds[slot] = second;
+        counts[slot] = 0;
+    }
+    counts[slot]++;
+}
+
+
+quint32 EventRates::Window::at(qint64 second) const
+{
+    if (second < 0)
+        return 0;
+    int slot((int) (second % WINDOW));
+    return seconds[slot] == second ? counts[slot] : 0;
+}
+
+
+quint64 EventRates::Window::sum(qint64 now) const
+{
+    quint64 total(0);
+    for (int slot = 0; slot < WINDOW; slot++)
+        if (seconds[slot] > now - WINDOW && seconds[slot] <= now)
+            total += counts[slot];
+    return total;
+}
+
+
+void EventRates::record(const std::string& className, int severity)
+{
+    qint64 second(QDateTime::currentMSecsSinceEpoch() / 1000);
+    severity = qBound(0, severity, (int) SEVERITIES - 1);
+
+    QMutexLocker locker(&lock);
+    severities[severity].add(second);
+    classes[className].add(second);
+}
+
+
+void EventRates::snapshot(Snapshot& snap) const
+{
+    QMutexLocker locker(&lock);
+    qint64 now(QDateTime::currentMSecsSinceEpoch() / 1000);
+
+    snap.total = 0.0;
+    for (int severity = 0; severity < SEVERITIES; severity++) {
+        for (int second = 0; second < WINDOW; second++)
+            snap.perSecond[second][severity] = severities[severity].at(now - WINDOW + 1 + second);
+        snap.severities[severity] = (double) severities[severity].sum(now) / WINDOW;
+        snap.total += snap.severities[severity];
+    }
+
+    snap.classes.clear();
+    for (std::map<std::string, Window>::const_iterator iter = classes.begin(); iter != classes.end(); iter++) {
+        quint64 count(iter->second.sum(now));
+        if (count > 0)
+            snap.classes[iter->first] = (double) count / WINDOW;
+    }
+}
+
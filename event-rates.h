@@ -0,0 +1,79 @@
+#ifndef _qe_event_rates_h
+#define _qe_event_rates_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QMutex>
+#include <QtGlobal>
+#include <string>
+#include <map>
+
+//
+// Live event rates per class and per severity over a sliding window of
+// one-second buckets.  The QMF threads record every event as it arrives, which
+// costs a few counter updates; nothing about the event itself is kept.
+//
+// Buckets are indexed by arrival time on the local clock, not by the event's
+// own timestamp: brokers' clocks differ from one another and from ours, and a
+// delayed event would otherwise move the window.  The window ends at the current
+// time, so rates fall back to zero when events stop.
+//
+class EventRates {
+public:
+    enum { WINDOW = 60, SEVERITIES = 8 };
+
+    static EventRates& instance();
+
+    void record(const std::string& className, int severity);
+
+    struct Snapshot {
+        //
+        // Events per second of the window, oldest first, split by severity.
+        //
+        quint32 perSecond[WINDOW][SEVERITIES];
+
+        //
+        // Average events per second over the window.
+        //
+        double total;
+        double severities[SEVERITIES];
+        std::map<std::string, double> classes;
+    };
+    void snapshot(Snapshot&) const;
+
+private:
+    EventRates();
+
+    struct Window {
+        qint64 seconds[WINDOW];
+        quint32 counts[WINDOW];
+
+        Window();
+        void add(qint64 second);
+        quint32 at(qint64 second) const;
+        quint64 sum(qint64 now) const;
+    };
+
+    mutable QMutex lock;
+    Window severities[SEVERITIES];
+    std::map<std::string, Window> classes;
+};
+
+#endif
+
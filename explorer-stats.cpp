@@ -0,0 +1,272 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "explorer-stats.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    //
+    // The GUI thread is checked on this interval (milliseconds).  A tick arriving
+    // later than STALL_THRESHOLD after the previous one counts as a stall.
+    //
+    const int STALL_INTERVAL = 20;
+    const int STALL_THRESHOLD = 100;
+
+    //
+    // Emit times kept per channel.  If nothing is delivering (no receiver was
+    // watched) the oldest are dropped rather than growing without bound.
+    //
+    const size_t MAX_IN_FLIGHT = 100000;
+}
+
+
+ExplorerStats& ExplorerStats::instance()
+{
+    static ExplorerStats* stats(0);
+    if (!stats)
+        stats = new ExplorerStats();
+    return *stats;
+}
+
+
+ExplorerStats::ExplorerStats() : stallUsers(0), lastTick(0)
+{
+    std::memset(histograms, 0, sizeof(histograms));
+    clock.start();
+
+    connect(&stallTimer, SIGNAL(timeout()), this, SLOT(checkStall()));
+}
+
+
+ExplorerStats::Stream::Stream()
+{
+    std::memset(events, 0, sizeof(events));
+}
+
+
+const char* ExplorerStats::eventTypeName(int type)
+{
+    switch (type) {
+    case qmf::CONSOLE_AGENT_ADD:             return "agent-add";
+    case qmf::CONSOLE_AGENT_DEL:             return "agent-del";
+    case qmf::CONSOLE_AGENT_RESTART:         return "agent-restart";
+    case qmf::CONSOLE_AGENT_SCHEMA_UPDATE:   return "schema-update";
+    case qmf::CONSOLE_AGENT_SCHEMA_RESPONSE: return "schema-response";
+    case qmf::CONSOLE_EVENT:                 return "event";
+    case qmf::CONSOLE_QUERY_RESPONSE:        return "query-response";
+    case qmf::CONSOLE_METHOD_RESPONSE:       return "method-response";
+    case qmf::CONSOLE_EXCEPTION:             return "exception";
+    case qmf::CONSOLE_THREAD_FAILED:         return "thread-failed";
+    }
+    return 0;
+}
+
+
+const char* ExplorerStats::histogramName(int histogram)
+{
+    switch (histogram) {
+    case HIST_AGENT_LATENCY:  return "agent-latency";
+    case HIST_OBJECT_LATENCY: return "object-latency";
+    case HIST_EVENT_LATENCY:  return "event-latency";
+    case HIST_AGENT_INSERT:   return "agent-insert";
+    case HIST_OBJECT_INSERT:  return "object-insert";
+    case HIST_CLASS_INSERT:   return "class-table-insert";
+    case HIST_EVENT_INSERT:   return "event-insert";
+    case HIST_STALL:          return "gui-stall";
+    }
+    return "";
+}
+
+
+const char* ExplorerStats::channelName(int channel)
+{
+    switch (channel) {
+    case CHANNEL_AGENT:  return "agents";
+    case CHANNEL_OBJECT: return "objects";
+    case CHANNEL_EVENT:  return "events";
+    }
+    return "";
+}
+
+
+qint64 ExplorerStats::HistogramData::percentile(double fraction) const
+{
+    if (count == 0)
+        return 0;
+
+    //
+    // Report the upper bound of the bucket holding the requested sample.
+    //
+    quint64 target((quint64) (fraction * count));
+    quint64 seen(0);
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += buckets[bucket];
+        if (seen > target)
+            return std::min((qint64) 1 << bucket, max);
+    }
+    return max;
+}
+
+
+ExplorerStats::Stream* ExplorerStats::stream(const QObject* thread) const
+{
+    QReadLocker locker(&streamLock);
+    StreamMap::const_iterator iter(streams.find(thread));
+    return iter == streams.end() ? 0 : iter->second;
+}
+
+
+void ExplorerStats::countEvent(int type)
+{
+    if (type < 0 || type >= EVENT_TYPES)
+        return;
+    Stream* counts(stream(QThread::currentThread()));
+    if (!counts)
+        return;
+    QMutexLocker locker(&counts->lock);
+    counts->events[type]++;
+}
+
+
+void ExplorerStats::emitted(Channel channel)
+{
+    Stream* counts(stream(QThread::currentThread()));
+    if (!counts)
+        return;
+    QMutexLocker locker(&counts->lock);
+    std::deque<qint64>& stamps(counts->inFlight[channel]);
+    if (stamps.size() >= MAX_IN_FLIGHT)
+        stamps.pop_front();
+    stamps.push_back(clock.nsecsElapsed());
+}
+
+
+void ExplorerStats::delivered(Channel channel, Histogram histogram)
+{
+    //
+    // Queued signals from one thread are delivered in the order they were
+    // emitted, so the oldest emit time of the sending thread belongs to this
+    // delivery.
+    //
+    Stream* counts(stream(sender()));
+    if (!counts)
+        return;
+    qint64 emitTime;
+    {
+        QMutexLocker locker(&counts->lock);
+        std::deque<qint64>& stamps(counts->inFlight[channel]);
+        if (stamps.empty())
+            return;
+        emitTime = stamps.front();
+        stamps.pop_front();
+    }
+    record(histogram, (clock.nsecsElapsed() - emitTime) / 1000);
+}
+
+
+void ExplorerStats::record(Histogram histogram, qint64 usec)
+{
+    HistogramData& data(histograms[histogram]);
+    if (usec < 0)
+        usec = 0;
+
+    int bucket(0);
+    while (bucket < BUCKETS - 1 && ((qint64) 1 << bucket) < usec)
+        bucket++;
+
+    data.count++;
+    data.total += usec;
+    if (usec > data.max)
+        data.max = usec;
+    data.buckets[bucket]++;
+}
+
+
+void ExplorerStats::snapshot(Snapshot& snap) const
+{
+    snap.time = clock.elapsed();
+    std::memset(snap.events, 0, sizeof(snap.events));
+    std::memset(snap.queueDepth, 0, sizeof(snap.queueDepth));
+    std::memcpy(snap.histograms, histograms, sizeof(histograms));
+
+    QReadLocker locker(&streamLock);
+    for (StreamMap::const_iterator iter = streams.begin(); iter != streams.end(); iter++) {
+        QMutexLocker streamLocker(&iter->second->lock);
+        for (int type = 0; type < EVENT_TYPES; type++)
+            snap.events[type] += iter->second->events[type];
+        for (int channel = 0; channel < CHANNEL_COUNT; channel++)
+            snap.queueDepth[channel] += iter->second->inFlight[channel].size();
+    }
+}
+
+
+void ExplorerStats::watch(QThread* qmfThread)
+{
+    {
+        QWriteLocker locker(&streamLock);
+        Stream*& counts(streams[qmfThread]);
+        if (!counts)
+            counts = new Stream();
+    }
+    connect(qmfThread, SIGNAL(newAgent(qmf::Agent)), this, SLOT(agentDelivered(qmf::Agent)));
+    connect(qmfThread, SIGNAL(addObject(qmf::Data)), this, SLOT(objectDelivered(qmf::Data)));
+    connect(qmfThread, SIGNAL(newEvent(qmf::ConsoleEvent)), this, SLOT(eventDelivered(qmf::ConsoleEvent)));
+}
+
+
+void ExplorerStats::agentDelivered(const qmf::Agent&)
+{
+    delivered(CHANNEL_AGENT, HIST_AGENT_LATENCY);
+}
+
+
+void ExplorerStats::objectDelivered(const qmf::Data&)
+{
+    delivered(CHANNEL_OBJECT, HIST_OBJECT_LATENCY);
+}
+
+
+void ExplorerStats::eventDelivered(const qmf::ConsoleEvent&)
+{
+    delivered(CHANNEL_EVENT, HIST_EVENT_LATENCY);
+}
+
+
+void ExplorerStats::probeStalls(bool on)
+{
+    stallUsers += on ? 1 : -1;
+    if (stallUsers > 0 && !stallTimer.isActive()) {
+        lastTick = 0;
+        stallTimer.start(STALL_INTERVAL);
+    } else if (stallUsers <= 0) {
+        stallUsers = 0;
+        stallTimer.stop();
+    }
+}
+
+
+void ExplorerStats::checkStall()
+{
+    qint64 now(clock.elapsed());
+    if (lastTick > 0 && now - lastTick > STALL_THRESHOLD)
+        record(HIST_STALL, (now - lastTick - STALL_INTERVAL) * 1000);
+    lastTick = now;
+}
+
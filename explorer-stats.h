@@ -0,0 +1,170 @@
+#ifndef _qe_explorer_stats_h
+#define _qe_explorer_stats_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QObject>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <qmf/Agent.h>
+#include <qmf/Data.h>
+#include <qmf/ConsoleEvent.h>
+#include <deque>
+#include <map>
+
+//
+// Counters the explorer keeps about itself: console events seen by the QMF
+// threads, updates queued between those threads and the GUI thread, how long the
+// models take to absorb them, and how often the GUI thread's event loop stalls.
+//
+// Event and emit counts are kept per watched QMF thread, each under its own lock,
+// so the threads do not contend with one another.  The timing histograms belong
+// to the main thread, where the instance lives and receives the relayed signals
+// alongside the models to time their delivery.
+//
+class ExplorerStats : public QObject {
+    Q_OBJECT
+
+public:
+    //
+    // Updates relayed from a QMF thread to the GUI thread.
+    //
+    typedef enum { CHANNEL_AGENT, CHANNEL_OBJECT, CHANNEL_EVENT, CHANNEL_COUNT } Channel;
+
+    typedef enum {
+        HIST_AGENT_LATENCY,     // emit in a QMF thread to delivery in the GUI thread
+        HIST_OBJECT_LATENCY,
+        HIST_EVENT_LATENCY,
+        HIST_AGENT_INSERT,      // time spent in the model slots
+        HIST_OBJECT_INSERT,
+        HIST_CLASS_INSERT,
+        HIST_EVENT_INSERT,
+        HIST_STALL,             // GUI event loop stalls
+        HIST_COUNT
+    } Histogram;
+
+    enum { EVENT_TYPES = 16, BUCKETS = 32 };
+
+    //
+    // Durations in microseconds, counted in power-of-two buckets.
+    //
+    struct HistogramData {
+        quint64 count;
+        qint64 total;
+        qint64 max;
+        quint64 buckets[BUCKETS];
+
+        qint64 percentile(double) const;
+        qint64 mean() const { return count ? total / (qint64) count : 0; }
+    };
+
+    struct Snapshot {
+        qint64 time;
+        quint64 events[EVENT_TYPES];
+        qint64 queueDepth[CHANNEL_COUNT];
+        HistogramData histograms[HIST_COUNT];
+    };
+
+    //
+    // Times the enclosing scope, on the main thread, into a histogram.
+    //
+    class ScopedTimer {
+    public:
+        ScopedTimer(Histogram h) : histogram(h) { timer.start(); }
+        ~ScopedTimer() { ExplorerStats::instance().record(histogram, timer.nsecsElapsed() / 1000); }
+    private:
+        Histogram histogram;
+        QElapsedTimer timer;
+    };
+
+    //
+    // The first call must come from the main thread.
+    //
+    static ExplorerStats& instance();
+
+    static const char* eventTypeName(int);
+    static const char* histogramName(int);
+    static const char* channelName(int);
+
+    //
+    // Called from a watched QMF thread; calls from any other thread are ignored.
+    //
+    void countEvent(int type);
+    void emitted(Channel);
+
+    //
+    // Main thread only.
+    //
+    void record(Histogram, qint64 usec);
+    void snapshot(Snapshot&) const;
+
+    //
+    // Start timing the delivery of a QMF thread's agent, object and event updates.
+    // Call before the thread starts and before its signals are connected to the
+    // models.
+    //
+    void watch(QThread* qmfThread);
+
+    //
+    // Probe the GUI event loop for stalls while anything is showing the figures.
+    // Calls nest; the probe stops when every user has turned it off.
+    //
+    void probeStalls(bool);
+
+public slots:
+    void agentDelivered(const qmf::Agent&);
+    void objectDelivered(const qmf::Data&);
+    void eventDelivered(const qmf::ConsoleEvent&);
+
+private slots:
+    void checkStall();
+
+private:
+    ExplorerStats();
+
+    //
+    // What one QMF thread has counted, and the emit times of its updates not yet
+    // delivered.
+    //
+    struct Stream {
+        Stream();
+
+        mutable QMutex lock;
+        quint64 events[EVENT_TYPES];
+        std::deque<qint64> inFlight[CHANNEL_COUNT];
+    };
+    typedef std::map<const QObject*, Stream*> StreamMap;
+
+    mutable QReadWriteLock streamLock;
+    StreamMap streams;
+    QElapsedTimer clock;
+    QTimer stallTimer;
+    int stallUsers;
+    qint64 lastTick;
+    HistogramData histograms[HIST_COUNT];
+
+    Stream* stream(const QObject*) const;
+    void delivered(Channel, Histogram);
+};
+
+#endif
+
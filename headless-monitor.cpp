@@ -0,0 +1,260 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "headless-monitor.h"
+#include "event-detail-model.h"
+#include "object-model.h"
+#include "rate-engine.h"
+#include "explorer-stats.h"
+#include <qmf/SchemaId.h>
+#include <qmf/DataAddr.h>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <csignal>
+#include <cstring>
+
+namespace {
+    volatile sig_atomic_t stopRequested = 0;
+
+    //
+    // Output is flushed on this interval rather than per line so bursts of
+    // updates are written in large blocks.
+    //
+    const int FLUSH_INTERVAL = 250;
+
+    //
+    // Default seconds between statistics records.
+    //
+    const int DEFAULT_STATS_INTERVAL = 10;
+}
+
+
+HeadlessMonitor::HeadlessMonitor(std::ostream& o, RateEngine* rates, QObject* parent) :
+    QObject(parent), out(o), json(o), rateEngine(rates), lastStatsTime(0)
+{
+    std::memset(lastEvents, 0, sizeof(lastEvents));
+    connect(&flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    flushTimer.start(FLUSH_INTERVAL);
+    connect(&statsTimer, SIGNAL(timeout()), this, SLOT(writeStats()));
+    setStatsInterval(DEFAULT_STATS_INTERVAL);
+}
+
+
+void HeadlessMonitor::setStatsInterval(int seconds)
+{
+    //
+    // Event loop stalls are only measured while statistics are written.
+    //
+    bool wasActive(statsTimer.isActive());
+    if (seconds > 0)
+        statsTimer.start(seconds * 1000);
+    else
+        statsTimer.stop();
+    if (statsTimer.isActive() != wasActive)
+        ExplorerStats::instance().probeStalls(statsTimer.isActive());
+}
+
+
+void HeadlessMonitor::writeStats()
+{
+    ExplorerStats::Snapshot snap;
+    ExplorerStats::instance().snapshot(snap);
+    double seconds(lastStatsTime > 0 ? (snap.time - lastStatsTime) / 1000.0 : 0.0);
+
+    beginRecord("stats");
+
+    json.key("events");
+    json.beginObject();
+    for (int type = 0; type < ExplorerStats::EVENT_TYPES; type++) {
+        const char* name(ExplorerStats::eventTypeName(type));
+        if (!name)
+            continue;
+        json.key(name);
+        json.beginObject();
+        json.field("total", (qint64) snap.events[type]);
+        if (seconds > 0)
+            json.field("perSecond", (snap.events[type] - lastEvents[type]) / seconds);
+        json.endObject();
+        lastEvents[type] = snap.events[type];
+    }
+    json.endObject();
+
+    json.key("queued");
+    json.beginObject();
+    for (int channel = 0; channel < ExplorerStats::CHANNEL_COUNT; channel++)
+        json.field(ExplorerStats::channelName(channel), snap.queueDepth[channel]);
+    json.endObject();
+
+    json.key("timingsUsec");
+    json.beginObject();
+    for (int histogram = 0; histogram < ExplorerStats::HIST_COUNT; histogram++) {
+        const ExplorerStats::HistogramData& data(snap.histograms[histogram]);
+        if (data.count == 0)
+            continue;
+        json.key(ExplorerStats::histogramName(histogram));
+        json.beginObject();
+        json.field("count", (qint64) data.count);
+        json.field("mean", data.mean());
+        json.field("p50", data.percentile(0.5));
+        json.field("p99", data.percentile(0.99));
+        json.field("max", data.max);
+        json.endObject();
+    }
+    json.endObject();
+
+    if (rateEngine) {
+        json.key("memoryBytes");
+        json.beginObject();
+        json.field("rates", (qint64) rateEngine->memoryUsage());
+        json.endObject();
+    }
+
+    json.endObject();
+    json.endLine();
+    lastStatsTime = snap.time;
+}
+
+
+void HeadlessMonitor::requestStop()
+{
+    stopRequested = 1;
+}
+
+
+void HeadlessMonitor::flush()
+{
+    out.flush();
+    if (stopRequested)
+        QCoreApplication::quit();
+}
+
+
+void HeadlessMonitor::beginRecord(const char* type)
+{
+    json.beginObject();
+    json.field("type", type);
+    json.field("time", (qint64) QDateTime::currentMSecsSinceEpoch());
+    if (sender() && !sender()->objectName().isEmpty())
+        json.field("broker", sender()->objectName().toStdString());
+}
+
+
+void HeadlessMonitor::connectionStatusChanged(const QString& text)
+{
+    beginRecord("status");
+    json.field("text", text.toStdString());
+    json.endObject();
+    json.endLine();
+}
+
+
+void HeadlessMonitor::writeAgent(const char* change, const qmf::Agent& agent)
+{
+    beginRecord("agent");
+    json.field("change", change);
+    json.field("name", agent.getName());
+    json.field("vendor", agent.getVendor());
+    json.field("product", agent.getProduct());
+    json.field("instance", agent.getInstance());
+    json.field("epoch", (qint64) agent.getEpoch());
+    json.field("attributes", agent.getAttributes());
+    json.endObject();
+    json.endLine();
+}
+
+
+void HeadlessMonitor::newAgent(const qmf::Agent& agent)
+{
+    writeAgent("add", agent);
+}
+
+
+void HeadlessMonitor::delAgent(const qmf::Agent& agent)
+{
+    writeAgent("del", agent);
+}
+
+
+void HeadlessMonitor::addObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+
+    const qmf::DataAddr& addr(object.getAddr());
+    const qmf::SchemaId& schemaId(object.getSchemaId());
+    const qpid::types::Variant::Map& props(object.getProperties());
+
+    beginRecord("object");
+    json.field("agent", addr.getAgentName());
+    json.field("name", addr.getName());
+    json.field("epoch", (qint64) addr.getAgentEpoch());
+    json.field("package", schemaId.getPackageName());
+    json.field("class", schemaId.getName());
+    json.field("properties", props);
+
+    //
+    // Add the derived rates of any counters the rate engine has seen twice.
+    //
+    if (rateEngine) {
+        std::string key(ObjectModel::objectKey(object));
+        bool started(false);
+        for (qpid::types::Variant::Map::const_iterator iter = props.begin(); iter != props.end(); iter++) {
+            RateEngine::Rate rate;
+            if (!rateEngine->isCounter(iter->first) || !rateEngine->rate(key, iter->first, rate))
+                continue;
+            if (!started) {
+                json.key("rates");
+                json.beginObject();
+                started = true;
+            }
+            json.key(iter->first);
+            json.beginObject();
+            json.field("rate", rate.perSecond);
+            json.field("avg1m", rate.average1m);
+            json.field("avg5m", rate.average5m);
+            json.endObject();
+        }
+        if (started)
+            json.endObject();
+    }
+
+    json.endObject();
+    json.endLine();
+}
+
+
+void HeadlessMonitor::newEvent(const qmf::ConsoleEvent& event)
+{
+    uint32_t pcount(event.getDataCount());
+    for (uint32_t idx = 0; idx < pcount; idx++) {
+        qmf::Data data(event.getData(idx));
+        const qmf::SchemaId& schemaId(data.getSchemaId());
+
+        beginRecord("event");
+        json.field("timestamp", (qint64) event.getTimestamp());
+        json.field("severity", EventDetailModel::severityName(event.getSeverity()).toStdString());
+        json.field("agent", event.getAgent().getName());
+        json.field("package", schemaId.getPackageName());
+        json.field("class", schemaId.getName());
+        json.field("properties", data.getProperties());
+        json.endObject();
+        json.endLine();
+    }
+}
+
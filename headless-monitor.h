@@ -0,0 +1,80 @@
+#ifndef _qe_headless_monitor_h
+#define _qe_headless_monitor_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QObject>
+#include <QTimer>
+#include <qmf/Agent.h>
+#include <qmf/Data.h>
+#include <qmf/ConsoleEvent.h>
+#include "json-writer.h"
+#include "explorer-stats.h"
+#include <ostream>
+
+class RateEngine;
+
+//
+// Writes the updates relayed by a QmfThread as line-delimited JSON, one
+// record per agent, object, event or status change.  Used when the explorer
+// runs without a GUI.
+//
+class HeadlessMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    HeadlessMonitor(std::ostream& out, RateEngine* rates, QObject* parent = 0);
+
+    //
+    // Called from a signal handler; the monitor quits the application on its next flush.
+    //
+    static void requestStop();
+
+    //
+    // Write a record of the explorer's own statistics every so many seconds; zero
+    // turns it off.
+    //
+    void setStatsInterval(int seconds);
+
+public slots:
+    void connectionStatusChanged(const QString&);
+    void newAgent(const qmf::Agent&);
+    void delAgent(const qmf::Agent&);
+    void addObject(const qmf::Data&);
+    void newEvent(const qmf::ConsoleEvent&);
+
+private slots:
+    void flush();
+    void writeStats();
+
+private:
+    std::ostream& out;
+    JsonWriter json;
+    RateEngine* rateEngine;
+    QTimer flushTimer;
+    QTimer statsTimer;
+    qint64 lastStatsTime;
+    quint64 lastEvents[ExplorerStats::EVENT_TYPES];
+
+    void beginRecord(const char*);
+    void writeAgent(const char*, const qmf::Agent&);
+};
+
+#endif
+
@@ -0,0 +1,313 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "json-reader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+using qpid::types::Variant;
+
+namespace {
+    class Parser {
+    public:
+        Parser(const char* b, const char* e) : pos(b), end(e) {}
+
+        bool value(Variant& out, int depth = 0);
+        bool string(std::string& out);
+        void skipSpace() { while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) pos++; }
+
+        const char* pos;
+        const char* end;
+
+    private:
+        bool number(Variant& out);
+        bool literal(const char* text);
+        static void appendUtf8(std::string&, unsigned long);
+        bool hex4(unsigned long&);
+    };
+
+    //
+    // Nesting beyond this is treated as malformed rather than risking the stack.
+    //
+    const int MAX_DEPTH = 64;
+}
+
+
+bool Parser::literal(const char* text)
+{
+    size_t length(std::strlen(text));
+    if ((size_t) (end - pos) < length || std::strncmp(pos, text, length) != 0)
+        return false;
+    pos += length;
+    return true;
+}
+
+
+bool Parser::hex4(unsigned long& code)
+{
+    if (end - pos < 4)
+        return false;
+    code = 0;
+    for (int idx = 0; idx < 4; idx++) {
+        char c(*pos++);
+        code <<= 4;
+        if (c >= '0' && c <= '9')      code |= c - '0';
+        else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+
+void Parser::appendUtf8(std::string& out, unsigned long code)
+{
+    if (code < 0x80)
+        out += (char) code;
+    else if (code < 0x800) {
+        out += (char) (0xc0 | (code >> 6));
+        out += (char) (0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        out += (char) (0xe0 | (code >> 12));
+        out += (char) (0x80 | ((code >> 6) & 0x3f));
+        out += (char) (0x80 | (code & 0x3f));
+    } else {
+        out += (char) (0xf0 | (code >> 18));
+        out += (char) (0x80 | ((code >> 12) & 0x3f));
+        out += (char) (0x80 | ((code >> 6) & 0x3f));
+        out += (char) (0x80 | (code & 0x3f));
+    }
+}
+
+
+bool Parser::string(std::string& out)
+{
+    if (pos >= end || *pos != '"')
+        return false;
+    pos++;
+
+    //
+    // Copy unescaped runs in one go; most strings have no escapes at all.
+    //
+    while (pos < end) {
+        const char* run(pos);
+        while (pos < end && *pos != '"' && *pos != '\\')
+            pos++;
+        out.append(run, pos - run);
+        if (pos >= end)
+            return false;
+        if (*pos == '"') {
+            pos++;
+            return true;
+        }
+
+        pos++;
+        if (pos >= end)
+            return false;
+        char c(*pos++);
+        switch (c) {
+        case '"':  out += '"';  break;
+        case '\\': out += '\\'; break;
+        case '/':  out += '/';  break;
+        case 'b':  out += '\b'; break;
+        case 'f':  out += '\f'; break;
+        case 'n':  out += '\n'; break;
+        case 'r':  out += '\r'; break;
+        case 't':  out += '\t'; break;
+        case 'u': {
+            unsigned long code;
+            if (!hex4(code))
+                return false;
+            if (code >= 0xd800 && code < 0xdc00 && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+                unsigned long low;
+                pos += 2;
+                if (!hex4(low))
+                    return false;
+                code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+            }
+            appendUtf8(out, code);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+
+bool Parser::number(Variant& out)
+{
+    const char* start(pos);
+    bool real(false);
+    if (pos < end && *pos == '-')
+        pos++;
+    while (pos < end && ((*pos >= '0' && *pos <= '9') || *pos == '.' || *pos == 'e' || *pos == 'E' ||
+                         *pos == '+' || *pos == '-')) {
+        if (*pos == '.' || *pos == 'e' || *pos == 'E')
+            real = true;
+        pos++;
+    }
+    if (pos == start)
+        return false;
+
+    std::string text(start, pos - start);
+    char* tail;
+    errno = 0;
+    if (!real) {
+        if (text[0] == '-') {
+            long long value(std::strtoll(text.c_str(), &tail, 10));
+            if (*tail == 0 && errno == 0) {
+                out = (int64_t) value;
+                return true;
+            }
+        } else {
+            unsigned long long value(std::strtoull(text.c_str(), &tail, 10));
+            if (*tail == 0 && errno == 0) {
+                if (value <= 0x7fffffffffffffffULL)
+                    out = (int64_t) value;
+                else
+                    out = (uint64_t) value;
+                return true;
+            }
+        }
+        errno = 0;
+    }
+    double value(std::strtod(text.c_str(), &tail));
+    if (*tail != 0)
+        return false;
+    out = value;
+    return true;
+}
+
+
+bool Parser::value(Variant& out, int depth)
+{
+    if (depth > MAX_DEPTH)
+        return false;
+
+    skipSpace();
+    if (pos >= end)
+        return false;
+
+    switch (*pos) {
+    case '{': {
+        pos++;
+        out = Variant::Map();
+        Variant::Map& map(out.asMap());
+        skipSpace();
+        if (pos < end && *pos == '}') {
+            pos++;
+            return true;
+        }
+        while (true) {
+            std::string key;
+            skipSpace();
+            if (!string(key))
+                return false;
+            skipSpace();
+            if (pos >= end || *pos++ != ':')
+                return false;
+            if (!value(map[key], depth + 1))
+                return false;
+            skipSpace();
+            if (pos >= end)
+                return false;
+            if (*pos == ',') {
+                pos++;
+                continue;
+            }
+            if (*pos++ == '}')
+                return true;
+            return false;
+        }
+    }
+    case '[': {
+        pos++;
+        out = Variant::List();
+        Variant::List& list(out.asList());
+        skipSpace();
+        if (pos < end && *pos == ']') {
+            pos++;
+            return true;
+        }
+        while (true) {
+            list.push_back(Variant());
+            if (!value(list.back(), depth + 1))
+                return false;
+            skipSpace();
+            if (pos >= end)
+                return false;
+            if (*pos == ',') {
+                pos++;
+                continue;
+            }
+            if (*pos++ == ']')
+                return true;
+            return false;
+        }
+    }
+    case '"': {
+        std::string text;
+        if (!string(text))
+            return false;
+        out = text;
+        return true;
+    }
+    case 't':
+        out = true;
+        return literal("true");
+    case 'f':
+        out = false;
+        return literal("false");
+    case 'n':
+        out = Variant();
+        return literal("null");
+    }
+    return number(out);
+}
+
+
+bool JsonReader::parse(const char* begin, const char* end, Variant& out)
+{
+    Parser parser(begin, end);
+    return parser.value(out);
+}
+
+
+bool JsonReader::findString(const char* begin, const char* end, const std::string& name, std::string& out)
+{
+    //
+    // Fields are written without whitespace, so the quoted name followed by a
+    // colon is enough to find it.  A nested field of the same name must not come
+    // first, which holds for the leading fields this is used on.
+    //
+    std::string pattern("\"" + name + "\":");
+    const char* found(std::search(begin, end, pattern.begin(), pattern.end()));
+    if (found == end)
+        return false;
+
+    Parser parser(found + pattern.size(), end);
+    parser.skipSpace();
+    out.clear();
+    return parser.string(out);
+}
+
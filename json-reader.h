@@ -0,0 +1,44 @@
+#ifndef _qe_json_reader_h
+#define _qe_json_reader_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <qpid/types/Variant.h>
+#include <string>
+
+//
+// Minimal JSON parser producing QMF values, the counterpart of JsonWriter.
+// Objects become maps, arrays lists; integers are signed unless too large,
+// other numbers doubles.
+//
+namespace JsonReader {
+    //
+    // Parse one JSON value from [begin, end).  Returns false on malformed input.
+    //
+    bool parse(const char* begin, const char* end, qpid::types::Variant&);
+
+    //
+    // Find the string value of a top-level field of the object in [begin, end)
+    // without parsing the rest of it.
+    //
+    bool findString(const char* begin, const char* end, const std::string& name, std::string&);
+}
+
+#endif
+
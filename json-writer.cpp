@@ -0,0 +1,233 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "json-writer.h"
+#include <cstdio>
+#include <limits>
+
+JsonWriter::JsonWriter(std::ostream& o) : out(o), first(true)
+{
+    out.precision(15);
+}
+
+
+void JsonWriter::separator()
+{
+    if (!first)
+        out << ',';
+    first = false;
+}
+
+
+void JsonWriter::writeString(const std::string& text)
+{
+    out << '"';
+    for (std::string::const_iterator iter = text.begin(); iter != text.end(); iter++) {
+        unsigned char c(*iter);
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n";  break;
+        case '\r': out << "\\r";  break;
+        case '\t': out << "\\t";  break;
+        default:
+            if (c < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                out << escape;
+            } else
+                out << *iter;
+        }
+    }
+    out << '"';
+}
+
+
+void JsonWriter::beginObject()
+{
+    separator();
+    out << '{';
+    first = true;
+}
+
+
+void JsonWriter::endObject()
+{
+    out << '}';
+    first = false;
+}
+
+
+void JsonWriter::beginArray()
+{
+    separator();
+    out << '[';
+    first = true;
+}
+
+
+void JsonWriter::endArray()
+{
+    out << ']';
+    first = false;
+}
+
+
+void JsonWriter::key(const std::string& name)
+{
+    separator();
+    writeString(name);
+    out << ':';
+    first = true;
+}
+
+
+void JsonWriter::field(const std::string& name, const std::string& text)
+{
+    key(name);
+    value(text);
+}
+
+
+void JsonWriter::field(const std::string& name, const char* text)
+{
+    key(name);
+    value(std::string(text));
+}
+
+
+void JsonWriter::field(const std::string& name, qint64 number)
+{
+    key(name);
+    value(number);
+}
+
+
+void JsonWriter::field(const std::string& name, double number)
+{
+    key(name);
+    value(number);
+}
+
+
+void JsonWriter::field(const std::string& name, const qpid::types::Variant& v)
+{
+    key(name);
+    value(v);
+}
+
+
+void JsonWriter::field(const std::string& name, const qpid::types::Variant::Map& map)
+{
+    key(name);
+    value(map);
+}
+
+
+void JsonWriter::value(const std::string& text)
+{
+    separator();
+    writeString(text);
+}
+
+
+void JsonWriter::value(qint64 number)
+{
+    separator();
+    out << number;
+}
+
+
+void JsonWriter::value(double number)
+{
+    separator();
+    if (number != number || number == std::numeric_limits<double>::infinity() ||
+        number == -std::numeric_limits<double>::infinity())
+        out << "null";
+    else
+        out << number;
+}
+
+
+void JsonWriter::value(const qpid::types::Variant::Map& map)
+{
+    beginObject();
+    for (qpid::types::Variant::Map::const_iterator iter = map.begin(); iter != map.end(); iter++)
+        field(iter->first, iter->second);
+    endObject();
+}
+
+
+void JsonWriter::value(const qpid::types::Variant::List& list)
+{
+    beginArray();
+    for (qpid::types::Variant::List::const_iterator iter = list.begin(); iter != list.end(); iter++)
+        value(*iter);
+    endArray();
+}
+
+
+void JsonWriter::value(const qpid::types::Variant& v)
+{
+    switch (v.getType()) {
+    case qpid::types::VAR_VOID:
+        separator();
+        out << "null";
+        break;
+    case qpid::types::VAR_BOOL:
+        separator();
+        out << (v.asBool() ? "true" : "false");
+        break;
+    case qpid::types::VAR_UINT8:
+    case qpid::types::VAR_UINT16:
+    case qpid::types::VAR_UINT32:
+    case qpid::types::VAR_UINT64:
+        separator();
+        out << v.asUint64();
+        break;
+    case qpid::types::VAR_INT8:
+    case qpid::types::VAR_INT16:
+    case qpid::types::VAR_INT32:
+    case qpid::types::VAR_INT64:
+        separator();
+        out << v.asInt64();
+        break;
+    case qpid::types::VAR_FLOAT:
+    case qpid::types::VAR_DOUBLE:
+        value(v.asDouble());
+        break;
+    case qpid::types::VAR_MAP:
+        value(v.asMap());
+        break;
+    case qpid::types::VAR_LIST:
+        value(v.asList());
+        break;
+    default:
+        value(v.asString());
+        break;
+    }
+}
+
+
+void JsonWriter::endLine()
+{
+    out << '\n';
+    first = true;
+}
+
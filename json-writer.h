@@ -0,0 +1,69 @@
+#ifndef _qe_json_writer_h
+#define _qe_json_writer_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QtGlobal>
+#include <qpid/types/Variant.h>
+#include <ostream>
+#include <string>
+
+//
+// Minimal streaming JSON output for QMF values.  Objects are written field by
+// field so a record never has to be assembled in memory first.
+//
+class JsonWriter {
+public:
+    JsonWriter(std::ostream&);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(const std::string&);
+
+    void field(const std::string&, const std::string&);
+    void field(const std::string&, const char*);
+    void field(const std::string&, qint64);
+    void field(const std::string&, double);
+    void field(const std::string&, const qpid::types::Variant&);
+    void field(const std::string&, const qpid::types::Variant::Map&);
+
+    void value(const std::string&);
+    void value(const qpid::types::Variant&);
+    void value(const qpid::types::Variant::Map&);
+    void value(const qpid::types::Variant::List&);
+    void value(qint64);
+    void value(double);
+
+    //
+    // Terminate the current record with a newline (NDJSON).
+    //
+    void endLine();
+
+private:
+    std::ostream& out;
+    bool first;
+
+    void separator();
+    void writeString(const std::string&);
+};
+
+#endif
+
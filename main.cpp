@@ -18,12 +18,39 @@
  */
 
 #include "main.h"
+#include "headless-monitor.h"
+#include "explorer-stats.h"
+#include "event-rates.h"
+#include "trace.h"
+#include "session-opener.h"
 #include <iostream>
+#include <fstream>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
 
-QmfExplorer::QmfExplorer(QMainWindow* parent) : QMainWindow(parent)
-{
-    setupUi(this);
+namespace {
+    //
+    // Method names offered in the call dialog before any have been used.
+    //
+    const char* DEFAULT_METHODS[] = { "echo", "purge", "reroute", "create", "delete", "close", 0 };
 
+    //
+    // Default number of seconds to wait for a method response.
+    //
+    const int DEFAULT_METHOD_TIMEOUT = 30;
+
+    //
+    // Milliseconds allowed at exit for connection helper threads to finish.
+    //
+    const unsigned long SHUTDOWN_GRACE = 2000;
+}
+
+//
+// Setup shared by the GUI and headless modes.
+//
+static void initApplication()
+{
     qRegisterMetaType<qmf::Agent>();
     qRegisterMetaType<qmf::Data>();
     qRegisterMetaType<qmf::ConsoleEvent>();
@@ -35,6 +62,24 @@ QmfExplorer::QmfExplorer(QMainWindow* parent) : QMainWindow(parent)
     QCoreApplication::setOrganizationDomain("redhat.com");
     QCoreApplication::setApplicationName("QMF-Explorer");
 
+    //
+    // Create the statistics and event-rate collectors on the main thread before
+    // any QMF thread starts counting into them.
+    //
+    ExplorerStats::instance();
+    EventRates::instance();
+
+    //
+    // Tracing can be switched on from the start through the environment.
+    //
+    if (std::getenv("QE_TRACE"))
+        Trace::enable(true);
+}
+
+QmfExplorer::QmfExplorer(QMainWindow* parent) : QMainWindow(parent)
+{
+    setupUi(this);
+
     //
     // Create the agent model which stores the list of known agents.
     //
@@ -47,6 +92,12 @@ QmfExplorer::QmfExplorer(QMainWindow* parent) : QMainWindow(parent)
     agentDetail = new AgentDetailModel(this);
     tableView_agent_details->setModel(agentDetail);
 
+    //
+    // The agent filter starts as last applied, with the saved presets to pick from.
+    //
+    lineEdit_agent_filter->setText(AgentFilter::current());
+    loadFilterPresets();
+
     //
     // Create the object model which stores the list of queried objects.
     //
@@ -54,10 +105,40 @@ QmfExplorer::QmfExplorer(QMainWindow* parent) : QMainWindow(parent)
     treeView_objects->setModel(objectModel);
 
     //
-    // Create the object-detail model which holds the properties of an object.
+    // The object tree can be regrouped at any time; the last grouping is kept.
     //
-    objectDetail = new ObjectDetailModel(this);
-    tableView_object->setModel(objectDetail);
+    comboBox_grouping->addItem("Package / Class / Object", (int) ObjectModel::GROUP_PACKAGE);
+    comboBox_grouping->addItem("Agent / Package / Class / Object", (int) ObjectModel::GROUP_AGENT);
+    comboBox_grouping->addItem("Package / Class / Agent / Object", (int) ObjectModel::GROUP_CLASS_AGENT);
+    {
+        QSettings settings;
+        int grouping(settings.value("Objects/grouping", (int) ObjectModel::GROUP_PACKAGE).toInt());
+        comboBox_grouping->setCurrentIndex(qMax(0, comboBox_grouping->findData(grouping)));
+        objectModel->setGrouping(comboBox_grouping->itemData(comboBox_grouping->currentIndex()).toInt());
+    }
+
+    //
+    // Create the object-detail model which holds the properties of an object.  The
+    // series store keeps a short history of numeric properties for its sparkline
+    // column and the rate engine derives per-second rates of counters.
+    //
+    seriesStore = new SeriesStore(this);
+    connect(seriesStore, SIGNAL(limitReached(QString)), statusbar, SLOT(showMessage(QString)));
+    rateEngine = new RateEngine(this);
+    referenceIndex = new ReferenceIndex(this);
+    objectDetail = new ObjectDetailModel(seriesStore, rateEngine, referenceIndex, this);
+    objectDetailProxy = new TypedSortProxy(this);
+    objectDetailProxy->setSourceModel(objectDetail);
+    tableView_object->setModel(objectDetailProxy);
+    tableView_object->setSortingEnabled(true);
+    tableView_object->sortByColumn(0, Qt::AscendingOrder);
+    tableView_object->setItemDelegateForColumn(4, new SparklineDelegate(this));
+
+    //
+    // Create the class-table model which shows every instance of the selected schema class.
+    //
+    classTable = new ClassTableModel(objectModel, rateEngine, this);
+    tableView_class->setModel(classTable);
 
     //
     // Create the event detail model to hold the event properties
@@ -65,70 +146,356 @@ QmfExplorer::QmfExplorer(QMainWindow* parent) : QMainWindow(parent)
     eventDetail = new EventDetailModel(this);
 
     //
-    // Ctrate a proxy model to enable sorting by column
+    // Ctrate a proxy model to enable sorting by column.  The typed proxy sorts
+    // time stamps and severities by value rather than by their display text.
     //
-    eventtProxyModel = new QSortFilterProxyModel(this);
+    eventtProxyModel = new TypedSortProxy(this);
     eventtProxyModel->setSourceModel(eventDetail);
 
     tableView_events->setModel(eventtProxyModel);
     tableView_events->setSelectionBehavior(QAbstractItemView::SelectRows);
 
     //
-    // Create the thread object that maintains communication with the messaging plane.
+    // Every event is also kept in the on-disk journal, which the History view of
+    // the Events tab queries.
     //
-    qmf = new QmfThread(this, agentModel, lineEdit_agent_filter, objectModel);
-    qmf->start();
+    QSettings settings;
+    QString journalDir(settings.value("Events/journalDirectory",
+                                      QDesktopServices::storageLocation(QDesktopServices::DataLocation) +
+                                      "/events").toString());
+    eventJournal = new EventJournal(journalDir, this);
+    connect(eventJournal, SIGNAL(failed(QString)), statusbar, SLOT(showMessage(QString)));
+    eventJournal->start();
+    eventHistory = new EventHistoryModel(eventJournal, this);
+
+    comboBox_severity->addItem("Any severity", (int) qmf::SEV_DEBUG);
+    for (int severity = qmf::SEV_EMERG; severity <= qmf::SEV_INFORM; severity++)
+        comboBox_severity->addItem(EventDetailModel::severityName(severity) + " and above", severity);
+    dateTimeEdit_to->setDateTime(QDateTime::currentDateTime().addSecs(3600));
+    dateTimeEdit_from->setDateTime(QDateTime::currentDateTime().addDays(-1));
+    if (eventJournal->segmentCount() > 0)
+        tabWidget->setEnabled(true);
 
     //
-    // Create the open connection dialog box
+    // The aggregate view groups the same events so bursts collapse into a few rows.
     //
-    m_openDialog = new OpenDialog(this);
-    connect(m_openDialog, SIGNAL(openDialogAccepted(QString,QString,QString)), qmf, SLOT(connect_url(QString,QString,QString)));
+    eventAggregate = new EventAggregateModel(this);
+    eventAggregateProxy = new TypedSortProxy(this);
+    eventAggregateProxy->setSourceModel(eventAggregate);
+    comboBox_bucket->addItem("All time", 0);
+    comboBox_bucket->addItem("Per minute", 60);
+    comboBox_bucket->addItem("Per 5 minutes", 300);
+    comboBox_bucket->addItem("Per hour", 3600);
 
     //
-    // Linkage for the menu and the Connection Status label.
+    // The event-rate histogram sits below the events table.
     //
-    connect(qmf, SIGNAL(connectionStatusChanged(QString)), label_connection_status, SLOT(setText(QString)));
-    connect(actionOpen_Localhost, SIGNAL(triggered()), qmf, SLOT(connect_localhost()));
-    connect(actionClose, SIGNAL(triggered()), qmf, SLOT(disconnect()));
+    eventRates = new EventRateWidget(event_tab);
+    gridLayout_2->addWidget(eventRates, 3, 0);
+    eventRates->setThresholds(settings.value("Events/alertThresholds").toString());
+    lineEdit_thresholds->setText(settings.value("Events/alertThresholds").toString());
+
+    //
+    // Create the model listing method calls and their responses.
+    //
+    methodModel = new MethodResponseModel(this);
+    tableView_methods->setModel(methodModel);
+    connect(methodModel, SIGNAL(pendingChanged(int)), this, SLOT(methodsPending(int)));
+    connect(pushButton_clear_methods, SIGNAL(clicked()), methodModel, SLOT(clear()));
+    methodsPending(methodModel->pendingCount());
+
+    //
+    // Create the model holding the result of the last snapshot comparison.
+    //
+    diffModel = new DiffModel(this);
+    tableView_changes->setModel(diffModel);
+    snapshotDiff = 0;
+
+    //
+    // Create the search index over objects and events.  Typing in the search box
+    // re-runs the query after a short pause.
+    //
+    searchIndex = new SearchIndex(this);
+    searchPosition = 0;
+    searchTimer = new QTimer(this);
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(150);
+
+    //
+    // Create the open connection dialog box.  Each accepted dialog opens another
+    // broker connection alongside the ones already open.
+    //
+    m_openDialog = new OpenDialog(this);
+    statsDialog = new StatsDialog(agentModel, objectModel, eventDetail, searchIndex, seriesStore, rateEngine, this);
+    topologyView = new TopologyView(objectModel, referenceIndex, this);
+    connect(topologyView, SIGNAL(objectActivated(QString)), this, SLOT(showTopologyObject(QString)));
+    actionRecordTrace->setChecked(Trace::enabled);
+    snapshotWriter = 0;
+    connect(m_openDialog, SIGNAL(openDialogAccepted(QString,QString,QString)), this, SLOT(openBroker(QString,QString,QString)));
 
     //
-    // Linkage from the Agent Filter edit-box and button to the QMF thread
+    // Linkage for the menu.
     //
-    connect(pushButton_apply_filter, SIGNAL(pressed()), qmf, SLOT(applyAgentFilter()));
+    connect(actionOpen_Localhost, SIGNAL(triggered()), this, SLOT(openLocalhost()));
+    connect(actionClose, SIGNAL(triggered()), this, SLOT(closeBrokers()));
 
     //
     // Linkage for the Agent List tab components
     //
-    connect(qmf,             SIGNAL(newAgent(qmf::Agent)),     agentModel,  SLOT(addAgent(qmf::Agent)));
-    connect(qmf,             SIGNAL(delAgent(qmf::Agent)),     agentModel,  SLOT(delAgent(qmf::Agent)));
-    connect(qmf,             SIGNAL(isConnected(bool)),        agentModel,  SLOT(clear()));
-    connect(qmf,             SIGNAL(isConnected(bool)),        agentDetail, SLOT(clear()));
     connect(treeView_agents, SIGNAL(clicked(QModelIndex)),     agentModel,  SLOT(selected(QModelIndex)));
     connect(agentModel,      SIGNAL(instSelected(qmf::Agent)), agentDetail, SLOT(newAgent(qmf::Agent)));
+    connect(agentModel,      SIGNAL(attributesSelected(qpid::types::Variant::Map)),
+            agentDetail,     SLOT(newAttributes(qpid::types::Variant::Map)));
+    connect(agentModel,      SIGNAL(selectionCleared()),       agentDetail, SLOT(clear()));
+
+    //
+    // Linkage for Object tab components
+    //
+    connect(treeView_objects, SIGNAL(clicked(QModelIndex)), objectModel, SLOT(selected(QModelIndex)));
+    connect(comboBox_grouping, SIGNAL(currentIndexChanged(int)), this, SLOT(groupObjects(int)));
+    connect(objectModel, SIGNAL(instSelected(qmf::Data)), objectDetail, SLOT(newObject(qmf::Data)));
+    connect(objectModel, SIGNAL(classSelected(QString,QString)), classTable, SLOT(selectClass(QString,QString)));
+    connect(objectModel, SIGNAL(objectRemoved(qmf::Data)), referenceIndex, SLOT(delObject(qmf::Data)));
+    connect(objectModel, SIGNAL(objectRemoved(qmf::Data)), searchIndex, SLOT(delObject(qmf::Data)));
+    connect(objectModel, SIGNAL(objectRemoved(qmf::Data)), classTable, SLOT(delObject(qmf::Data)));
+    connect(objectModel, SIGNAL(objectRemoved(qmf::Data)), seriesStore, SLOT(delObject(qmf::Data)));
+    connect(objectModel, SIGNAL(objectRemoved(qmf::Data)), rateEngine, SLOT(delObject(qmf::Data)));
+    connect(tableView_class, SIGNAL(clicked(QModelIndex)), classTable, SLOT(selected(QModelIndex)));
+    connect(classTable, SIGNAL(instSelected(qmf::Data)), objectDetail, SLOT(newObject(qmf::Data)));
+    connect(treeView_objects, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(showObjectMenu(QPoint)));
+    connect(tableView_class, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(showClassMenu(QPoint)));
+    connect(tableView_changes, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(showChangedObject(QModelIndex)));
+    connect(tableView_object, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(followReference(QModelIndex)));
+    connect(referenceIndex, SIGNAL(referencesChanged(QString)), objectDetail, SLOT(referencesChanged(QString)));
+
+    //
+    // Linkage for the event history controls
+    //
+    connect(checkBox_history, SIGNAL(toggled(bool)), this, SLOT(showEventHistory(bool)));
+    connect(pushButton_history_query, SIGNAL(clicked()), this, SLOT(queryEventHistory()));
+    connect(lineEdit_event_class, SIGNAL(returnPressed()), this, SLOT(queryEventHistory()));
+    connect(checkBox_aggregate, SIGNAL(toggled(bool)), this, SLOT(showEventAggregate(bool)));
+    connect(checkBox_newest_first, SIGNAL(toggled(bool)), eventDetail, SLOT(setNewestFirst(bool)));
+    connect(lineEdit_aggregate_key, SIGNAL(editingFinished()), this, SLOT(regroupEvents()));
+    connect(comboBox_bucket, SIGNAL(currentIndexChanged(int)), this, SLOT(regroupEvents()));
+    connect(lineEdit_thresholds, SIGNAL(textChanged(QString)), eventRates, SLOT(setThresholds(QString)));
+    connect(eventRates, SIGNAL(thresholdExceeded(QString)), this, SLOT(eventRateAlert(QString)));
+
+    //
+    // Linkage for the search box
+    //
+    connect(eventDetail, SIGNAL(eventAdded(quint64,QString)), searchIndex, SLOT(addEvent(quint64,QString)));
+    connect(eventDetail, SIGNAL(eventAdded(quint64,QString)), this, SLOT(matchNewEvent(quint64,QString)));
+    connect(lineEdit_search, SIGNAL(textChanged(QString)), searchTimer, SLOT(start()));
+    connect(lineEdit_search, SIGNAL(returnPressed()), this, SLOT(nextSearchHit()));
+    connect(searchTimer, SIGNAL(timeout()), this, SLOT(runSearch()));
+
+    //
+    // Linkage for the agent filter.  Filters are checked here before any broker
+    // thread sees them.
+    //
+    connect(pushButton_apply_filter, SIGNAL(clicked()), this, SLOT(applyAgentFilter()));
+    connect(pushButton_save_filter, SIGNAL(clicked()), this, SLOT(saveFilterPreset()));
+    connect(pushButton_delete_filter, SIGNAL(clicked()), this, SLOT(deleteFilterPreset()));
+    connect(comboBox_filter_preset, SIGNAL(activated(int)), this, SLOT(selectFilterPreset(int)));
+    connect(tabWidget, SIGNAL(currentChanged(int)), this, SLOT(runSearch()));
+}
+
+
+void QmfExplorer::openBroker(const QString& url, const QString& connectionOptions, const QString& sessionOptions)
+{
+    //
+    // Connecting leaves a snapshot being viewed.
+    //
+    if (snapshotFile) {
+        snapshotFile.reset();
+        clearViews();
+        setSnapshotGrouping(false);
+    }
+
+    //
+    // Re-opening a known broker reuses its thread.
+    //
+    BrokerMap::iterator iter(brokers.find(url));
+    if (iter != brokers.end()) {
+        iter.value()->connect_url(url, connectionOptions, sessionOptions);
+        return;
+    }
+
+    //
+    // Create the thread object that maintains communication with this broker.  It
+    // is named after the URL so the models can group what it reports by broker.
+    //
+    QmfThread* qmf(new QmfThread(this, agentModel, objectModel));
+    qmf->setObjectName(url);
+    brokers[url] = qmf;
+
+    //
+    // Statistics are connected first so that delivery latency excludes the time
+    // spent in the models.
+    //
+    ExplorerStats::instance().watch(qmf);
+
+    //
+    // Linkage for the Connection Status label and the main-window components that
+    // depend on the connection status.
+    //
+    connect(qmf, SIGNAL(connectionStatusChanged(QString)), this, SLOT(brokerStatusChanged(QString)));
+    connect(qmf, SIGNAL(isConnected(bool)), this, SLOT(brokerConnectionChanged(bool)));
+
+    //
+    // Linkage for the Agent List tab components
+    //
+    connect(qmf, SIGNAL(newAgent(qmf::Agent)), agentModel,  SLOT(addAgent(qmf::Agent)));
+    connect(qmf, SIGNAL(delAgent(qmf::Agent)), agentModel,  SLOT(delAgent(qmf::Agent)));
+    connect(qmf, SIGNAL(agentLiveness(qmf::Agent, int, uint)), agentModel, SLOT(agentLiveness(qmf::Agent, int, uint)));
+    connect(qmf, SIGNAL(isConnected(bool)),    agentModel,  SLOT(brokerConnected(bool)));
+    connect(qmf, SIGNAL(resyncStarted()),      agentModel,  SLOT(beginResync()));
+    connect(qmf, SIGNAL(resyncFinished()),     agentModel,  SLOT(endResync()));
 
     //
     // Linkage for Object tab components
     //
     connect(qmf, SIGNAL(newPackage(QString)), objectModel, SLOT(addPackage(QString)));
     connect(qmf, SIGNAL(newClass(QStringList)), objectModel, SLOT(addClass(QStringList)));
+    connect(qmf, SIGNAL(isConnected(bool)), objectModel, SLOT(brokerConnected(bool)));
+    connect(qmf, SIGNAL(delAgent(qmf::Agent)), objectModel, SLOT(delAgent(qmf::Agent)));
+    connect(qmf, SIGNAL(resyncStarted()), objectModel, SLOT(beginResync()));
+    connect(qmf, SIGNAL(resyncFinished()), objectModel, SLOT(endResync()));
+    //
+    // The history and rate consumers are connected first so the models below see
+    // the derived values of an update when they repaint.
+    //
+    connect(qmf, SIGNAL(addObject(qmf::Data)), seriesStore, SLOT(addObject(qmf::Data)));
+    connect(qmf, SIGNAL(addObject(qmf::Data)), rateEngine, SLOT(addObject(qmf::Data)));
     connect(qmf, SIGNAL(addObject(qmf::Data)), objectModel, SLOT(addObject(qmf::Data)));
-    connect(treeView_objects, SIGNAL(clicked(QModelIndex)), objectModel, SLOT(selected(QModelIndex)));
-    connect(objectModel, SIGNAL(instSelected(qmf::Data)), objectDetail, SLOT(newObject(qmf::Data)));
+    connect(qmf, SIGNAL(addObject(qmf::Data)), referenceIndex, SLOT(addObject(qmf::Data)));
+    connect(qmf, SIGNAL(addObject(qmf::Data)), objectDetail, SLOT(updateObject(qmf::Data)));
+    connect(qmf, SIGNAL(addObject(qmf::Data)), classTable, SLOT(addObject(qmf::Data)));
+    connect(qmf, SIGNAL(addObject(qmf::Data)), searchIndex, SLOT(addObject(qmf::Data)));
 
     //
     // Linkage for the Event tab table
     //
     connect(qmf, SIGNAL(newEvent(qmf::ConsoleEvent)), eventDetail, SLOT(newEvent(qmf::ConsoleEvent)));
+    connect(qmf, SIGNAL(newEvent(qmf::ConsoleEvent)), eventJournal, SLOT(newEvent(qmf::ConsoleEvent)));
+    connect(qmf, SIGNAL(newEvent(qmf::ConsoleEvent)), eventAggregate, SLOT(newEvent(qmf::ConsoleEvent)));
     connect(qmf, SIGNAL(newEvent(qmf::ConsoleEvent)), tableView_events, SLOT(resizeColumnsToContents()));
 
     //
-    // Create linkages to enable and disable main-window components based on the connection status.
+    // Linkage for the Method Calls tab
     //
-    connect(qmf, SIGNAL(isConnected(bool)), tabWidget,            SLOT(setEnabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), actionOpen_Localhost, SLOT(setDisabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), actionOpen,           SLOT(setDisabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), actionClose,          SLOT(setEnabled(bool)));
+    connect(qmf, SIGNAL(methodResponse(quint64,bool,QVariantMap)), methodModel, SLOT(methodResponse(quint64,bool,QVariantMap)));
+
+    qmf->start();
+    qmf->connect_url(url, connectionOptions, sessionOptions);
+}
+
+
+void QmfExplorer::openLocalhost()
+{
+    openBroker("localhost", "", "{strict-security:False}");
+}
+
+
+void QmfExplorer::closeBrokers()
+{
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        iter.value()->disconnect();
+}
+
+
+void QmfExplorer::stopBrokers()
+{
+    //
+    // Closing is only queued to a thread, and what it emitted is still on its
+    // way to the models.  The threads are stopped and their queued updates
+    // delivered, so nothing of theirs arrives after the views are cleared.
+    //
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        iter.value()->cancel();
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        iter.value()->wait();
+    QCoreApplication::sendPostedEvents(0, QEvent::MetaCall);
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        delete iter.value();
+
+    brokers.clear();
+    brokerStatus.clear();
+    connectedBrokers.clear();
+    label_connection_status->setText("Closed");
+    actionClose->setEnabled(false);
+    actionOpen_Localhost->setEnabled(true);
+}
+
+
+void QmfExplorer::clearViews()
+{
+    agentModel->clear();
+    agentDetail->clear();
+    objectModel->clear();
+    objectDetail->clear();
+    classTable->clear();
+    referenceIndex->clear();
+    searchIndex->clear();
+    seriesStore->clear();
+    rateEngine->clear();
+    eventDetail->clear();
+    eventAggregate->clear();
+    methodModel->clear();
+    runSearch();
+}
+
+
+void QmfExplorer::setSnapshotGrouping(bool snapshot)
+{
+    //
+    // A snapshot is always grouped by package.  The live choice is kept by the
+    // object model and shown again once the snapshot is left.
+    //
+    int grouping(snapshot ? (int) ObjectModel::GROUP_PACKAGE : (int) objectModel->grouping());
+    comboBox_grouping->blockSignals(true);
+    comboBox_grouping->setCurrentIndex(qMax(0, comboBox_grouping->findData(grouping)));
+    comboBox_grouping->blockSignals(false);
+    comboBox_grouping->setEnabled(!snapshot);
+}
+
+
+void QmfExplorer::brokerStatusChanged(const QString& status)
+{
+    //
+    // The label shows the status of every broker, one after another.
+    //
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+    brokerStatus[QString(broker.c_str())] = status;
+
+    QStringList text;
+    for (QMap<QString, QString>::const_iterator iter = brokerStatus.begin(); iter != brokerStatus.end(); iter++)
+        text << (brokers.size() > 1 ? iter.key() + ": " + iter.value() : iter.value());
+    label_connection_status->setText(text.join("   "));
+}
+
+
+void QmfExplorer::brokerConnectionChanged(bool isConnected)
+{
+    QString broker(QmfThread::brokerName(sender()).c_str());
+    if (broker.isEmpty())
+        return;
+    if (isConnected)
+        connectedBrokers.insert(broker);
+    else
+        connectedBrokers.remove(broker);
+
+    //
+    // The tabs and Close stay enabled while any broker is connected, or a snapshot
+    // or journaled events are viewed.  Open stays available so further brokers can
+    // be added.
+    //
+    tabWidget->setEnabled(!connectedBrokers.isEmpty() || snapshotFile || eventJournal->segmentCount() > 0);
+    actionClose->setEnabled(!connectedBrokers.isEmpty());
+    actionOpen_Localhost->setDisabled(connectedBrokers.contains("localhost"));
 }
 
 void QmfExplorer::init(int argc, char *argv[])
@@ -144,20 +511,192 @@ void QmfExplorer::init(int argc, char *argv[])
     if (argc > 3)
         sessionOptions = QString(argv[3]);
 
-    qmf->connect_url(url, connectionOptions, sessionOptions);
+    openBroker(url, connectionOptions, sessionOptions);
 }
 
 QmfExplorer::~QmfExplorer()
 {
-    qmf->cancel();
-    qmf->wait();
-    delete qmf;
+    if (snapshotWriter) {
+        snapshotWriter->cancel();
+        snapshotWriter->wait();
+    }
+    if (snapshotDiff) {
+        snapshotDiff->cancel();
+        snapshotDiff->wait();
+    }
+
+    //
+    // The journal writes out what is queued before the sessions go away.
+    //
+    eventJournal->stop();
+    eventJournal->wait();
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        iter.value()->cancel();
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++) {
+        iter.value()->wait();
+        delete iter.value();
+    }
+
+    //
+    // The QMF threads hand their last closes to helper threads; give those, and
+    // any opens still in connect, a moment to finish before qpid goes away.
+    //
+    SessionOpener::waitAll(SHUTDOWN_GRACE);
+}
+
+
+static void stopHeadless(int)
+{
+    HeadlessMonitor::requestStop();
+}
+
+
+//
+// Run without any widgets: connect to the broker and stream every agent, object
+// and event update as line-delimited JSON.
+//
+//   qmfe --headless [--output FILE] [--poll SECONDS] [--connect-timeout SECONDS] [--stats SECONDS]
+//                   [--trace FILE] [--agent-filter PREDICATE] [--broker URL]...
+//                   [URL [CONNECTION-OPTIONS [QMF-OPTIONS]]]
+//
+// Each --broker adds another broker, opened with the same options as the first.
+// Without --agent-filter the filter last applied in the GUI is used.
+// With --trace, trace points are recorded and written to FILE as Chrome Trace
+// JSON on exit.
+//
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    initApplication();
+
+    QString url("localhost");
+    QStringList extraUrls;
+    QString connectionOptions;
+    QString sessionOptions("{strict-security:False}");
+    const char* outputFile(0);
+    const char* traceFile(0);
+    const char* agentFilter(0);
+    int pollInterval(-1);
+    int connectTimeout(-1);
+    int statsInterval(-1);
+    int positional(0);
+
+    for (int idx = 1; idx < argc; idx++) {
+        if (std::strcmp(argv[idx], "--headless") == 0)
+            continue;
+        if (std::strcmp(argv[idx], "--output") == 0 && idx + 1 < argc)
+            outputFile = argv[++idx];
+        else if (std::strcmp(argv[idx], "--poll") == 0 && idx + 1 < argc)
+            pollInterval = std::atoi(argv[++idx]);
+        else if (std::strcmp(argv[idx], "--connect-timeout") == 0 && idx + 1 < argc)
+            connectTimeout = std::atoi(argv[++idx]);
+        else if (std::strcmp(argv[idx], "--stats") == 0 && idx + 1 < argc)
+            statsInterval = std::atoi(argv[++idx]);
+        else if (std::strcmp(argv[idx], "--trace") == 0 && idx + 1 < argc)
+            traceFile = argv[++idx];
+        else if (std::strcmp(argv[idx], "--agent-filter") == 0 && idx + 1 < argc)
+            agentFilter = argv[++idx];
+        else if (std::strcmp(argv[idx], "--broker") == 0 && idx + 1 < argc)
+            extraUrls << QString(argv[++idx]);
+        else {
+            switch (positional++) {
+            case 0: url = QString(argv[idx]); break;
+            case 1: connectionOptions = QString(argv[idx]); break;
+            case 2: sessionOptions = QString(argv[idx]); break;
+            }
+        }
+    }
+
+    QString error;
+    if (agentFilter && !AgentFilter::validate(agentFilter, error)) {
+        std::cerr << "Invalid agent filter: " << error.toStdString() << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (outputFile) {
+        file.open(outputFile, std::ios::out | std::ios::app);
+        if (!file) {
+            std::cerr << "Cannot open output file " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out(outputFile ? (std::ostream&) file : std::cout);
+
+    if (traceFile)
+        Trace::enable(true);
+
+    std::signal(SIGINT, stopHeadless);
+    std::signal(SIGTERM, stopHeadless);
+
+    //
+    // No models are created in this mode; the monitor writes each update as it
+    // arrives and only the rate engine keeps per-object state.
+    //
+    RateEngine* rateEngine(new RateEngine(&app));
+    HeadlessMonitor monitor(out, rateEngine);
+    if (statsInterval >= 0)
+        monitor.setStatsInterval(statsInterval);
+
+    QStringList urls;
+    if (positional > 0 || extraUrls.isEmpty())
+        urls << url;
+    urls << extraUrls;
+    urls.removeDuplicates();
+
+    QList<QmfThread*> threads;
+    for (QStringList::const_iterator iter = urls.begin(); iter != urls.end(); iter++) {
+        QmfThread* qmf(new QmfThread(&app, 0, 0));
+        qmf->setObjectName(*iter);
+        ExplorerStats::instance().watch(qmf);
+        if (pollInterval >= 0)
+            qmf->setPollInterval(pollInterval);
+        if (connectTimeout >= 0)
+            qmf->setConnectTimeout(connectTimeout);
+        if (agentFilter)
+            qmf->setAgentFilter(agentFilter);
+
+        QObject::connect(qmf, SIGNAL(connectionStatusChanged(QString)), &monitor, SLOT(connectionStatusChanged(QString)));
+        QObject::connect(qmf, SIGNAL(newAgent(qmf::Agent)), &monitor, SLOT(newAgent(qmf::Agent)));
+        QObject::connect(qmf, SIGNAL(delAgent(qmf::Agent)), &monitor, SLOT(delAgent(qmf::Agent)));
+        QObject::connect(qmf, SIGNAL(addObject(qmf::Data)), rateEngine, SLOT(addObject(qmf::Data)));
+        QObject::connect(qmf, SIGNAL(addObject(qmf::Data)), &monitor, SLOT(addObject(qmf::Data)));
+        QObject::connect(qmf, SIGNAL(newEvent(qmf::ConsoleEvent)), &monitor, SLOT(newEvent(qmf::ConsoleEvent)));
+
+        qmf->start();
+        qmf->connect_url(*iter, connectionOptions, sessionOptions);
+        threads << qmf;
+    }
+
+    int result(app.exec());
+
+    for (QList<QmfThread*>::const_iterator iter = threads.begin(); iter != threads.end(); iter++)
+        (*iter)->cancel();
+    for (QList<QmfThread*>::const_iterator iter = threads.begin(); iter != threads.end(); iter++)
+        (*iter)->wait();
+    SessionOpener::waitAll(SHUTDOWN_GRACE);
+    out.flush();
+
+    if (traceFile) {
+        std::ofstream trace(traceFile);
+        if (trace)
+            Trace::exportChrome(trace);
+        else
+            std::cerr << "Cannot open trace file " << traceFile << std::endl;
+    }
+    return result;
 }
 
 
 int main(int argc, char *argv[])
 {
+    for (int idx = 1; idx < argc; idx++)
+        if (std::strcmp(argv[idx], "--headless") == 0)
+            return runHeadless(argc, argv);
+
     QApplication app(argc, argv);
+    initApplication();
+
     QMainWindow *window = new QMainWindow;
     QmfExplorer qe(window);
 
@@ -167,9 +706,597 @@ int main(int argc, char *argv[])
     return app.exec();
 }
 
+void QmfExplorer::runSearch()
+{
+    QString text(lineEdit_search->text());
+
+    searchHits.clear();
+    searchPosition = 0;
+    eventSearch.clear();
+
+    if (text.trimmed().isEmpty()) {
+        eventtProxyModel->clearKeyFilter();
+        return;
+    }
+
+    searchIndex->query(text, searchHits);
+
+    //
+    // On the Events tab the table is filtered down to the matching events.  On the
+    // Objects tab the first matching object is selected; Return moves to the next.
+    //
+    if (tabWidget->currentWidget() == event_tab) {
+        QSet<quint64> sequences;
+        for (SearchIndex::HitList::const_iterator iter = searchHits.begin(); iter != searchHits.end(); iter++)
+            if (iter->type == SearchIndex::HIT_EVENT)
+                sequences.insert(iter->sequence);
+        eventtProxyModel->setKeyFilter(EventDetailModel::SequenceRole, sequences);
+        eventSearch = text;
+    } else if (tabWidget->currentWidget() == object_tab) {
+        eventtProxyModel->clearKeyFilter();
+        showObjectHit();
+    }
+}
+
+
+void QmfExplorer::matchNewEvent(quint64 sequence, const QString& text)
+{
+    //
+    // Events arriving while the table is filtered join it when they match.  This
+    // runs while the row is being inserted, so the proxy places it as it goes in.
+    //
+    if (!eventSearch.isEmpty() && eventtProxyModel->keyFilterEnabled() && SearchIndex::matches(eventSearch, text))
+        eventtProxyModel->acceptKey(sequence);
+}
+
+
+void QmfExplorer::nextSearchHit()
+{
+    if (searchHits.empty())
+        return;
+    searchPosition++;
+    showObjectHit();
+}
+
+
+void QmfExplorer::showObjectHit()
+{
+    for (size_t count = 0; count < searchHits.size(); count++, searchPosition++) {
+        if (searchPosition >= searchHits.size())
+            searchPosition = 0;
+        const SearchIndex::Hit& hit(searchHits[searchPosition]);
+        if (hit.type != SearchIndex::HIT_OBJECT)
+            continue;
+
+        QModelIndex index(objectModel->indexForObject(hit.key));
+        if (!index.isValid())
+            continue;
+
+        treeView_objects->setCurrentIndex(index);
+        treeView_objects->scrollTo(index);
+        objectModel->selected(index);
+        return;
+    }
+}
+
+
 void QmfExplorer::on_actionOpen_triggered()
 {
     if (m_openDialog) {
         m_openDialog->exec();
     }
 }
+
+
+void QmfExplorer::showObjectMenu(const QPoint& pos)
+{
+    qmf::Data object(objectModel->objectAt(treeView_objects->indexAt(pos)));
+    if (!object.isValid())
+        return;
+
+    QMenu menu(this);
+    QAction* call(menu.addAction("Call Method..."));
+    if (menu.exec(treeView_objects->viewport()->mapToGlobal(pos)) == call)
+        callMethod(std::vector<qmf::Data>(1, object));
+}
+
+
+void QmfExplorer::showClassMenu(const QPoint& pos)
+{
+    std::vector<qmf::Data> objects;
+    QModelIndexList rows(tableView_class->selectionModel()->selectedRows());
+    for (QModelIndexList::const_iterator iter = rows.begin(); iter != rows.end(); iter++) {
+        qmf::Data object(classTable->objectAt(*iter));
+        if (object.isValid())
+            objects.push_back(object);
+    }
+    if (objects.empty())
+        return;
+
+    QMenu menu(this);
+    QAction* call(menu.addAction(objects.size() == 1 ? QString("Call Method...") :
+                                 QString("Call Method on %1 Objects...").arg(objects.size())));
+    if (menu.exec(tableView_class->viewport()->mapToGlobal(pos)) == call)
+        callMethod(objects);
+}
+
+
+//
+// Parse "name=value, name=value" into method arguments.  Values that read as
+// booleans or numbers are passed as such, anything else as a string.
+//
+static bool parseArguments(const QString& text, qpid::types::Variant::Map& args)
+{
+    QStringList pairs(text.split(',', QString::SkipEmptyParts));
+    for (QStringList::const_iterator iter = pairs.begin(); iter != pairs.end(); iter++) {
+        int equals(iter->indexOf('='));
+        if (equals <= 0)
+            return false;
+
+        std::string name(iter->left(equals).trimmed().toStdString());
+        QString value(iter->mid(equals + 1).trimmed());
+        bool ok;
+
+        if (value == "true" || value == "false") {
+            args[name] = value == "true";
+            continue;
+        }
+        qlonglong integer(value.toLongLong(&ok));
+        if (ok) {
+            args[name] = (int64_t) integer;
+            continue;
+        }
+        double real(value.toDouble(&ok));
+        if (ok) {
+            args[name] = real;
+            continue;
+        }
+        if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"'))
+            value = value.mid(1, value.size() - 2);
+        args[name] = value.toStdString();
+    }
+    return true;
+}
+
+
+void QmfExplorer::callMethod(const std::vector<qmf::Data>& objects)
+{
+    QSettings settings;
+    QStringList methods(settings.value("Methods/recent").toStringList());
+    for (const char** name = DEFAULT_METHODS; *name; name++)
+        if (!methods.contains(*name))
+            methods << *name;
+
+    bool ok;
+    QString method(QInputDialog::getItem(this, "Call Method", "Method:", methods, 0, true, &ok).trimmed());
+    if (!ok || method.isEmpty())
+        return;
+
+    qpid::types::Variant::Map args;
+    QString argText(QInputDialog::getText(this, "Call Method", "Arguments (name=value, ...):",
+                                          QLineEdit::Normal, QString(), &ok));
+    if (!ok)
+        return;
+    if (!parseArguments(argText, args)) {
+        QMessageBox::warning(this, "Call Method", "Arguments must be given as name=value pairs.");
+        return;
+    }
+
+    methods.removeAll(method);
+    methods.prepend(method);
+    settings.setValue("Methods/recent", QStringList(methods.mid(0, 20)));
+    int timeout(settings.value("Methods/timeout", DEFAULT_METHOD_TIMEOUT).toInt());
+
+    //
+    // Every call is queued at once.  Each goes to the broker that knows its agent
+    // and they are all outstanding together.
+    //
+    for (std::vector<qmf::Data>::const_iterator iter = objects.begin(); iter != objects.end(); iter++) {
+        std::string agentName(iter->getAddr().getAgentName());
+        quint64 id(methodModel->addCall(QString(ObjectModel::objectKey(*iter).c_str()), method));
+
+        QmfThread* target(0);
+        for (BrokerMap::const_iterator biter = brokers.begin(); biter != brokers.end() && !target; biter++)
+            if (biter.value()->hasAgent(agentName))
+                target = biter.value();
+
+        if (target)
+            target->callMethod(id, *iter, method.toStdString(), args, timeout);
+        else {
+            QVariantMap error;
+            error["error"] = QString("agent not connected");
+            methodModel->methodResponse(id, false, error);
+        }
+    }
+
+    tabWidget->setCurrentWidget(method_tab);
+}
+
+
+void QmfExplorer::methodsPending(int count)
+{
+    if (count == 0)
+        label_methods_pending->setText("No calls pending");
+    else
+        label_methods_pending->setText(QString("%1 call%2 pending").arg(count).arg(count == 1 ? "" : "s"));
+}
+
+
+void QmfExplorer::on_actionStatistics_triggered()
+{
+    statsDialog->show();
+    statsDialog->raise();
+}
+
+
+void QmfExplorer::on_actionTopology_triggered()
+{
+    topologyView->show();
+    topologyView->raise();
+}
+
+
+void QmfExplorer::showTopologyObject(const QString& key)
+{
+    showObject(key.toStdString());
+}
+
+
+void QmfExplorer::on_actionRecordTrace_toggled(bool on)
+{
+    if (on && !Trace::enabled)
+        Trace::clear();
+    Trace::enable(on);
+}
+
+
+void QmfExplorer::on_actionExportTrace_triggered()
+{
+    QString fileName(QFileDialog::getSaveFileName(this, "Export Trace", "qmfe-trace.json",
+                                                  "Chrome Trace (*.json)"));
+    if (fileName.isEmpty())
+        return;
+
+    std::ofstream file(fileName.toLocal8Bit().constData());
+    if (!file) {
+        QMessageBox::warning(this, "Export Trace", "Cannot write " + fileName);
+        return;
+    }
+    Trace::exportChrome(file);
+}
+
+
+SnapshotFilePtr QmfExplorer::openSnapshotFile(const QString& title)
+{
+    QString fileName(QFileDialog::getOpenFileName(this, title, QString(),
+                                                  "Snapshots (*.ndjson);;All Files (*)"));
+    if (fileName.isEmpty())
+        return SnapshotFilePtr();
+
+    SnapshotFilePtr file(new SnapshotFile());
+    QString error;
+    if (!file->open(fileName, error)) {
+        QMessageBox::warning(this, title, error);
+        return SnapshotFilePtr();
+    }
+    return file;
+}
+
+
+void QmfExplorer::on_actionOpenSnapshot_triggered()
+{
+    SnapshotFilePtr file(openSnapshotFile("Open Snapshot"));
+    if (!file)
+        return;
+    QString fileName(file->fileName());
+
+    //
+    // A snapshot is viewed on its own, so live connections are stopped and
+    // everything they reported is cleared first.  The trees then hold the file's
+    // classes and agents; objects are read from the mapped file as classes are
+    // expanded and rows selected.
+    //
+    stopBrokers();
+    clearViews();
+    snapshotFile = file;
+    agentModel->loadSnapshot(*file);
+    objectModel->loadSnapshot(file);
+    setSnapshotGrouping(true);
+    tabWidget->setEnabled(true);
+
+    statusbar->showMessage(QString("Viewing %1: %2 objects from %3")
+                           .arg(QFileInfo(fileName).fileName()).arg(file->objectCount())
+                           .arg(QDateTime::fromMSecsSinceEpoch(file->time()).toString()));
+}
+
+
+void QmfExplorer::on_actionExportSnapshot_triggered()
+{
+    if (snapshotWriter)
+        return;
+
+    QString fileName(QFileDialog::getSaveFileName(this, "Export Snapshot", "qmfe-snapshot.ndjson",
+                                                  "Snapshots (*.ndjson)"));
+    if (fileName.isEmpty())
+        return;
+
+    //
+    // The models are copied (by handle) here; the file is written on the
+    // writer's own thread.
+    //
+    snapshotWriter = new SnapshotWriter(fileName, agentModel, objectModel, this);
+    connect(snapshotWriter, SIGNAL(progress(int,int)), this, SLOT(snapshotProgress(int,int)));
+    connect(snapshotWriter, SIGNAL(done(bool,QString)), this, SLOT(snapshotDone(bool,QString)));
+    actionExportSnapshot->setEnabled(false);
+    snapshotWriter->start();
+}
+
+
+void QmfExplorer::snapshotProgress(int written, int total)
+{
+    statusbar->showMessage(QString("Exporting snapshot: %1 of %2 objects").arg(written).arg(total));
+}
+
+
+void QmfExplorer::snapshotDone(bool succeeded, const QString& message)
+{
+    statusbar->showMessage(message, 10000);
+    if (!succeeded)
+        QMessageBox::warning(this, "Export Snapshot", message);
+
+    snapshotWriter->wait();
+    snapshotWriter->deleteLater();
+    snapshotWriter = 0;
+    actionExportSnapshot->setEnabled(true);
+}
+
+
+void QmfExplorer::on_actionCompareSnapshots_triggered()
+{
+    if (snapshotDiff)
+        return;
+    SnapshotFilePtr before(openSnapshotFile("Compare Snapshots: Before"));
+    if (!before)
+        return;
+    SnapshotFilePtr after(openSnapshotFile("Compare Snapshots: After"));
+    if (!after)
+        return;
+    startDiff(new SnapshotDiff(before, after, this));
+}
+
+
+void QmfExplorer::on_actionCompareCurrent_triggered()
+{
+    if (snapshotDiff)
+        return;
+    SnapshotFilePtr before(openSnapshotFile("Compare Snapshot with Current"));
+    if (!before)
+        return;
+    startDiff(new SnapshotDiff(before, objectModel, this));
+}
+
+
+void QmfExplorer::startDiff(SnapshotDiff* diff)
+{
+    snapshotDiff = diff;
+    connect(snapshotDiff, SIGNAL(progress(int)), this, SLOT(diffProgress(int)));
+    connect(snapshotDiff, SIGNAL(done(bool,QString)), this, SLOT(diffDone(bool,QString)));
+    actionCompareSnapshots->setEnabled(false);
+    actionCompareCurrent->setEnabled(false);
+    snapshotDiff->start();
+}
+
+
+void QmfExplorer::diffProgress(int percent)
+{
+    statusbar->showMessage(QString("Comparing snapshots: %1%").arg(percent));
+}
+
+
+void QmfExplorer::diffDone(bool succeeded, const QString& message)
+{
+    statusbar->showMessage(message, 10000);
+    snapshotDiff->wait();
+    if (succeeded) {
+        SnapshotDiff::ChangeList changes;
+        snapshotDiff->takeChanges(changes);
+        diffModel->setChanges(changes);
+        tabWidget->setEnabled(true);
+        tabWidget->setCurrentWidget(changes_tab);
+        tableView_changes->resizeColumnsToContents();
+    } else
+        QMessageBox::warning(this, "Compare Snapshots", message);
+
+    snapshotDiff->deleteLater();
+    snapshotDiff = 0;
+    actionCompareSnapshots->setEnabled(true);
+    actionCompareCurrent->setEnabled(true);
+}
+
+
+void QmfExplorer::showChangedObject(const QModelIndex& index)
+{
+    showObject(diffModel->keyAt(index));
+}
+
+
+void QmfExplorer::followReference(const QModelIndex& index)
+{
+    //
+    // A reference property or a "referenced by" row leads to the other object.
+    //
+    std::string key(objectDetail->linkAt(objectDetailProxy->mapToSource(index).row()));
+    if (!key.empty())
+        showObject(key);
+}
+
+
+void QmfExplorer::showObject(const std::string& key)
+{
+    //
+    // Jump to the object in the tree, when it is there (removed objects are not).
+    //
+    QModelIndex object(objectModel->indexForObject(key));
+    if (!object.isValid())
+        return;
+    tabWidget->setCurrentWidget(object_tab);
+    treeView_objects->setCurrentIndex(object);
+    treeView_objects->scrollTo(object);
+    objectModel->selected(object);
+}
+
+
+void QmfExplorer::updateEventView()
+{
+    //
+    // The table shows the live events, the result of a journal query or the
+    // aggregated groups.  Journal results are in journal order and are not sorted;
+    // the live events stay in arrival order until a column is chosen to sort by.
+    //
+    if (checkBox_history->isChecked())
+        tableView_events->setModel(eventHistory);
+    else
+        tableView_events->setModel(checkBox_aggregate->isChecked() ? eventAggregateProxy : eventtProxyModel);
+    tableView_events->resizeColumnsToContents();
+}
+
+
+void QmfExplorer::showEventHistory(bool history)
+{
+    if (history)
+        checkBox_aggregate->setChecked(false);
+    updateEventView();
+    if (history)
+        queryEventHistory();
+}
+
+
+void QmfExplorer::showEventAggregate(bool aggregate)
+{
+    if (aggregate)
+        checkBox_history->setChecked(false);
+    updateEventView();
+}
+
+
+void QmfExplorer::regroupEvents()
+{
+    //
+    // Groups cannot be split or merged after the fact, so a new grouping starts
+    // counting afresh.
+    //
+    eventAggregate->setGrouping(lineEdit_aggregate_key->text(),
+                                comboBox_bucket->itemData(comboBox_bucket->currentIndex()).toInt());
+}
+
+
+void QmfExplorer::queryEventHistory()
+{
+    if (!checkBox_history->isChecked()) {
+        checkBox_history->setChecked(true);
+        return;
+    }
+
+    EventJournal::Query query;
+    query.from = dateTimeEdit_from->dateTime().toMSecsSinceEpoch();
+    query.to = dateTimeEdit_to->dateTime().toMSecsSinceEpoch();
+    query.maxSeverity = comboBox_severity->itemData(comboBox_severity->currentIndex()).toInt();
+    query.className = lineEdit_event_class->text().trimmed().toStdString();
+
+    QElapsedTimer timer;
+    timer.start();
+    eventHistory->setQuery(query);
+    tableView_events->resizeColumnsToContents();
+    statusbar->showMessage(QString("History: first %1 events in %2 ms")
+                           .arg(eventHistory->rowCount()).arg(timer.elapsed()), 10000);
+}
+
+
+void QmfExplorer::eventRateAlert(const QString& message)
+{
+    statusbar->showMessage(message, 10000);
+    QApplication::alert(this);
+}
+
+
+void QmfExplorer::groupObjects(int index)
+{
+    int grouping(comboBox_grouping->itemData(index).toInt());
+    objectModel->setGrouping(grouping);
+
+    QSettings settings;
+    settings.setValue("Objects/grouping", grouping);
+}
+
+
+void QmfExplorer::loadFilterPresets()
+{
+    AgentFilter::PresetMap presets(AgentFilter::presets());
+    comboBox_filter_preset->clear();
+    for (AgentFilter::PresetMap::const_iterator iter = presets.begin(); iter != presets.end(); iter++)
+        comboBox_filter_preset->addItem(iter.key(), iter.value());
+    comboBox_filter_preset->setCurrentIndex(comboBox_filter_preset->findData(lineEdit_agent_filter->text().trimmed()));
+}
+
+
+void QmfExplorer::applyAgentFilter()
+{
+    QString filter(lineEdit_agent_filter->text().trimmed());
+    QString error;
+    if (!AgentFilter::validate(filter, error)) {
+        QMessageBox::warning(this, "Agent Filter", "Invalid agent filter: " + error);
+        return;
+    }
+
+    AgentFilter::setCurrent(filter);
+    for (BrokerMap::iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        iter.value()->setAgentFilter(filter);
+
+    comboBox_filter_preset->setCurrentIndex(comboBox_filter_preset->findData(filter));
+    statusbar->showMessage(filter.isEmpty() ? QString("Showing all agents") : "Agent filter: " + filter, 5000);
+}
+
+
+void QmfExplorer::selectFilterPreset(int index)
+{
+    if (index < 0)
+        return;
+    lineEdit_agent_filter->setText(comboBox_filter_preset->itemData(index).toString());
+    applyAgentFilter();
+}
+
+
+void QmfExplorer::saveFilterPreset()
+{
+    QString filter(lineEdit_agent_filter->text().trimmed());
+    QString error;
+    if (!AgentFilter::validate(filter, error)) {
+        QMessageBox::warning(this, "Agent Filter", "Invalid agent filter: " + error);
+        return;
+    }
+
+    bool ok;
+    QString name(QInputDialog::getText(this, "Save Agent Filter", "Preset name:", QLineEdit::Normal,
+                                       comboBox_filter_preset->currentText(), &ok).trimmed());
+    if (!ok || name.isEmpty())
+        return;
+
+    AgentFilter::PresetMap presets(AgentFilter::presets());
+    presets[name] = filter;
+    AgentFilter::savePresets(presets);
+    loadFilterPresets();
+}
+
+
+void QmfExplorer::deleteFilterPreset()
+{
+    int index(comboBox_filter_preset->currentIndex());
+    if (index < 0)
+        return;
+
+    AgentFilter::PresetMap presets(AgentFilter::presets());
+    presets.remove(comboBox_filter_preset->itemText(index));
+    AgentFilter::savePresets(presets);
+    loadFilterPresets();
+}
+
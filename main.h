@@ -27,7 +27,27 @@
 #include "object-model.h"
 #include "agent-detail-model.h"
 #include "object-detail-model.h"
+#include "class-table-model.h"
+#include "typed-sort-proxy.h"
+#include "search-index.h"
+#include "series-store.h"
+#include "rate-engine.h"
+#include "sparkline-delegate.h"
 #include "event-detail-model.h"
+#include "method-response-model.h"
+#include "stats-dialog.h"
+#include "snapshot-writer.h"
+#include "snapshot-file.h"
+#include "snapshot-diff.h"
+#include "diff-model.h"
+#include "event-journal.h"
+#include "event-history-model.h"
+#include "event-aggregate-model.h"
+#include "event-rate-widget.h"
+#include "agent-filter.h"
+#include "reference-index.h"
+#include "topology-view.h"
+#include <vector>
 
 class QmfExplorer : public QMainWindow, private Ui::MainWindow {
     Q_OBJECT
@@ -39,24 +59,100 @@ public:
     void init(int argc, char *argv[]);
 
 public slots:
+    void openBroker(const QString&, const QString&, const QString&);
+    void openLocalhost();
+    void closeBrokers();
 
 private:
-    QmfThread* qmf;
+    //
+    // One thread per broker connection, keyed by the broker URL.
+    //
+    typedef QMap<QString, QmfThread*> BrokerMap;
+    BrokerMap brokers;
+    QMap<QString, QString> brokerStatus;
+    QSet<QString> connectedBrokers;
 
     AgentModel* agentModel;
     AgentDetailModel* agentDetail;
 
     ObjectModel* objectModel;
     ObjectDetailModel* objectDetail;
+    SeriesStore* seriesStore;
+    RateEngine* rateEngine;
+    TypedSortProxy* objectDetailProxy;
+    ClassTableModel* classTable;
+    ReferenceIndex* referenceIndex;
 
     EventDetailModel* eventDetail;
-    QSortFilterProxyModel* eventtProxyModel;
+    TypedSortProxy* eventtProxyModel;
+    EventJournal* eventJournal;
+    EventHistoryModel* eventHistory;
+    EventAggregateModel* eventAggregate;
+    TypedSortProxy* eventAggregateProxy;
+    EventRateWidget* eventRates;
+
+    MethodResponseModel* methodModel;
 
     OpenDialog* m_openDialog;
+    StatsDialog* statsDialog;
+    TopologyView* topologyView;
+    SnapshotWriter* snapshotWriter;
+    SnapshotFilePtr snapshotFile;
+    SnapshotDiff* snapshotDiff;
+    DiffModel* diffModel;
+
+    SearchIndex* searchIndex;
+    SearchIndex::HitList searchHits;
+    size_t searchPosition;
+    QString eventSearch;
+    QTimer* searchTimer;
 
+    void stopBrokers();
+    void clearViews();
+    void setSnapshotGrouping(bool);
+    void showObjectHit();
+    void showObject(const std::string&);
+    void updateEventView();
+    void callMethod(const std::vector<qmf::Data>&);
+    SnapshotFilePtr openSnapshotFile(const QString&);
+    void startDiff(SnapshotDiff*);
+    void loadFilterPresets();
 
 private slots:
     void on_actionOpen_triggered();
+    void on_actionStatistics_triggered();
+    void on_actionTopology_triggered();
+    void methodsPending(int);
+    void on_actionRecordTrace_toggled(bool);
+    void on_actionExportTrace_triggered();
+    void on_actionOpenSnapshot_triggered();
+    void on_actionExportSnapshot_triggered();
+    void snapshotProgress(int, int);
+    void snapshotDone(bool, const QString&);
+    void on_actionCompareSnapshots_triggered();
+    void on_actionCompareCurrent_triggered();
+    void diffProgress(int);
+    void diffDone(bool, const QString&);
+    void showChangedObject(const QModelIndex&);
+    void followReference(const QModelIndex&);
+    void showTopologyObject(const QString&);
+    void showEventHistory(bool);
+    void queryEventHistory();
+    void showEventAggregate(bool);
+    void regroupEvents();
+    void eventRateAlert(const QString&);
+    void groupObjects(int);
+    void applyAgentFilter();
+    void selectFilterPreset(int);
+    void saveFilterPreset();
+    void deleteFilterPreset();
+    void brokerStatusChanged(const QString&);
+    void brokerConnectionChanged(bool);
+    void showObjectMenu(const QPoint&);
+    void showClassMenu(const QPoint&);
+    void runSearch();
+    void nextSearchHit();
+    void matchNewEvent(quint64, const QString&);
 };
 
 #endif
@@ -0,0 +1,178 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "method-response-model.h"
+#include <QColor>
+
+MethodResponseModel::MethodResponseModel(QObject* parent) :
+    QAbstractItemModel(parent), nextId(1), pending(0)
+{
+    // Intentionally Left Blank
+}
+
+
+quint64 MethodResponseModel::addCall(const QString& object, const QString& method)
+{
+    Call call;
+    call.id = nextId++;
+    call.object = object;
+    call.method = method;
+    call.state = CALL_PENDING;
+    call.elapsed = 0;
+    call.timer.start();
+
+    beginInsertRows(QModelIndex(), calls.size(), calls.size());
+    rowsById[call.id] = calls.size();
+    calls.append(call);
+    pending++;
+    endInsertRows();
+    emit pendingChanged(pending);
+
+    return call.id;
+}
+
+
+void MethodResponseModel::methodResponse(quint64 id, bool succeeded, const QVariantMap& results)
+{
+    QHash<quint64, int>::const_iterator iter(rowsById.find(id));
+    if (iter == rowsById.end())
+        return;
+
+    int row(iter.value());
+    Call& call(calls[row]);
+    if (call.state != CALL_PENDING)
+        return;
+
+    QStringList text;
+    for (QVariantMap::const_iterator riter = results.begin(); riter != results.end(); riter++)
+        text << riter.key() + "=" + riter.value().toString();
+
+    call.state = succeeded ? CALL_SUCCEEDED : CALL_FAILED;
+    call.elapsed = call.timer.elapsed();
+    call.result = text.join(", ");
+    pending--;
+
+    emit dataChanged(createIndex(row, 3), createIndex(row, 5));
+    emit pendingChanged(pending);
+}
+
+
+void MethodResponseModel::clear()
+{
+    //
+    // Calls still waiting for a response stay; their rows would otherwise be lost.
+    //
+    QVector<Call> remaining;
+    for (QVector<Call>::const_iterator iter = calls.begin(); iter != calls.end(); iter++)
+        if (iter->state == CALL_PENDING)
+            remaining.append(*iter);
+
+    beginResetModel();
+    calls = remaining;
+    rowsById.clear();
+    for (int row = 0; row < calls.size(); row++)
+        rowsById[calls[row].id] = row;
+    endResetModel();
+}
+
+
+int MethodResponseModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return calls.size();
+    return 0;
+}
+
+
+int MethodResponseModel::columnCount(const QModelIndex &parent) const
+{
+    return 6;
+}
+
+
+QVariant MethodResponseModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const Call& call(calls.at(index.row()));
+
+    if (role == Qt::ForegroundRole && index.column() == 3 && call.state == CALL_FAILED)
+        return QColor(Qt::red);
+
+    if (role == Qt::TextAlignmentRole && (index.column() == 0 || index.column() == 4))
+        return (int) (Qt::AlignRight | Qt::AlignVCenter);
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (index.column()) {
+    case 0: return call.id;
+    case 1: return call.object;
+    case 2: return call.method;
+    case 3:
+        switch (call.state) {
+        case CALL_PENDING:   return QString("Pending");
+        case CALL_SUCCEEDED: return QString("OK");
+        case CALL_FAILED:    return QString("Failed");
+        }
+        break;
+    case 4:
+        if (call.state == CALL_PENDING)
+            return QVariant();
+        return call.elapsed;
+    case 5: return call.result;
+    }
+    return QVariant();
+}
+
+
+QVariant MethodResponseModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal)
+    switch (section) {
+    case 0: return QString("Call");
+    case 1: return QString("Object");
+    case 2: return QString("Method");
+    case 3: return QString("Status");
+    case 4: return QString("ms");
+    case 5: return QString("Result");
+    }
+
+    return QVariant();
+}
+
+
+QModelIndex MethodResponseModel::parent(const QModelIndex& index) const
+{
+    //
+    // Not a tree structure, no parents.
+    //
+    return QModelIndex();
+}
+
+
+QModelIndex MethodResponseModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return createIndex(row, column);
+
+    return QModelIndex();
+}
+
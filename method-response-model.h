@@ -0,0 +1,85 @@
+#ifndef _qe_method_response_model_h
+#define _qe_method_response_model_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QAbstractItemModel>
+#include <QModelIndex>
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+
+//
+// Outstanding and completed method calls, one row per call in the order they were
+// made.  A call is added when it is issued and its row is filled in when the
+// response (or a timeout) comes back under the same call id.
+//
+class MethodResponseModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    MethodResponseModel(QObject* parent = 0);
+
+    //
+    // Record a new call and return the id its response will be correlated by.
+    //
+    quint64 addCall(const QString& object, const QString& method);
+    int pendingCount() const { return pending; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    QModelIndex parent(const QModelIndex& index) const;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+
+public slots:
+    void methodResponse(quint64, bool, const QVariantMap&);
+
+    //
+    // Remove the completed calls.
+    //
+    void clear();
+
+signals:
+    void pendingChanged(int);
+
+private:
+    typedef enum { CALL_PENDING, CALL_SUCCEEDED, CALL_FAILED } CallState;
+
+    struct Call {
+        quint64 id;
+        QString object;
+        QString method;
+        CallState state;
+        QElapsedTimer timer;
+        qint64 elapsed;
+        QString result;
+    };
+
+    QVector<Call> calls;
+    QHash<quint64, int> rowsById;
+    quint64 nextId;
+    int pending;
+};
+
+#endif
+
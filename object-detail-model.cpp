@@ -18,12 +18,43 @@
  */
 
 #include "object-detail-model.h"
+#include "object-model.h"
+#include "series-store.h"
+#include "rate-engine.h"
+#include "reference-index.h"
+#include "qmf-variant.h"
+#include <qmf/DataAddr.h>
+#include <QColor>
+#include <QFont>
 #include <iostream>
+#include <map>
 
 using std::cout;
 using std::endl;
 
-ObjectDetailModel::ObjectDetailModel(QObject* parent) : QAbstractItemModel(parent)
+namespace {
+    typedef std::map<std::string, std::string> TargetMap;
+
+    //
+    // The object key each reference property of an object points at, when known.
+    //
+    void referenceTargets(const ReferenceIndex* index, const qmf::Data& object, TargetMap& targets)
+    {
+        if (!index || !object.hasAddr())
+            return;
+        ReferenceIndex::ReferenceList references;
+        index->outbound(ReferenceIndex::addrKey(object.getAddr().getAgentName(), object.getAddr().getName()),
+                        references);
+        for (ReferenceIndex::ReferenceList::const_iterator iter = references.begin(); iter != references.end(); iter++)
+            if (!iter->objectKey.empty() && targets.find(iter->property) == targets.end())
+                targets[iter->property] = iter->objectKey;
+    }
+}
+
+
+ObjectDetailModel::ObjectDetailModel(SeriesStore* series, RateEngine* rates, ReferenceIndex* references,
+                                     QObject* parent) :
+    QAbstractItemModel(parent), seriesStore(series), rateEngine(rates), referenceIndex(references), propertyCount(0)
 {
     // Intentionally Left Blank
 }
@@ -36,23 +67,149 @@ void ObjectDetailModel::newObject(const qmf::Data& object)
 
     clear();
 
+    current = object;
+    if (object.hasAddr())
+        objectKey = ObjectModel::objectKey(object);
+
     const qpid::types::Variant::Map& attrs(object.getProperties());
+    TargetMap targets;
+    referenceTargets(referenceIndex, object, targets);
 
+    //
+    // A reference whose target is known shows, and links to, the target's key.
+    //
     beginInsertRows(QModelIndex(), 0, attrs.size() - 1);
     for (qpid::types::Variant::Map::const_iterator iter = attrs.begin();
          iter != attrs.end(); iter++) {
+        TargetMap::const_iterator target(targets.find(iter->first));
         keys << QString(iter->first.c_str());
-        values << QString(iter->second.asString().c_str());
+        if (target != targets.end() && ReferenceIndex::isReference(iter->second)) {
+            values << QString(target->second.c_str());
+            links.push_back(target->second);
+        } else {
+            values << QString(iter->second.asString().c_str());
+            links.push_back(std::string());
+        }
+        rawValues << QmfVariant::toQVariant(iter->second);
+    }
+    propertyCount = (int) attrs.size();
+    endInsertRows();
+
+    addReferrers();
+}
+
+
+void ObjectDetailModel::addReferrers()
+{
+    if (!referenceIndex || !current.hasAddr())
+        return;
+
+    ReferenceIndex::ReferenceList referrers;
+    referenceIndex->inbound(ReferenceIndex::addrKey(current.getAddr().getAgentName(), current.getAddr().getName()),
+                            referrers);
+    if (referrers.empty())
+        return;
+
+    //
+    // Each object referring to this one gets a row of its own after the properties.
+    //
+    beginInsertRows(QModelIndex(), keys.size(), keys.size() + (int) referrers.size() - 1);
+    for (ReferenceIndex::ReferenceList::const_iterator iter = referrers.begin(); iter != referrers.end(); iter++) {
+        QString source(iter->objectKey.empty() ? iter->objectName.c_str() : iter->objectKey.c_str());
+        QString text(QString("%1 (%2)").arg(source).arg(iter->property.c_str()));
+        keys << QString("referenced by");
+        values << text;
+        rawValues << text;
+        links.push_back(iter->objectKey);
     }
     endInsertRows();
 }
 
 
+void ObjectDetailModel::referencesChanged(const QString& key)
+{
+    if (objectKey.empty() || key.toStdString() != objectKey)
+        return;
+
+    //
+    // Refresh the reference properties in place and replace the referrer rows.
+    //
+    if (keys.size() > propertyCount) {
+        beginRemoveRows(QModelIndex(), propertyCount, keys.size() - 1);
+        while (keys.size() > propertyCount) {
+            keys.removeLast();
+            values.removeLast();
+            rawValues.removeLast();
+            links.pop_back();
+        }
+        endRemoveRows();
+    }
+    updateObject(current);
+    if (keys.size() == propertyCount)
+        addReferrers();
+}
+
+
+std::string ObjectDetailModel::linkAt(int row) const
+{
+    if (row < 0 || row >= (int) links.size())
+        return std::string();
+    return links[row];
+}
+
+
+void ObjectDetailModel::updateObject(const qmf::Data& object)
+{
+    if (objectKey.empty() || !object.hasAddr() || ObjectModel::objectKey(object) != objectKey)
+        return;
+
+    current = object;
+    const qpid::types::Variant::Map& attrs(object.getProperties());
+    if ((int) attrs.size() != propertyCount) {
+        newObject(object);
+        return;
+    }
+    TargetMap targets;
+    referenceTargets(referenceIndex, object, targets);
+
+    //
+    // Refresh the values in place so the view keeps its selection and scroll
+    // position.  The rate, average and history columns are derived from the rate
+    // engine and series store which have already recorded this update.
+    //
+    int row(0);
+    for (qpid::types::Variant::Map::const_iterator iter = attrs.begin();
+         iter != attrs.end(); iter++, row++) {
+        if (keys.at(row) != QString(iter->first.c_str())) {
+            newObject(object);
+            return;
+        }
+        TargetMap::const_iterator target(targets.find(iter->first));
+        if (target != targets.end() && ReferenceIndex::isReference(iter->second)) {
+            values[row] = QString(target->second.c_str());
+            links[row] = target->second;
+        } else {
+            values[row] = QString(iter->second.asString().c_str());
+            links[row].clear();
+        }
+        rawValues[row] = QmfVariant::toQVariant(iter->second);
+    }
+
+    if (row > 0)
+        emit dataChanged(createIndex(0, 1), createIndex(row - 1, 4));
+}
+
+
 void ObjectDetailModel::clear()
 {
     beginRemoveRows(QModelIndex(), 0, keys.size() - 1);
+    objectKey.clear();
+    current = qmf::Data();
+    propertyCount = 0;
     keys.clear();
     values.clear();
+    rawValues.clear();
+    links.clear();
     endRemoveRows();
 }
 
@@ -74,23 +231,107 @@ int ObjectDetailModel::rowCount(const QModelIndex &parent) const
 
 int ObjectDetailModel::columnCount(const QModelIndex &parent) const
 {
-    return 2;
+    return 5;
 }
 
 
 QVariant ObjectDetailModel::data(const QModelIndex &index, int role) const
 {
-    if (role != Qt::DisplayRole)
+    if (!index.isValid())
         return QVariant();
 
-    if (!index.isValid())
+    //
+    // The user role carries the typed property value for sorting.
+    //
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+        case 0: return keys.at(index.row());
+        case 1: return rawValues.at(index.row());
+        case 2: return rate(index.row());
+        case 3: return average(index.row());
+        case 4: return history(index.row());
+        }
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole && (index.column() == 2 || index.column() == 3))
+        return (int) (Qt::AlignRight | Qt::AlignVCenter);
+
+    //
+    // Rows that lead to another object look like links.
+    //
+    if (index.column() == 1 && !links[index.row()].empty()) {
+        if (role == Qt::ForegroundRole)
+            return QColor(Qt::blue);
+        if (role == Qt::FontRole) {
+            QFont font;
+            font.setUnderline(true);
+            return font;
+        }
+        if (role == Qt::ToolTipRole)
+            return QString("Double-click to open");
+    }
+
+    if (role != Qt::DisplayRole)
         return QVariant();
 
     switch (index.column()) {
     case 0: return keys.at(index.row());
     case 1: return values.at(index.row());
+    case 2:
+    case 3: {
+        QVariant perSecond(index.column() == 2 ? rate(index.row()) : average(index.row()));
+        if (perSecond.isValid())
+            return QString::number(perSecond.toDouble(), 'f', 1);
+        return QVariant();
     }
-    return 0;
+    }
+    return QVariant();
+}
+
+
+QVariant ObjectDetailModel::rate(int row) const
+{
+    std::string property(keys.at(row).toStdString());
+
+    //
+    // Counters take their rate from the rate engine, which knows about resets.
+    // Other tracked values (queue depths and the like) use the change between
+    // their last two recorded samples.
+    //
+    if (rateEngine && rateEngine->isCounter(property)) {
+        RateEngine::Rate counterRate;
+        if (rateEngine->rate(objectKey, property, counterRate))
+            return counterRate.perSecond;
+        return QVariant();
+    }
+
+    double perSecond;
+    if (seriesStore && seriesStore->rate(objectKey, property, perSecond))
+        return perSecond;
+    return QVariant();
+}
+
+
+QVariant ObjectDetailModel::average(int row) const
+{
+    RateEngine::Rate counterRate;
+    if (rateEngine && rateEngine->rate(objectKey, keys.at(row).toStdString(), counterRate))
+        return counterRate.average1m;
+    return QVariant();
+}
+
+
+QVariant ObjectDetailModel::history(int row) const
+{
+    SeriesStore::SampleList samples;
+    if (!seriesStore || !seriesStore->history(objectKey, keys.at(row).toStdString(), samples))
+        return QVariant();
+
+    QVariantList list;
+    for (SeriesStore::SampleList::const_iterator iter = samples.begin(); iter != samples.end(); iter++)
+        list << (qlonglong) iter->value;
+    return list;
 }
 
 
@@ -100,6 +341,9 @@ QVariant ObjectDetailModel::headerData(int section, Qt::Orientation orientation,
     switch (section) {
     case 0: return QString("Key");
     case 1: return QString("Value");
+    case 2: return QString("Rate/s");
+    case 3: return QString("Avg/s (1m)");
+    case 4: return QString("History");
     }
 
     return QVariant();
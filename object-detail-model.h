@@ -25,12 +25,17 @@
 #include <qmf/Data.h>
 #include <sstream>
 #include <string>
+#include <vector>
+
+class SeriesStore;
+class RateEngine;
+class ReferenceIndex;
 
 class ObjectDetailModel : public QAbstractItemModel {
     Q_OBJECT
 
 public:
-    ObjectDetailModel(QObject* parent = 0);
+    ObjectDetailModel(SeriesStore* series, RateEngine* rates, ReferenceIndex* references, QObject* parent = 0);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
@@ -39,13 +44,39 @@ public:
     QModelIndex parent(const QModelIndex& index) const;
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
 
+    //
+    // The object key a row links to: the target of a reference property, or the
+    // source of a reference to this object.  Empty for other rows.
+    //
+    std::string linkAt(int row) const;
+
 public slots:
     void newObject(const qmf::Data&);
+    void updateObject(const qmf::Data&);
+    void referencesChanged(const QString&);
     void clear();
 
 private:
+    SeriesStore* seriesStore;
+    RateEngine* rateEngine;
+    ReferenceIndex* referenceIndex;
+    std::string objectKey;
+    qmf::Data current;
+
+    //
+    // The property rows, followed by one row per object referring to this one.
+    //
+    int propertyCount;
     QStringList keys;
     QStringList values;
+    QList<QVariant> rawValues;
+    std::vector<std::string> links;
+
+    void addReferrers();
+
+    QVariant rate(int row) const;
+    QVariant average(int row) const;
+    QVariant history(int row) const;
 };
 
 #endif
@@ -18,14 +18,28 @@
  */
 
 #include "object-model.h"
+#include "qmf-thread.h"
+#include "explorer-stats.h"
+#include "trace.h"
 #include <qmf/SchemaId.h>
 #include <qmf/DataAddr.h>
+#include <QFileInfo>
 #include <iostream>
+#include <algorithm>
 
 using std::cout;
 using std::endl;
 
-ObjectModel::ObjectModel(QObject* parent) : QAbstractItemModel(parent), nextId(1)
+namespace {
+    //
+    // Instances read from a snapshot per fetch, so expanding a huge class stays
+    // responsive; scrolling to the end of the loaded rows fetches the next batch.
+    //
+    const int FETCH_BATCH = 1000;
+}
+
+ObjectModel::ObjectModel(QObject* parent) :
+    QAbstractItemModel(parent), currentGrouping(GROUP_PACKAGE), rebuilding(false), nextId(1)
 {
     // Intentionally Left Blank
 }
@@ -41,56 +55,81 @@ void ObjectModel::renumber(IndexList& list)
 
 ObjectModel::ObjectIndexPtr
 ObjectModel::findOrInsertNode(IndexList& list, NodeType nodeType, ObjectIndexPtr parent,
-                              const std::string& text, const qmf::Data& object, QModelIndex parentIndex,
+                              const std::string& text, QModelIndex parentIndex,
                               IndexList::iterator& listPosition)
 {
-    ObjectIndexPtr node;
-    int rowCount;
+    QE_TRACE_SCOPE("ObjectModel::findOrInsertNode");
+    IndexList::iterator iter(list.end());
+    int rowCount(list.empty() ? 0 : list.back()->row + 1);
 
-    IndexList::iterator iter(list.begin());
-    rowCount = 0;
-    while (iter != list.end() && text > (*iter)->text) {
-        iter++;
-        rowCount++;
+    //
+    // Objects mostly arrive in key order, and a rebuild places them in order, so
+    // the end of the list is tried before it is searched.
+    //
+    if (!list.empty() && text == list.back()->text) {
+        listPosition = --list.end();
+        return list.back();
+    }
+    if (!list.empty() && text < list.back()->text) {
+        iter = list.begin();
+        rowCount = 0;
+        while (iter != list.end() && text > (*iter)->text) {
+            iter++;
+            rowCount++;
+        }
+        if (iter != list.end() && text == (*iter)->text) {
+            listPosition = iter;
+            return *iter;
+        }
     }
 
-    if (iter == list.end() || text != (*iter)->text) {
-        //
-        // A new data record needs to be inserted in-order in the list.
-        //
+    //
+    // A new data record needs to be inserted in-order in the list.  Nothing is
+    // announced while the whole tree is being rebuilt.
+    //
+    if (!rebuilding)
         beginInsertRows(parentIndex, rowCount, rowCount);
-        node.reset(new ObjectIndex());
-        node->id = nextId++;
-        node->nodeType = nodeType;
-        node->text = text;
-        node->parent = parent;
-        node->object = object;
-        linkage[node->id] = node;
-
-        if (iter == list.end())
-            list.push_back(node);
-        else
-            list.insert(iter, node);
+    ObjectIndexPtr node(new ObjectIndex());
+    node->id = nextId++;
+    node->row = rowCount;
+    node->nodeType = nodeType;
+    node->text = text;
+    node->parent = parent;
+    node->pendingBegin = 0;
+    node->pendingEnd = 0;
+    linkage[node->id] = node;
+
+    bool append(iter == list.end());
+    listPosition = list.insert(iter, node);
+    if (!append)
         renumber(list);
+    if (!rebuilding)
         endInsertRows();
-    } else
-        node = *iter;
-
-    for (iter = list.begin(); iter != list.end(); iter++)
-        if ((*iter)->text == text) {
-            listPosition = iter;
-            break;
-        }
 
     return node;
 }
 
 
+ObjectModel::ObjectIndexPtr ObjectModel::brokerNode(const std::string& broker)
+{
+    IndexList::iterator unused;
+    return findOrInsertNode(brokers, NODE_BROKER, ObjectIndexPtr(), broker, QModelIndex(), unused);
+}
+
+
 void ObjectModel::addPackage(const QString& package)
 {
     cout << "[ObjectModel::addPackage] package=" << package.toStdString() << endl;
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+    announced[broker].insert(std::make_pair(package.toStdString(), std::string()));
+    if (!snapshot && currentGrouping == GROUP_AGENT)
+        return;
     IndexList::iterator unused;
-    findOrInsertNode(packages, NODE_PACKAGE, ObjectIndexPtr(), package.toStdString(), qmf::Data(), QModelIndex(), unused);
+    ObjectIndexPtr bptr(brokerNode(broker));
+    findOrInsertNode(bptr->children, NODE_PACKAGE, bptr, package.toStdString(),
+                     createIndex(bptr->row, 0, bptr->id), unused);
 }
 
 
@@ -100,85 +139,679 @@ void ObjectModel::addClass(const QStringList& list)
     std::string schema(list.at(1).toStdString());
     IndexList::iterator unused;
 
-    ObjectIndexPtr pptr(findOrInsertNode(packages, NODE_PACKAGE, ObjectIndexPtr(),
-                                         package, qmf::Data(), QModelIndex(), unused));
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+    announced[broker].insert(std::make_pair(package, schema));
+    if (!snapshot && currentGrouping == GROUP_AGENT)
+        return;
+    ObjectIndexPtr bptr(brokerNode(broker));
+    ObjectIndexPtr pptr(findOrInsertNode(bptr->children, NODE_PACKAGE, bptr,
+                                         package, createIndex(bptr->row, 0, bptr->id), unused));
     findOrInsertNode(pptr->children, NODE_SCHEMA, pptr,
-                     schema, qmf::Data(), createIndex(pptr->row, 0, pptr->id), unused);
+                     schema, createIndex(pptr->row, 0, pptr->id), unused);
 }
 
 void ObjectModel::addObject(const qmf::Data& object)
 {
+    QE_TRACE_SCOPE("ObjectModel::addObject");
+    ExplorerStats::ScopedTimer timer(ExplorerStats::HIST_OBJECT_INSERT);
     if (!object.hasAddr()) {
         return;
     }
-    const qmf::DataAddr& addr(object.getAddr());
-    const qmf::SchemaId& schemaId(object.getSchemaId());
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+
+    //
+    // If the instance was already known, keep the most recent copy of its data.
+    //
+    std::pair<RecordMap::iterator, bool> inserted(records.insert(std::make_pair(objectKey(object), ObjectRecordPtr())));
+    if (!inserted.second) {
+        inserted.first->second->object = object;
+        inserted.first->second->stale = false;
+        return;
+    }
+
+    ObjectRecordPtr record(new ObjectRecord());
+    record->key = &inserted.first->first;
+    record->broker = broker;
+    record->object = object;
+    record->offset = -1;
+    record->node = 0;
+    record->stale = false;
+    inserted.first->second = record;
+
+    AgentObjectMap::iterator owner(byAgent.insert(std::make_pair(std::make_pair(broker, object.getAddr().getAgentName()),
+                                                                 std::set<ObjectRecord*>())).first);
+    owner->second.insert(record.get());
+    record->owner = &*owner;
+
+    placeRecord(record);
+}
+
 
+void ObjectModel::placeRecord(const ObjectRecordPtr& record)
+{
+    const qmf::SchemaId& schemaId(record->object.getSchemaId());
+    const qmf::DataAddr& addr(record->object.getAddr());
     const std::string& package(schemaId.getPackageName());
     const std::string& schema(schemaId.getName());
-    const std::string& instance(addr.getAgentName() + ":" + addr.getName());
+    const std::string& agent(addr.getAgentName());
 
+    //
+    // The path from the broker node down to the instance in the current grouping.
+    //
+    const std::string* path[4];
+    NodeType types[3];
+    std::string leaf;
+    switch (snapshot ? GROUP_PACKAGE : currentGrouping) {
+    case GROUP_PACKAGE:
+        path[0] = &package; types[0] = NODE_PACKAGE;
+        path[1] = &schema;  types[1] = NODE_SCHEMA;
+        path[2] = 0;
+        leaf = agent + ":" + addr.getName();
+        break;
+    case GROUP_AGENT:
+        path[0] = &agent;   types[0] = NODE_AGENT;
+        path[1] = &package; types[1] = NODE_PACKAGE;
+        path[2] = &schema;  types[2] = NODE_SCHEMA;
+        leaf = addr.getName();
+        break;
+    case GROUP_CLASS_AGENT:
+        path[0] = &package; types[0] = NODE_PACKAGE;
+        path[1] = &schema;  types[1] = NODE_SCHEMA;
+        path[2] = &agent;   types[2] = NODE_AGENT;
+        leaf = addr.getName();
+        break;
+    }
+    path[3] = 0;
+
+    //
+    // Objects are grouped under the broker connection that reported them.
+    //
     IndexList::iterator unused;
+    ObjectIndexPtr node(brokerNode(record->broker));
+    for (int level = 0; path[level]; level++)
+        node = findOrInsertNode(node->children, types[level], node, *path[level],
+                                createIndex(node->row, 0, node->id), unused);
+    ObjectIndexPtr iptr(findOrInsertNode(node->children, NODE_INSTANCE, node, leaf,
+                                         createIndex(node->row, 0, node->id), unused));
+    iptr->record = record;
+    record->node = iptr.get();
+}
+
+
+void ObjectModel::setGrouping(int grouping)
+{
+    if (grouping == currentGrouping || grouping < GROUP_PACKAGE || grouping > GROUP_CLASS_AGENT)
+        return;
+    currentGrouping = (Grouping) grouping;
 
-    ObjectIndexPtr pptr(findOrInsertNode(packages, NODE_PACKAGE, ObjectIndexPtr(),
-                                         package, object, QModelIndex(), unused));
-    ObjectIndexPtr sptr(findOrInsertNode(pptr->children, NODE_SCHEMA, pptr,
-                                         schema, object, createIndex(pptr->row, 0, pptr->id), unused));
-    ObjectIndexPtr iptr(findOrInsertNode(sptr->children, NODE_INSTANCE, sptr,
-                                         instance, object, createIndex(sptr->row, 0, sptr->id), unused));
+    //
+    // A snapshot keeps its package grouping; the choice applies to what is
+    // loaded after it.
+    //
+    if (!snapshot)
+        rebuild();
 }
 
 
-void ObjectModel::delObject(const qmf::Data& object)
+void ObjectModel::rebuild()
+{
+    QE_TRACE_SCOPE("ObjectModel::rebuild");
+
+    //
+    // Every record is placed in the order of its path in the new grouping, so
+    // each node is appended to its list and the rebuild is one sort plus one pass.
+    // Only tree nodes are created; the records and their data are untouched.
+    //
+    std::vector<std::pair<std::string, ObjectRecordPtr> > order;
+    order.reserve(records.size());
+    for (RecordMap::const_iterator iter = records.begin(); iter != records.end(); iter++) {
+        const ObjectRecordPtr& record(iter->second);
+        record->node = 0;
+        if (!record->object.isValid())
+            continue;
+        const qmf::SchemaId& schemaId(record->object.getSchemaId());
+        const qmf::DataAddr& addr(record->object.getAddr());
+        std::string sortKey(record->broker);
+        sortKey += '\0';
+        switch (currentGrouping) {
+        case GROUP_PACKAGE:
+            sortKey += schemaId.getPackageName() + '\0' + schemaId.getName() + '\0' +
+                addr.getAgentName() + ":" + addr.getName();
+            break;
+        case GROUP_AGENT:
+            sortKey += addr.getAgentName() + '\0' + schemaId.getPackageName() + '\0' +
+                schemaId.getName() + '\0' + addr.getName();
+            break;
+        case GROUP_CLASS_AGENT:
+            sortKey += schemaId.getPackageName() + '\0' + schemaId.getName() + '\0' +
+                addr.getAgentName() + '\0' + addr.getName();
+            break;
+        }
+        order.push_back(std::make_pair(sortKey, record));
+    }
+
+    //
+    // Announced packages and classes join the order without a record.  Their key
+    // is a prefix of the keys of their instances, so they sort just ahead of them.
+    //
+    if (currentGrouping != GROUP_AGENT)
+        for (AnnouncedMap::const_iterator biter = announced.begin(); biter != announced.end(); biter++)
+            for (ClassSet::const_iterator iter = biter->second.begin(); iter != biter->second.end(); iter++) {
+                std::string sortKey(biter->first + '\0' + iter->first);
+                if (!iter->second.empty())
+                    sortKey += '\0' + iter->second;
+                order.push_back(std::make_pair(sortKey, ObjectRecordPtr()));
+            }
+    std::sort(order.begin(), order.end());
+
+    beginResetModel();
+    rebuilding = true;
+
+    std::vector<std::string> names;
+    for (IndexList::const_iterator iter = brokers.begin(); iter != brokers.end(); iter++)
+        names.push_back((*iter)->text);
+    brokers.clear();
+    linkage.clear();
+    for (std::vector<std::string>::const_iterator iter = names.begin(); iter != names.end(); iter++)
+        brokerNode(*iter);
+
+    IndexList::iterator unused;
+    for (size_t idx = 0; idx < order.size(); idx++) {
+        if (order[idx].second) {
+            placeRecord(order[idx].second);
+            continue;
+        }
+        const std::string& sortKey(order[idx].first);
+        size_t packageStart(sortKey.find('\0') + 1);
+        size_t classStart(sortKey.find('\0', packageStart));
+        ObjectIndexPtr bptr(brokerNode(sortKey.substr(0, packageStart - 1)));
+        ObjectIndexPtr pptr(findOrInsertNode(bptr->children, NODE_PACKAGE, bptr,
+                                             sortKey.substr(packageStart, classStart - packageStart),
+                                             QModelIndex(), unused));
+        if (classStart != std::string::npos)
+            findOrInsertNode(pptr->children, NODE_SCHEMA, pptr, sortKey.substr(classStart + 1), QModelIndex(), unused);
+    }
+
+    rebuilding = false;
+    endResetModel();
+}
+
+
+std::string ObjectModel::objectKey(const qmf::Data& object)
 {
     const qmf::SchemaId& schemaId(object.getSchemaId());
     const qmf::DataAddr& addr(object.getAddr());
+    return schemaId.getPackageName() + "/" + schemaId.getName() + "/" +
+        addr.getAgentName() + ":" + addr.getName();
+}
 
-    const std::string& package(schemaId.getPackageName());
-    const std::string& schema(schemaId.getName());
-    const std::string& instance(addr.getAgentName() + ":" + addr.getName());
 
-    IndexList::iterator piter;
-    IndexList::iterator siter;
-    IndexList::iterator iiter;
+const qmf::Data& ObjectModel::recordObject(const ObjectRecordPtr& record) const
+{
+    if (!record->object.isValid() && record->offset >= 0 && snapshot)
+        record->object = snapshot->object(record->offset);
+    return record->object;
+}
 
-    ObjectIndexPtr pptr(findOrInsertNode(packages, NODE_PACKAGE, ObjectIndexPtr(), package, object, QModelIndex(), piter));
 
-    QModelIndex pindex(createIndex(pptr->row, 0, pptr->id));
-    ObjectIndexPtr sptr(findOrInsertNode(pptr->children, NODE_SCHEMA, pptr, schema, object, pindex, siter));
+void ObjectModel::loadSnapshot(const SnapshotFilePtr& file)
+{
+    QE_TRACE_SCOPE("ObjectModel::loadSnapshot");
+    clear();
+    snapshot = file;
 
-    QModelIndex iindex(createIndex(sptr->row, 0, sptr->id));
-    ObjectIndexPtr iptr(findOrInsertNode(sptr->children, NODE_INSTANCE, sptr, instance, object, iindex, iiter));
+    std::vector<SnapshotFile::ClassRange> ranges;
+    file->classes(ranges);
 
-    beginRemoveRows(iindex, iptr->row, iptr->row);
-    sptr->children.erase(iiter);
-    linkage.erase(linkage.find(iptr->id));
-    renumber(sptr->children);
-    endRemoveRows();
+    IndexList::iterator unused;
+    ObjectIndexPtr bptr(brokerNode("snapshot:" + QFileInfo(file->fileName()).fileName().toStdString()));
+    for (std::vector<SnapshotFile::ClassRange>::const_iterator iter = ranges.begin(); iter != ranges.end(); iter++) {
+        ObjectIndexPtr pptr(findOrInsertNode(bptr->children, NODE_PACKAGE, bptr, iter->package,
+                                             createIndex(bptr->row, 0, bptr->id), unused));
+        ObjectIndexPtr sptr(findOrInsertNode(pptr->children, NODE_SCHEMA, pptr, iter->name,
+                                             createIndex(pptr->row, 0, pptr->id), unused));
+        sptr->pendingBegin = iter->begin;
+        sptr->pendingEnd = iter->end;
+    }
+}
 
-    if (sptr->children.size() == 0) {
-        beginRemoveRows(pindex, sptr->row, sptr->row);
-        pptr->children.erase(siter);
-        linkage.erase(linkage.find(sptr->id));
-        renumber(pptr->children);
-        endRemoveRows();
 
-        if (pptr->children.size() == 0) {
-            beginRemoveRows(QModelIndex(), pptr->row, pptr->row);
-            packages.erase(piter);
-            linkage.erase(linkage.find(pptr->id));
-            renumber(packages);
+bool ObjectModel::hasChildren(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        IndexMap::const_iterator iter(linkage.find(parent.internalId()));
+        if (iter != linkage.end() && iter->second->pendingBegin < iter->second->pendingEnd)
+            return true;
+    }
+    return rowCount(parent) > 0;
+}
+
+
+bool ObjectModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (!parent.isValid() || !snapshot)
+        return false;
+    IndexMap::const_iterator iter(linkage.find(parent.internalId()));
+    return iter != linkage.end() && iter->second->pendingBegin < iter->second->pendingEnd;
+}
+
+
+void ObjectModel::fetchMore(const QModelIndex& parent)
+{
+    QE_TRACE_SCOPE("ObjectModel::fetchMore");
+    if (!canFetchMore(parent))
+        return;
+    ObjectIndexPtr sptr(linkage.find(parent.internalId())->second);
+
+    //
+    // Only the keys are read here.  Records are in key order, so the new rows
+    // are appended and the list stays sorted.
+    //
+    std::vector<std::pair<qint64, std::string> > batch;
+    std::string key;
+    size_t prefix(sptr->parent->text.size() + sptr->text.size() + 2);
+    while ((int) batch.size() < FETCH_BATCH && sptr->pendingBegin < sptr->pendingEnd) {
+        qint64 offset;
+        if (!snapshot->nextKey(sptr->pendingBegin, key, offset))
+            break;
+        if (key.size() > prefix && records.find(key) == records.end())
+            batch.push_back(std::make_pair(offset, key));
+    }
+    if (sptr->pendingBegin >= sptr->pendingEnd || batch.empty())
+        sptr->pendingBegin = sptr->pendingEnd;
+    if (batch.empty())
+        return;
+
+    int first((int) sptr->children.size());
+    beginInsertRows(parent, first, first + (int) batch.size() - 1);
+    for (size_t idx = 0; idx < batch.size(); idx++) {
+        RecordMap::iterator iter(records.insert(std::make_pair(batch[idx].second, ObjectRecordPtr())).first);
+        ObjectRecordPtr record(new ObjectRecord());
+        record->key = &iter->first;
+        record->broker = sptr->parent->parent->text;
+        record->offset = batch[idx].first;
+        record->owner = 0;
+        record->stale = false;
+        iter->second = record;
+
+        ObjectIndexPtr node(new ObjectIndex());
+        node->id = nextId++;
+        node->row = first + (int) idx;
+        node->nodeType = NODE_INSTANCE;
+        node->text = batch[idx].second.substr(prefix);
+        node->parent = sptr;
+        node->record = record;
+        node->pendingBegin = 0;
+        node->pendingEnd = 0;
+        linkage[node->id] = node;
+        record->node = node.get();
+        sptr->children.push_back(node);
+    }
+    endInsertRows();
+}
+
+
+QModelIndex ObjectModel::indexForObject(const std::string& key) const
+{
+    RecordMap::const_iterator iter(records.find(key));
+    if (iter == records.end() || !iter->second->node)
+        return QModelIndex();
+    return createIndex(iter->second->node->row, 0, iter->second->node->id);
+}
+
+
+qmf::Data ObjectModel::objectAt(const QModelIndex& index) const
+{
+    IndexMap::const_iterator iter(linkage.find(index.internalId()));
+    if (!index.isValid() || iter == linkage.end() || iter->second->nodeType != NODE_INSTANCE)
+        return qmf::Data();
+    return recordObject(iter->second->record);
+}
+
+
+void ObjectModel::allObjects(BrokerObjectList& objects) const
+{
+    if (snapshot) {
+        std::vector<SnapshotFile::ClassRange> ranges;
+        snapshot->classes(ranges);
+        std::vector<qmf::Data> classObjects;
+        for (std::vector<SnapshotFile::ClassRange>::const_iterator iter = ranges.begin(); iter != ranges.end(); iter++)
+            readClass(*iter, classObjects);
+        std::string broker(brokers.empty() ? std::string() : brokers.front()->text);
+        objects.reserve(objects.size() + classObjects.size());
+        for (std::vector<qmf::Data>::const_iterator iter = classObjects.begin(); iter != classObjects.end(); iter++)
+            objects.push_back(std::make_pair(broker, *iter));
+        return;
+    }
+
+    objects.reserve(objects.size() + records.size());
+    for (RecordMap::const_iterator iter = records.begin(); iter != records.end(); iter++)
+        objects.push_back(std::make_pair(iter->second->broker, recordObject(iter->second)));
+}
+
+
+void ObjectModel::classObjects(const std::string& package, const std::string& schema,
+                               std::vector<qmf::Data>& objects) const
+{
+    //
+    // A snapshot's records are only in the store once its class is expanded, so
+    // its classes are read from the file.
+    //
+    if (snapshot) {
+        std::vector<SnapshotFile::ClassRange> ranges;
+        snapshot->classes(ranges);
+        for (std::vector<SnapshotFile::ClassRange>::const_iterator iter = ranges.begin(); iter != ranges.end(); iter++)
+            if (iter->package == package && iter->name == schema)
+                readClass(*iter, objects);
+        return;
+    }
+
+    //
+    // Records are keyed package first, so a class, across every connected broker
+    // and in any grouping, is one range of the store.
+    //
+    std::string prefix(package + "/" + schema + "/");
+    for (RecordMap::const_iterator iter = records.lower_bound(prefix);
+         iter != records.end() && iter->first.compare(0, prefix.size(), prefix) == 0; iter++)
+        objects.push_back(recordObject(iter->second));
+}
+
+
+void ObjectModel::readClass(const SnapshotFile::ClassRange& range, std::vector<qmf::Data>& objects) const
+{
+    //
+    // Objects already fetched into the tree are taken from their records, which
+    // may hold them parsed already.
+    //
+    qint64 offset(range.begin);
+    std::string key;
+    qint64 position;
+    while (offset < range.end && snapshot->nextKey(offset, key, position) && position < range.end) {
+        RecordMap::const_iterator iter(records.find(key));
+        qmf::Data object(iter != records.end() ? recordObject(iter->second) : snapshot->object(position));
+        if (object.isValid())
+            objects.push_back(object);
+    }
+}
+
+
+void ObjectModel::delObject(const qmf::Data& object)
+{
+    RecordMap::const_iterator iter(records.find(objectKey(object)));
+    if (iter == records.end() || !iter->second->node)
+        return;
+    IndexMap::const_iterator link(linkage.find(iter->second->node->id));
+    if (link != linkage.end())
+        removeInstances(std::vector<ObjectIndexPtr>(1, link->second));
+}
+
+
+void ObjectModel::disown(ObjectRecord* record)
+{
+    if (!record->owner)
+        return;
+    record->owner->second.erase(record);
+    if (record->owner->second.empty()) {
+        std::pair<std::string, std::string> key(record->owner->first);
+        byAgent.erase(key);
+    }
+    record->owner = 0;
+}
+
+
+void ObjectModel::delAgent(const qmf::Agent& agent)
+{
+    QE_TRACE_SCOPE("ObjectModel::delAgent");
+    AgentObjectMap::const_iterator iter(byAgent.find(std::make_pair(QmfThread::brokerName(sender()),
+                                                                    agent.getName())));
+    if (iter == byAgent.end())
+        return;
+
+    std::vector<ObjectIndexPtr> nodes;
+    nodes.reserve(iter->second.size());
+    for (std::set<ObjectRecord*>::const_iterator record = iter->second.begin(); record != iter->second.end(); record++) {
+        IndexMap::const_iterator link(linkage.find((*record)->node->id));
+        if (link != linkage.end())
+            nodes.push_back(link->second);
+    }
+    removeInstances(nodes);
+}
+
+
+void ObjectModel::removeInstances(const std::vector<ObjectIndexPtr>& nodes)
+{
+    //
+    // Finding the k departing nodes is direct, but each parent they leave is
+    // walked once to locate the rows and once to renumber what is left: rows are
+    // kept in the nodes of a list.  Removal therefore costs O(k log k) plus the
+    // size of every class affected, and a single delObject pays for its class.
+    //
+    // Group the nodes by parent and, within a parent, by row.
+    //
+    typedef std::map<quint32, std::pair<ObjectIndexPtr, std::vector<int> > > ParentRows;
+    ParentRows parents;
+    for (std::vector<ObjectIndexPtr>::const_iterator iter = nodes.begin(); iter != nodes.end(); iter++) {
+        std::pair<ObjectIndexPtr, std::vector<int> >& entry(parents[(*iter)->parent->id]);
+        entry.first = (*iter)->parent;
+        entry.second.push_back((*iter)->row);
+    }
+
+    for (ParentRows::iterator piter = parents.begin(); piter != parents.end(); piter++) {
+        ObjectIndexPtr parent(piter->second.first);
+        std::vector<int>& rows(piter->second.second);
+        std::sort(rows.begin(), rows.end());
+
+        std::vector<IndexList::iterator> positions;
+        positions.reserve(parent->children.size());
+        for (IndexList::iterator iter = parent->children.begin(); iter != parent->children.end(); iter++)
+            positions.push_back(iter);
+
+        //
+        // Each run of adjacent rows goes in one removal, last run first so the rows
+        // of the runs still to come are not shifted.  The parent is renumbered once.
+        //
+        QModelIndex pindex(createIndex(parent->row, 0, parent->id));
+        size_t end(rows.size());
+        while (end > 0) {
+            size_t begin(end - 1);
+            while (begin > 0 && rows[begin - 1] == rows[begin] - 1)
+                begin--;
+
+            beginRemoveRows(pindex, rows[begin], rows[end - 1]);
+            for (size_t idx = begin; idx < end; idx++) {
+                IndexList::iterator position(positions[rows[idx]]);
+                unlink(*position);
+                parent->children.erase(position);
+            }
             endRemoveRows();
+            end = begin;
         }
+        renumber(parent->children);
+        pruneEmpty(parent);
     }
+    announceRemoved();
+}
+
+
+void ObjectModel::pruneEmpty(const ObjectIndexPtr& node)
+{
+    //
+    // Remove a grouping node left without instances, and its parents if they are
+    // empty too.
+    //
+    ObjectIndexPtr ptr(node);
+    while (ptr->nodeType != NODE_BROKER && ptr->children.empty() && !isAnnounced(ptr)) {
+        ObjectIndexPtr parent(ptr->parent);
+        IndexList::iterator iter(std::find(parent->children.begin(), parent->children.end(), ptr));
+        beginRemoveRows(createIndex(parent->row, 0, parent->id), ptr->row, ptr->row);
+        parent->children.erase(iter);
+        linkage.erase(ptr->id);
+        renumber(parent->children);
+        endRemoveRows();
+        ptr = parent;
+    }
+}
+
+
+bool ObjectModel::isAnnounced(const ObjectIndexPtr& node) const
+{
+    //
+    // Only the package and class levels directly beneath a broker are kept for
+    // their announcement; in the agent grouping those levels sit under an agent.
+    //
+    ObjectIndexPtr package(node->nodeType == NODE_SCHEMA ? node->parent : node);
+    if (package->nodeType != NODE_PACKAGE || !package->parent || package->parent->nodeType != NODE_BROKER)
+        return false;
+    AnnouncedMap::const_iterator broker(announced.find(package->parent->text));
+    if (broker == announced.end())
+        return false;
+    std::string schema(node->nodeType == NODE_SCHEMA ? node->text : std::string());
+    return broker->second.find(std::make_pair(package->text, schema)) != broker->second.end();
+}
+
+
+void ObjectModel::agentObjects(const std::string& broker, const std::string& agent,
+                               std::vector<qmf::Data>& objects) const
+{
+    AgentObjectMap::const_iterator iter(byAgent.find(std::make_pair(broker, agent)));
+    if (iter == byAgent.end())
+        return;
+    objects.reserve(objects.size() + iter->second.size());
+    for (std::set<ObjectRecord*>::const_iterator record = iter->second.begin(); record != iter->second.end(); record++)
+        objects.push_back((*record)->object);
+}
+
+
+void ObjectModel::unlink(const ObjectIndexPtr& node)
+{
+    for (IndexList::const_iterator iter = node->children.begin(); iter != node->children.end(); iter++)
+        unlink(*iter);
+    if (node->record) {
+        std::string key(*node->record->key);
+        if (node->record->object.isValid())
+            removed.push_back(node->record->object);
+        disown(node->record.get());
+        records.erase(key);
+        node->record.reset();
+    }
+    linkage.erase(node->id);
+}
+
+
+void ObjectModel::announceRemoved()
+{
+    //
+    // Removed objects are announced once the tree is consistent again, not from
+    // within a row removal.
+    //
+    std::vector<qmf::Data> objects;
+    objects.swap(removed);
+    for (std::vector<qmf::Data>::const_iterator iter = objects.begin(); iter != objects.end(); iter++)
+        emit objectRemoved(*iter);
+}
+
+
+void ObjectModel::brokerConnected(bool isConnected)
+{
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+
+    //
+    // Drop whatever was known from this broker.  A fresh connection gets an empty
+    // broker node that its objects are added under.
+    //
+    IndexList::iterator iter(brokers.begin());
+    while (iter != brokers.end() && (*iter)->text != broker)
+        iter++;
+
+    resyncing.erase(broker);
+    announced.erase(broker);
+    if (iter != brokers.end()) {
+        ObjectIndexPtr bptr(*iter);
+        beginRemoveRows(QModelIndex(), bptr->row, bptr->row);
+        unlink(bptr);
+        brokers.erase(iter);
+        renumber(brokers);
+        endRemoveRows();
+        announceRemoved();
+    }
+
+    if (isConnected)
+        brokerNode(broker);
+}
+
+
+void ObjectModel::beginResync()
+{
+    //
+    // The broker has reconnected.  Its objects stay in the tree, marked stale
+    // until the new session's queries return them again.
+    //
+    std::string broker(QmfThread::brokerName(sender()));
+    if (broker.empty())
+        return;
+    resyncing.insert(broker);
+    for (RecordMap::const_iterator iter = records.begin(); iter != records.end(); iter++)
+        if (iter->second->broker == broker)
+            iter->second->stale = true;
+}
+
+
+void ObjectModel::endResync()
+{
+    //
+    // Objects the new session did not return were deleted while the broker was
+    // unreachable.
+    //
+    std::string broker(QmfThread::brokerName(sender()));
+    if (resyncing.erase(broker) == 0)
+        return;
+
+    std::vector<ObjectIndexPtr> nodes;
+    for (RecordMap::const_iterator iter = records.begin(); iter != records.end(); iter++) {
+        if (iter->second->broker != broker || !iter->second->stale || !iter->second->node)
+            continue;
+        IndexMap::const_iterator link(linkage.find(iter->second->node->id));
+        if (link != linkage.end())
+            nodes.push_back(link->second);
+    }
+    removeInstances(nodes);
+}
+
+
+size_t ObjectModel::memoryUsage() const
+{
+    //
+    // An estimate: each node, its shared-pointer control block and its list and
+    // map entries, plus the node text; each record with its key and broker name.
+    // The object data is held by qpid and not counted.
+    //
+    size_t total(0);
+    for (IndexMap::const_iterator iter = linkage.begin(); iter != linkage.end(); iter++)
+        total += sizeof(ObjectIndex) + 96 + iter->second->text.capacity();
+    for (RecordMap::const_iterator iter = records.begin(); iter != records.end(); iter++)
+        total += sizeof(ObjectRecord) + 96 + iter->first.capacity() + iter->second->broker.capacity();
+    for (AgentObjectMap::const_iterator iter = byAgent.begin(); iter != byAgent.end(); iter++)
+        total += 96 + iter->first.first.capacity() + iter->first.second.capacity() + 40 * iter->second.size();
+    return total;
 }
 
 
 void ObjectModel::clear()
 {
-    beginRemoveRows(QModelIndex(), 0, packages.size() - 1);
-    packages.clear();
+    beginRemoveRows(QModelIndex(), 0, brokers.size() - 1);
+    brokers.clear();
     linkage.clear();
+    records.clear();
+    byAgent.clear();
+    resyncing.clear();
+    announced.clear();
+    snapshot.reset();
     endRemoveRows();
 }
 
@@ -198,17 +831,24 @@ void ObjectModel::selected(const QModelIndex& index)
     // The selected tree row is a valid instance.  Relay it outbound.
     //
     if (ptr->nodeType == NODE_INSTANCE)
-        emit instSelected(ptr->object);
+        emit instSelected(recordObject(ptr->record));
+
+    //
+    // The selected tree row is a schema.  Relay the class so all of its instances
+    // can be shown together.  A class is beneath its package in every grouping.
+    //
+    if (ptr->nodeType == NODE_SCHEMA)
+        emit classSelected(QString(ptr->parent->text.c_str()), QString(ptr->text.c_str()));
 }
 
 
 int ObjectModel::rowCount(const QModelIndex &parent) const
 {
     //
-    // If the parent is invalid (top-level), return the number of packages.
+    // If the parent is invalid (top-level), return the number of brokers.
     //
     if (!parent.isValid())
-        return (int) packages.size();
+        return (int) brokers.size();
 
     //
     // Get the data record linked to the ID.
@@ -220,13 +860,15 @@ int ObjectModel::rowCount(const QModelIndex &parent) const
     const ObjectIndexPtr ptr(iter->second);
 
     //
-    // For parents that are package or schema, return the number of children.
+    // For parents that are broker, package, schema or agent, return the number of children.
     //
     switch (ptr->nodeType) {
     case NODE_INSTANCE:
         return 0;
+    case NODE_BROKER:
     case NODE_PACKAGE:
     case NODE_SCHEMA:
+    case NODE_AGENT:
         return (int) ptr->children.size();
     }
 
@@ -293,13 +935,13 @@ QModelIndex ObjectModel::parent(const QModelIndex& index) const
     ObjectIndexPtr ptr(iter->second);
 
     //
-    // Handle the package case
+    // Handle the broker case
     //
-    if (ptr->nodeType == NODE_PACKAGE)
+    if (ptr->nodeType == NODE_BROKER)
         return QModelIndex();
 
     //
-    // Handle the schema and instance level cases
+    // Handle the package, schema, agent and instance level cases
     //
     return createIndex(ptr->parent->row, 0, ptr->parent->id);
 }
@@ -312,16 +954,16 @@ QModelIndex ObjectModel::index(int row, int column, const QModelIndex &parent) c
 
     if (!parent.isValid()) {
         //
-        // Handle the package-level case
+        // Handle the broker-level case
         //
         count = 0;
-        iter = packages.begin();
-        while (iter != packages.end() && count < row) {
+        iter = brokers.begin();
+        while (iter != brokers.end() && count < row) {
             count++;
             iter++;
         }
 
-        if (iter == packages.end())
+        if (iter == brokers.end())
             return QModelIndex();
         return createIndex(row, 0, (*iter)->id);
     }
@@ -339,16 +981,20 @@ QModelIndex ObjectModel::index(int row, int column, const QModelIndex &parent) c
     // Create an index for the child data record.
     //
     switch (ptr->nodeType) {
+    case NODE_INSTANCE:
+        return QModelIndex();
+    case NODE_BROKER:
     case NODE_PACKAGE:
     case NODE_SCHEMA:
+    case NODE_AGENT:
         count = 0;
         iter = ptr->children.begin();
-        while (count < row) {
+        while (iter != ptr->children.end() && count < row) {
             iter++;
             count++;
         }
 
-        if (iter == packages.end())
+        if (iter == ptr->children.end())
             return QModelIndex();
         return createIndex(row, 0, (*iter)->id);
     }
@@ -24,10 +24,14 @@
 #include <QMutex>
 #include <QStringList>
 #include <qmf/Data.h>
+#include <qmf/Agent.h>
+#include "snapshot-file.h"
 #include <sstream>
 #include <string>
 #include <map>
+#include <set>
 #include <list>
+#include <vector>
 #include <deque>
 #include <boost/shared_ptr.hpp>
 
@@ -37,6 +41,16 @@ class ObjectModel : public QAbstractItemModel {
     Q_OBJECT
 
 public:
+    //
+    // How the objects of each broker are arranged beneath it.  The groupings are
+    // views over the same object records; switching rebuilds only the tree nodes.
+    //
+    typedef enum {
+        GROUP_PACKAGE,          // package / class / agent:name
+        GROUP_AGENT,            // agent / package / class / name
+        GROUP_CLASS_AGENT       // package / class / agent / name
+    } Grouping;
+
     ObjectModel(QObject* parent = 0);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -45,25 +59,99 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     QModelIndex parent(const QModelIndex& index) const;
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    //
+    // Replace the tree with the contents of a snapshot file.  Packages and classes
+    // appear at once; the instances of a class are read when it is expanded.  A
+    // snapshot is always grouped by package, which is what makes that possible.
+    //
+    void loadSnapshot(const SnapshotFilePtr&);
+
+    Grouping grouping() const { return currentGrouping; }
+
+    //
+    // The objects of one class.  While a snapshot is shown they are read from the
+    // file, whether or not the class has been expanded.
+    //
+    void classObjects(const std::string&, const std::string&, std::vector<qmf::Data>&) const;
+    QModelIndex indexForObject(const std::string&) const;
+    qmf::Data objectAt(const QModelIndex&) const;
+    size_t memoryUsage() const;
+
+    //
+    // Every known object with the broker it came from, in object-key order.  A
+    // snapshot's objects are read from the file, like classObjects.
+    //
+    typedef std::vector<std::pair<std::string, qmf::Data> > BrokerObjectList;
+    void allObjects(BrokerObjectList&) const;
+    static std::string objectKey(const qmf::Data&);
+
+    //
+    // The objects a live agent reported through a broker.
+    //
+    void agentObjects(const std::string& broker, const std::string& agent, std::vector<qmf::Data>&) const;
 
 public slots:
     void addPackage(const QString&);
     void addClass(const QStringList&);
     void addObject(const qmf::Data&);
     void delObject(const qmf::Data&);
+    void delAgent(const qmf::Agent&);
+    void brokerConnected(bool);
+    void beginResync();
+    void endResync();
     void clear();
     void selected(const QModelIndex&);
+    void setGrouping(int);
 
 signals:
     void instSelected(const qmf::Data&);
+    void classSelected(const QString&, const QString&);
+
+    //
+    // A live object has left the store, whether deleted, dropped with its agent
+    // or broker, or not returned by a resync.
+    //
+    void objectRemoved(const qmf::Data&);
 
 private:
-    typedef enum { NODE_PACKAGE, NODE_SCHEMA, NODE_INSTANCE } NodeType;
+    typedef enum { NODE_BROKER, NODE_PACKAGE, NODE_SCHEMA, NODE_AGENT, NODE_INSTANCE } NodeType;
     struct ObjectIndex;
+    struct ObjectRecord;
     typedef boost::shared_ptr<ObjectIndex> ObjectIndexPtr;
+    typedef boost::shared_ptr<ObjectRecord> ObjectRecordPtr;
     typedef std::map<quint32, ObjectIndexPtr> IndexMap;
     typedef std::list<ObjectIndexPtr> IndexList;
 
+    //
+    // Object records by the broker and agent that reported them, so an agent's
+    // objects can be found without walking the tree.
+    //
+    typedef std::map<std::pair<std::string, std::string>, std::set<ObjectRecord*> > AgentObjectMap;
+
+    //
+    // The one copy of each object, shared by whichever grouping is shown.  Records
+    // are keyed by object key; a record read from a snapshot has no data until it
+    // is first used.
+    //
+    struct ObjectRecord {
+        const std::string* key;
+        std::string broker;
+        qmf::Data object;
+        qint64 offset;
+        ObjectIndex* node;
+        AgentObjectMap::value_type* owner;
+
+        //
+        // Not yet reported again since the broker reconnected.
+        //
+        bool stale;
+    };
+    typedef std::map<std::string, ObjectRecordPtr> RecordMap;
+
     struct ObjectIndex {
         quint32 id;
         int row;
@@ -71,16 +159,54 @@ private:
         std::string text;
         ObjectIndexPtr parent;
         IndexList children;
-        qmf::Data object;
+
+        //
+        // Instance nodes: the record shown.
+        //
+        ObjectRecordPtr record;
+
+        //
+        // Class nodes of a snapshot: the records not yet read into the tree.
+        //
+        qint64 pendingBegin;
+        qint64 pendingEnd;
     };
 
-    IndexList packages;
+    //
+    // The packages and classes each broker announced, as (package, class) with an
+    // empty class for a package on its own.  The package-first groupings show them
+    // whether or not they have instances.  An announcement names no agent, so the
+    // agent grouping shows a class only beneath the agents with objects of it.
+    //
+    typedef std::set<std::pair<std::string, std::string> > ClassSet;
+    typedef std::map<std::string, ClassSet> AnnouncedMap;
+
+    IndexList brokers;
     IndexMap linkage;
+    RecordMap records;
+    AgentObjectMap byAgent;
+    AnnouncedMap announced;
+    std::set<std::string> resyncing;
+    std::vector<qmf::Data> removed;
+    SnapshotFilePtr snapshot;
+    Grouping currentGrouping;
+    bool rebuilding;
     quint32 nextId;
 
+    const qmf::Data& recordObject(const ObjectRecordPtr&) const;
+    void readClass(const SnapshotFile::ClassRange&, std::vector<qmf::Data>&) const;
     void renumber(IndexList&);
+    void unlink(const ObjectIndexPtr&);
+    void disown(ObjectRecord*);
+    void removeInstances(const std::vector<ObjectIndexPtr>&);
+    void announceRemoved();
+    void pruneEmpty(const ObjectIndexPtr&);
+    bool isAnnounced(const ObjectIndexPtr&) const;
+    void placeRecord(const ObjectRecordPtr&);
+    void rebuild();
+    ObjectIndexPtr brokerNode(const std::string&);
     ObjectIndexPtr findOrInsertNode(IndexList&, NodeType, ObjectIndexPtr, const std::string&,
-                                   const qmf::Data&, QModelIndex, IndexList::iterator&);
+                                   QModelIndex, IndexList::iterator&);
 };
 
 #endif
@@ -18,39 +18,157 @@
  */
 
 #include "qmf-thread.h"
+#include "session-opener.h"
+#include "explorer-stats.h"
+#include "event-rates.h"
+#include "trace.h"
+#include "qmf-variant.h"
+#include "agent-filter.h"
+#include "series-store.h"
+#include <QSettings>
 #include <qpid/messaging/exceptions.h>
 #include <qmf/Query.h>
+#include <qmf/SchemaId.h>
+#include <qmf/SchemaTypes.h>
 
 #include <iostream>
 #include <string>
+#include <algorithm>
 
 using std::cout;
 using std::endl;
 
-QmfThread::QmfThread(QObject* parent, AgentModel* agents, QLineEdit* f, ObjectModel* o) :
-    QThread(parent), cancelled(false), connected(false), agentModel(agents), agentFilter(f), objectModel(o)
+namespace {
+    //
+    // Default number of seconds between re-queries of known objects.
+    //
+    const int DEFAULT_POLL_INTERVAL = 10;
+
+    //
+    // Reconnect delays, in milliseconds.  The delay doubles after each failed
+    // attempt up to the maximum.
+    //
+    const int RECONNECT_DELAY_MIN = 1000;
+    const int RECONNECT_DELAY_MAX = 60000;
+
+    //
+    // A resync ends once every query it issued has completed and agents have had
+    // time to announce themselves, or after the timeout regardless.
+    //
+    const int RESYNC_SETTLE = 3000;
+    const int RESYNC_TIMEOUT = 30000;
+
+    //
+    // Default number of seconds allowed for a connection to open.
+    //
+    const int DEFAULT_CONNECT_TIMEOUT = 10;
+
+    //
+    // Longest time, in milliseconds, the thread blocks before it looks at its command
+    // queue and the cancel flag again.
+    //
+    const int COMMAND_LATENCY = 50;
+
+    //
+    // Upper bound on method calls sent but not yet answered.  Further calls wait
+    // in the queue until earlier ones complete.
+    //
+    const size_t MAX_OUTSTANDING_CALLS = 256;
+
+    //
+    // Milliseconds between liveness sweeps of the agent table.
+    //
+    const qint64 LIVENESS_SWEEP = 1000;
+}
+
+QmfThread::QmfThread(QObject* parent, AgentModel* agents, ObjectModel* o) :
+    QThread(parent), cancelled(false), connected(false), pollInterval(DEFAULT_POLL_INTERVAL),
+    reconnecting(false), reconnectDelay(RECONNECT_DELAY_MIN), resyncing(false), lastSweep(0),
+    agentModel(agents), objectModel(o)
 {
-    // Intentionally Left Blank
+    QSettings settings;
+    connectTimeout = settings.value("Connection/connectTimeout", DEFAULT_CONNECT_TIMEOUT).toInt();
+    agentFilter = AgentFilter::current().toStdString();
+    QStringList properties(SeriesStore::trackedProperties());
+    for (QStringList::const_iterator iter = properties.begin(); iter != properties.end(); iter++)
+        polledProperties.insert(iter->toStdString());
+    callClock.start();
 }
 
 
 void QmfThread::cancel()
 {
+    QMutexLocker locker(&lock);
     cancelled = true;
+    cond.wakeAll();
+}
+
+
+bool QmfThread::isCancelled() const
+{
+    QMutexLocker locker(&lock);
+    return cancelled;
+}
+
+
+bool QmfThread::interrupted() const
+{
+    QMutexLocker locker(&lock);
+    if (cancelled)
+        return true;
+    for (command_queue_t::const_iterator iter = command_queue.begin(); iter != command_queue.end(); iter++)
+        if (iter->type == CMD_DISCONNECT)
+            return true;
+    return false;
+}
+
+
+std::string QmfThread::brokerName(const QObject* sender)
+{
+    //
+    // Anything else has no broker; receivers ignore the call rather than credit
+    // it to the wrong connection.
+    //
+    if (qobject_cast<const QmfThread*>(sender))
+        return sender->objectName().toStdString();
+    return std::string();
+}
+
+
+bool QmfThread::hasAgent(const std::string& name) const
+{
+    QMutexLocker locker(&lock);
+    return agents.find(name) != agents.end();
+}
+
+
+void QmfThread::callMethod(quint64 id, const qmf::Data& object, const std::string& method,
+                           const qpid::types::Variant::Map& args, int timeout)
+{
+    MethodCall call;
+    call.id = id;
+    call.addr = object.getAddr();
+    call.method = method;
+    call.args = args;
+    call.timeout = timeout;
+
+    QMutexLocker locker(&lock);
+    method_queue.push_back(call);
+    cond.wakeOne();
 }
 
 
 void QmfThread::connect_localhost()
 {
     QMutexLocker locker(&lock);
-    command_queue.push_back(Command(true, "localhost", "", "{strict-security:False}"));
+    command_queue.push_back(Command(CMD_CONNECT, "localhost", "", "{strict-security:False}"));
     cond.wakeOne();
 }
 
 void QmfThread::connect_url(const QString& url, const QString& conn_options, const QString& qmf_options)
 {
     QMutexLocker locker(&lock);
-    command_queue.push_back((Command(true, url.toStdString(),
+    command_queue.push_back((Command(CMD_CONNECT, url.toStdString(),
                                      conn_options.toStdString(),
                                      qmf_options.toStdString())));
     cond.wakeOne();
@@ -59,19 +177,465 @@ void QmfThread::connect_url(const QString& url, const QString& conn_options, con
 void QmfThread::disconnect()
 {
     QMutexLocker locker(&lock);
-    command_queue.push_back(Command(false, "", "", ""));
+    command_queue.push_back(Command(CMD_DISCONNECT, "", "", ""));
     cond.wakeOne();
 }
 
 
-void QmfThread::applyAgentFilter()
+void QmfThread::setAgentFilter(const QString& filter)
+{
+    QMutexLocker locker(&lock);
+    command_queue.push_back(Command(filter.trimmed().toStdString()));
+    cond.wakeOne();
+}
+
+
+void QmfThread::setPollInterval(int seconds)
+{
+    QMutexLocker locker(&lock);
+    pollInterval = seconds;
+}
+
+
+void QmfThread::setConnectTimeout(int seconds)
+{
+    QMutexLocker locker(&lock);
+    connectTimeout = seconds;
+}
+
+
+std::string QmfThread::pollKey(const qmf::Agent& agent, const qmf::SchemaId& schemaId)
+{
+    return agent.getName() + "/" + schemaId.getPackageName() + "/" + schemaId.getName();
+}
+
+
+void QmfThread::addPoll(const qmf::Agent& agent, const qmf::SchemaId& schemaId)
 {
-    if (connected)
+    //
+    // A class reported again keeps what was learned about it.
+    //
+    std::string key(pollKey(agent, schemaId));
+    poll_map_t::iterator iter(polled.find(key));
+    if (iter != polled.end()) {
+        iter->second.agent = agent;
+        iter->second.schemaId = schemaId;
+        return;
+    }
+
+    PollEntry entry;
+    entry.agent = agent;
+    entry.schemaId = schemaId;
+    entry.checked = false;
+    entry.periodic = false;
+    polled[key] = entry;
+}
+
+
+void QmfThread::classifyPoll(const qmf::Agent& agent, const qmf::Data& object)
+{
+    poll_map_t::iterator iter(polled.find(pollKey(agent, object.getSchemaId())));
+    if (iter == polled.end() || iter->second.checked)
+        return;
+    iter->second.checked = true;
+
+    const qpid::types::Variant::Map& properties(object.getProperties());
+    for (qpid::types::Variant::Map::const_iterator prop = properties.begin(); prop != properties.end(); prop++)
+        if (polledProperties.find(prop->first) != polledProperties.end()) {
+            iter->second.periodic = true;
+            return;
+        }
+}
+
+
+void QmfThread::removePolls(const qmf::Agent& agent)
+{
+    std::string prefix(agent.getName() + "/");
+    poll_map_t::iterator iter(polled.lower_bound(prefix));
+    while (iter != polled.end() && iter->first.compare(0, prefix.size(), prefix) == 0)
+        polled.erase(iter++);
+}
+
+
+void QmfThread::dropAgent(const qmf::Agent& agent)
+{
+    removePolls(agent);
+    liveness.remove(agent.getName());
+    emit delAgent(agent);
+}
+
+
+void QmfThread::poll()
+{
+    int interval;
+    {
+        QMutexLocker locker(&lock);
+        interval = pollInterval;
+    }
+
+    if (interval <= 0 || pollTimer.elapsed() < interval * 1000)
+        return;
+    pollTimer.restart();
+
+    //
+    // Re-query the classes with a history so that data stays current.  The rest
+    // are configuration and are not downloaded again.
+    //
+    for (poll_map_t::iterator iter = polled.begin(); iter != polled.end(); iter++)
+        if (iter->second.periodic)
+            trackQuery(iter->second.agent.queryAsync(qmf::Query(qmf::QUERY_OBJECT, iter->second.schemaId)));
+}
+
+
+void QmfThread::requery(const qmf::Agent& agent)
+{
+    //
+    // Polls are keyed by agent first, so one agent's classes are a single range.
+    //
+    std::string prefix(agent.getName() + "/");
+    for (poll_map_t::const_iterator iter = polled.lower_bound(prefix);
+         iter != polled.end() && iter->first.compare(0, prefix.size(), prefix) == 0; iter++)
+        trackQuery(iter->second.agent.queryAsync(qmf::Query(qmf::QUERY_OBJECT, iter->second.schemaId)));
+}
+
+
+void QmfThread::agentSeen(const qmf::Agent& agent)
+{
+    AgentLiveness::ChangeList changes;
+    liveness.seen(agent, callClock.elapsed(), changes);
+    if (!changes.empty())
+        livenessChanged(changes);
+}
+
+
+void QmfThread::sweepLiveness()
+{
+    qint64 now(callClock.elapsed());
+    if (now - lastSweep < LIVENESS_SWEEP)
+        return;
+    lastSweep = now;
+
+    //
+    // With polling on, agents are expected to answer at least once per poll, so
+    // a poll interval longer than the heartbeat does not make them late.
+    //
+    int interval;
+    {
+        QMutexLocker locker(&lock);
+        interval = pollInterval;
+    }
+
+    AgentLiveness::ChangeList changes;
+    std::vector<qmf::Agent> probe;
+    liveness.sweep(now, interval > 0 ? (qint64) interval * 1000 : 0, changes, probe);
+    if (!changes.empty())
+        livenessChanged(changes);
+
+    //
+    // Only overdue agents are probed, with a query for their schema ids, which
+    // is the smallest thing an agent will answer.
+    //
+    for (std::vector<qmf::Agent>::const_iterator iter = probe.begin(); iter != probe.end(); iter++)
+        try {
+            liveness.probed(iter->getName(), iter->queryAsync(qmf::Query(qmf::QUERY_SCHEMA_ID)), now);
+        } catch (qmf::QmfException&) {
+            //
+            // A probe that cannot be sent counts as unanswered.
+            //
+            liveness.probed(iter->getName(), 0, now);
+        }
+}
+
+
+void QmfThread::livenessChanged(const AgentLiveness::ChangeList& changes)
+{
+    for (AgentLiveness::ChangeList::const_iterator iter = changes.begin(); iter != changes.end(); iter++) {
+        //
+        // Re-read only this agent's objects.  A restarted agent may also have
+        // changed its schema, so that is asked for again and its response
+        // re-queries the classes.
+        //
+        if (iter->requery) {
+            if (iter->restarted)
+                trackQuery(iter->agent.querySchemaAsync());
+            requery(iter->agent);
+        }
+        emit agentLiveness(iter->agent, (int) iter->state, iter->restarts);
+    }
+}
+
+
+void QmfThread::issueCalls()
+{
+    method_queue_t calls;
+    {
+        QMutexLocker locker(&lock);
+        while (!method_queue.empty() && pendingCalls.size() + calls.size() < MAX_OUTSTANDING_CALLS) {
+            calls.push_back(method_queue.front());
+            method_queue.pop_front();
+        }
+    }
+
+    //
+    // Calls are sent without waiting for earlier ones, so a bulk operation is
+    // limited by the broker rather than by the round trip.
+    //
+    for (method_queue_t::const_iterator iter = calls.begin(); iter != calls.end(); iter++) {
+        qmf::Agent agent;
+        {
+            QMutexLocker locker(&lock);
+            agent_map_t::const_iterator aiter(agents.find(iter->addr.getAgentName()));
+            if (aiter != agents.end())
+                agent = aiter->second;
+        }
+
+        if (!agent.isValid()) {
+            QVariantMap error;
+            error["error"] = QString("agent not found");
+            emit methodResponse(iter->id, false, error);
+            continue;
+        }
+
         try {
-            sess.setAgentFilter(agentFilter->text().toStdString());
-        } catch (qmf::QmfException& e) {
-            cout << "Exception: " << e.what() << endl;
+            PendingCall pending;
+            pending.id = iter->id;
+            pending.deadline = callClock.elapsed() + (qint64) iter->timeout * 1000;
+            pendingCalls[agent.callMethodAsync(iter->method, iter->args, iter->addr)] = pending;
+        } catch (qmf::QmfException& ex) {
+            QVariantMap error;
+            error["error"] = QString(ex.what());
+            emit methodResponse(iter->id, false, error);
+        }
+    }
+}
+
+
+void QmfThread::expireCalls()
+{
+    qint64 now(callClock.elapsed());
+    pending_map_t::iterator iter(pendingCalls.begin());
+    while (iter != pendingCalls.end()) {
+        if (iter->second.deadline <= now) {
+            QVariantMap error;
+            error["error"] = QString("timed out");
+            emit methodResponse(iter->second.id, false, error);
+            pendingCalls.erase(iter++);
+        } else
+            iter++;
+    }
+}
+
+
+void QmfThread::failCalls(const std::string& reason)
+{
+    QVariantMap error;
+    error["error"] = QString(reason.c_str());
+
+    for (pending_map_t::const_iterator iter = pendingCalls.begin(); iter != pendingCalls.end(); iter++)
+        emit methodResponse(iter->second.id, false, error);
+    pendingCalls.clear();
+
+    method_queue_t calls;
+    {
+        QMutexLocker locker(&lock);
+        calls.swap(method_queue);
+    }
+    for (method_queue_t::const_iterator iter = calls.begin(); iter != calls.end(); iter++)
+        emit methodResponse(iter->id, false, error);
+}
+
+
+void QmfThread::methodResult(uint32_t correlator, bool succeeded, const qpid::types::Variant::Map& values)
+{
+    pending_map_t::iterator iter(pendingCalls.find(correlator));
+    if (iter == pendingCalls.end())
+        return;
+
+    QVariantMap results;
+    for (qpid::types::Variant::Map::const_iterator viter = values.begin(); viter != values.end(); viter++)
+        results[QString(viter->first.c_str())] = QmfVariant::toQVariant(viter->second);
+
+    emit methodResponse(iter->second.id, succeeded, results);
+    pendingCalls.erase(iter);
+}
+
+
+void QmfThread::trackQuery(uint32_t correlator)
+{
+    if (resyncing)
+        resyncPending.insert(correlator);
+}
+
+
+void QmfThread::checkResync()
+{
+    if (!resyncing)
+        return;
+
+    qint64 elapsed(resyncTimer.elapsed());
+    if ((resyncPending.empty() && elapsed >= RESYNC_SETTLE) || elapsed >= RESYNC_TIMEOUT) {
+        resyncing = false;
+        resyncPending.clear();
+        emit resyncFinished();
+    }
+}
+
+
+bool QmfThread::openSession(const std::string& url, const std::string& conn_options, const std::string& qmf_options)
+{
+    int timeout;
+    {
+        QMutexLocker locker(&lock);
+        timeout = connectTimeout;
+    }
+
+    //
+    // The blocking open runs on a helper thread.  This thread keeps watching for a
+    // cancel, a disconnect or the connect timeout and walks away from the attempt on
+    // any of them.
+    //
+    emit connectionStatusChanged("QMF connection opening...");
+    SessionOpener::ResultPtr result(SessionOpener::open(url, conn_options, qmf_options, agentFilter));
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!result->wait(COMMAND_LATENCY)) {
+        if (interrupted()) {
+            result->abandon();
+            emit connectionStatusChanged("Closed");
+            return false;
+        }
+        if (timeout > 0 && timer.elapsed() >= timeout * 1000) {
+            result->abandon();
+            std::stringstream line;
+            line << "QMF Session Failed: no response from " << url << " after " << timeout << "s";
+            emit connectionStatusChanged(line.str().c_str());
+            return false;
+        }
+    }
+
+    if (!result->succeeded()) {
+        std::stringstream line;
+        line << "QMF Session Failed: " << result->error();
+        emit connectionStatusChanged(line.str().c_str());
+        return false;
+    }
+
+    conn = result->connection();
+    sess = result->session();
+    connected = true;
+    pollTimer.start();
+
+    lastUrl = url;
+    lastConnOptions = conn_options;
+    lastQmfOptions = qmf_options;
+
+    std::stringstream line;
+    line << "Operational (URL: " << url << ")";
+    emit connectionStatusChanged(line.str().c_str());
+    return true;
+}
+
+
+void QmfThread::closeSession()
+{
+    //
+    // Closing talks to the broker and can hang on a dead network, so it is left to a
+    // helper thread as well.
+    //
+    SessionOpener::close(conn, sess);
+    conn = qpid::messaging::Connection();
+    sess = qmf::ConsoleSession();
+    {
+        QMutexLocker locker(&lock);
+        agents.clear();
+    }
+    failCalls("connection closed");
+    polled.clear();
+    liveness.clear();
+    resyncPending.clear();
+    connected = false;
+}
+
+
+void QmfThread::connectionLost(const std::string& reason)
+{
+    //
+    // Keep the models as they are and try to get back.  The agent handles belong to
+    // the dead session so nothing can be polled until the reconnect.
+    //
+    closeSession();
+    resyncing = false;
+    reconnecting = true;
+    reconnectDelay = RECONNECT_DELAY_MIN;
+    reconnectTimer.start();
+
+    std::stringstream line;
+    line << "Connection lost (" << reason << "), reconnecting in " << reconnectDelay / 1000 << "s...";
+    emit connectionStatusChanged(line.str().c_str());
+}
+
+
+void QmfThread::retryConnection()
+{
+    if (openSession(lastUrl, lastConnOptions, lastQmfOptions)) {
+        reconnecting = false;
+        reconnectDelay = RECONNECT_DELAY_MIN;
+        resyncing = true;
+        resyncPending.clear();
+        resyncTimer.start();
+        emit resyncStarted();
+        return;
+    }
+
+    if (interrupted())
+        return;
+
+    reconnectDelay = std::min(reconnectDelay * 2, RECONNECT_DELAY_MAX);
+    reconnectTimer.start();
+
+    std::stringstream line;
+    line << "Reconnect failed, retrying in " << reconnectDelay / 1000 << "s...";
+    emit connectionStatusChanged(line.str().c_str());
+}
+
+
+void QmfThread::applyAgentFilter(const std::string& filter)
+{
+    agentFilter = filter;
+    if (!connected)
+        return;
+
+    try {
+        sess.setAgentFilter(filter);
+    } catch (qmf::QmfException& ex) {
+        std::stringstream line;
+        line << "Agent filter rejected: " << ex.what();
+        emit connectionStatusChanged(line.str().c_str());
+        return;
+    }
+
+    //
+    // Only the agents that no longer match are removed here.  Those that newly
+    // match are reported by the console as they answer its locate request, so
+    // neither tree is rebuilt.
+    //
+    std::vector<qmf::Agent> dropped;
+    if (!filter.empty()) {
+        qmf::Query query(qmf::QUERY_OBJECT, filter);
+        QMutexLocker locker(&lock);
+        agent_map_t::iterator iter(agents.begin());
+        while (iter != agents.end()) {
+            if (!query.matchesPredicate(iter->second.getAttributes())) {
+                dropped.push_back(iter->second);
+                agents.erase(iter++);
+            } else
+                iter++;
         }
+    }
+
+    for (std::vector<qmf::Agent>::const_iterator iter = dropped.begin(); iter != dropped.end(); iter++)
+        dropAgent(*iter);
 }
 
 
@@ -83,115 +647,215 @@ void QmfThread::run()
         if (connected) {
             qmf::ConsoleEvent event;
             uint32_t pcount;
-            int i;
-
-            if (sess.nextEvent(event, qpid::messaging::Duration::SECOND)) {
-                //
-                // Process the event
-                //
-                qmf::Agent agent = event.getAgent();
-                switch (event.getType()) {
-                case qmf::CONSOLE_AGENT_ADD :
-                    emit newAgent(agent);
-                    agent.querySchemaAsync();
-                    break;
-
-                case qmf::CONSOLE_AGENT_DEL :
-                    emit delAgent(agent);
-                    break;
-
-                case qmf::CONSOLE_AGENT_SCHEMA_UPDATE :
-                    agent.querySchemaAsync();
-                    break;
-
-                case qmf::CONSOLE_AGENT_SCHEMA_RESPONSE :
-                    // The agent schema response is coming in as
-                    // an query response. This is a bug
-                case qmf::CONSOLE_QUERY_RESPONSE :
-                    // Handle the agent schema response
-                    pcount = event.getSchemaIdCount();
-                    for (uint32_t idx = 0; idx < pcount; idx++) {
-                        agent.queryAsync(qmf::Query(qmf::QUERY_OBJECT, event.getSchemaId(idx)));
-                    }
 
-                    // Handle the query response
-                    pcount = event.getDataCount();
-                    for (uint32_t idx = 0; idx < pcount; idx++) {
-                        emit addObject(event.getData(idx));
+            try {
+                bool haveEvent;
+                {
+                    QE_TRACE_SCOPE("ConsoleSession::nextEvent");
+                    haveEvent = sess.nextEvent(event, qpid::messaging::Duration::MILLISECOND * COMMAND_LATENCY);
+                }
+
+                if (haveEvent) {
+                    //
+                    // Process the event
+                    //
+                    QE_TRACE_SCOPE("QmfThread::dispatch");
+                    qmf::Agent agent = event.getAgent();
+                    ExplorerStats::instance().countEvent(event.getType());
+
+                    //
+                    // The answer to a liveness probe only shows the agent is there.
+                    //
+                    bool probe(false);
+                    if (agent.isValid() && event.getType() != qmf::CONSOLE_AGENT_ADD &&
+                        event.getType() != qmf::CONSOLE_AGENT_DEL) {
+                        probe = liveness.isProbe(agent.getName(), event.getCorrelator());
+                        agentSeen(agent);
                     }
 
-                    break;
+                    switch (event.getType()) {
+                    case qmf::CONSOLE_AGENT_ADD :
+                        {
+                            QMutexLocker locker(&lock);
+                            agents[agent.getName()] = agent;
+                        }
+                        liveness.add(agent, callClock.elapsed());
+                        ExplorerStats::instance().emitted(ExplorerStats::CHANNEL_AGENT);
+                        emit newAgent(agent);
+                        trackQuery(agent.querySchemaAsync());
+                        break;
 
-                case qmf::CONSOLE_METHOD_RESPONSE :
-                    i=2;
-                    break;
+                    case qmf::CONSOLE_AGENT_DEL :
+                        {
+                            //
+                            // An agent dropped by a filter change is already gone.
+                            //
+                            QMutexLocker locker(&lock);
+                            if (agents.erase(agent.getName()) == 0)
+                                break;
+                        }
+                        dropAgent(agent);
+                        break;
 
-                case qmf::CONSOLE_EVENT :
-                    emit newEvent(event);
-                    break;
-                default :
-                    break;
-                }
+                    case qmf::CONSOLE_AGENT_SCHEMA_UPDATE :
+                        trackQuery(agent.querySchemaAsync());
+                        break;
+
+                    case qmf::CONSOLE_AGENT_SCHEMA_RESPONSE :
+                        // The agent schema response is coming in as
+                        // an query response. This is a bug
+                    case qmf::CONSOLE_QUERY_RESPONSE :
+                        if (probe)
+                            break;
+
+                        // Handle the agent schema response
+                        // Only data classes have objects to query; event classes are skipped.
+                        pcount = event.getSchemaIdCount();
+                        for (uint32_t idx = 0; idx < pcount; idx++) {
+                            const qmf::SchemaId& schemaId(event.getSchemaId(idx));
+                            if (schemaId.getType() != qmf::SCHEMA_TYPE_DATA)
+                                continue;
+                            trackQuery(agent.queryAsync(qmf::Query(qmf::QUERY_OBJECT, schemaId)));
+                            addPoll(agent, schemaId);
+                        }
 
+                        // Handle the query response; a response holds objects of one class
+                        pcount = event.getDataCount();
+                        if (pcount > 0)
+                            classifyPoll(agent, event.getData(0));
+                        for (uint32_t idx = 0; idx < pcount; idx++) {
+                            ExplorerStats::instance().emitted(ExplorerStats::CHANNEL_OBJECT);
+                            emit addObject(event.getData(idx));
+                        }
+
+                        if (event.isFinal())
+                            resyncPending.erase(event.getCorrelator());
+                        break;
+
+                    case qmf::CONSOLE_EXCEPTION :
+                        if (event.isFinal())
+                            resyncPending.erase(event.getCorrelator());
+                        if (event.getDataCount() > 0)
+                            methodResult(event.getCorrelator(), false, event.getData(0).getProperties());
+                        else
+                            methodResult(event.getCorrelator(), false, qpid::types::Variant::Map());
+                        break;
+
+                    case qmf::CONSOLE_METHOD_RESPONSE :
+                        methodResult(event.getCorrelator(), true, event.getArguments());
+                        break;
+
+                    case qmf::CONSOLE_EVENT :
+                        //
+                        // Rates are counted here, ahead of the queue to the GUI thread.
+                        //
+                        for (uint32_t idx = 0; idx < event.getDataCount(); idx++) {
+                            qmf::Data data(event.getData(idx));
+                            const qmf::SchemaId& schemaId(data.getSchemaId());
+                            EventRates::instance().record(schemaId.getPackageName() + ":" + schemaId.getName(),
+                                                          (int) event.getSeverity());
+                        }
+                        ExplorerStats::instance().emitted(ExplorerStats::CHANNEL_EVENT);
+                        emit newEvent(event);
+                        break;
+
+                    case qmf::CONSOLE_THREAD_FAILED :
+                        connectionLost("session thread failed");
+                        break;
+                    default :
+                        break;
+                    }
+
+                } else if (!conn.isOpen())
+                    connectionLost("closed by peer");
+
+                if (connected) {
+                    issueCalls();
+                    expireCalls();
+                    poll();
+                    sweepLiveness();
+                    checkResync();
+                }
+            } catch (qpid::messaging::MessagingException& ex) {
+                connectionLost(ex.what());
             }
 
+            bool closing(false);
+            bool filtering(false);
+            std::string filter;
             {
                 QMutexLocker locker(&lock);
-                if (command_queue.size() > 0) {
+                if (connected && command_queue.size() > 0) {
                     Command command(command_queue.front());
                     command_queue.pop_front();
-                    if (!command.connect) {
-                        emit connectionStatusChanged("QMF Session Closing...");
-                        sess.close();
-                        emit connectionStatusChanged("Closing...");
-                        conn.close();
-                        emit connectionStatusChanged("Closed");
-                        connected = false;
-                        emit isConnected(false);
-                    }
+                    closing = command.type == CMD_DISCONNECT;
+                    filtering = command.type == CMD_FILTER;
+                    filter = command.filter;
                 }
             }
-        } else {
-            QMutexLocker locker(&lock);
-            if (command_queue.size() == 0)
-                cond.wait(&lock, 1000);
-            if (command_queue.size() > 0) {
-                Command command(command_queue.front());
-                command_queue.pop_front();
-                if (command.connect & !connected)
-                    try {
-                        emit connectionStatusChanged("QMF connection opening...");
-
-                        conn = qpid::messaging::Connection(command.url, command.conn_options);
-                        conn.open();
-
-                        emit connectionStatusChanged("QMF session opening...");
-                        sess = qmf::ConsoleSession(conn, command.qmf_options);
-                        sess.open();
-                        try {
-                            sess.setAgentFilter("[eq, _product, [quote, 'qpidd']]");
-
-                            //sess.setAgentFilter(agentFilter->text().toStdString());
-                        } catch (std::exception&) {}
-                        connected = true;
-                        emit isConnected(true);
 
-                        std::stringstream line;
-                        line << "Operational (URL: " << command.url << ")";
-                        emit connectionStatusChanged(line.str().c_str());
-                    } catch(qpid::messaging::MessagingException& ex) {
-                        std::stringstream line;
-                        line << "QMF Session Failed: " << ex.what();
-                        emit connectionStatusChanged(line.str().c_str());
-                    }
+            if (filtering)
+                applyAgentFilter(filter);
+
+            if (closing) {
+                emit connectionStatusChanged("QMF Session Closing...");
+                closeSession();
+                emit connectionStatusChanged("Closed");
+                resyncing = false;
+                emit isConnected(false);
             }
+        } else {
+            Command command(CMD_DISCONNECT, "", "", "");
+            bool haveCommand(false);
+            {
+                QMutexLocker locker(&lock);
+                if (command_queue.size() == 0 && !cancelled)
+                    cond.wait(&lock, reconnecting ? std::min(1000, std::max(0, reconnectDelay - (int) reconnectTimer.elapsed())) : 1000);
+                if (command_queue.size() > 0) {
+                    command = command_queue.front();
+                    command_queue.pop_front();
+                    haveCommand = true;
+                }
+            }
+
+            //
+            // The lock is not held while opening so that cancel() and further commands
+            // can get through.
+            //
+            if (haveCommand) {
+                if (command.type == CMD_FILTER) {
+                    //
+                    // Kept for the next session, which opens with it.
+                    //
+                    applyAgentFilter(command.filter);
+                } else if (command.type == CMD_DISCONNECT && reconnecting) {
+                    //
+                    // Closing while waiting to reconnect gives up on the broker.
+                    //
+                    reconnecting = false;
+                    emit connectionStatusChanged("Closed");
+                    emit isConnected(false);
+                } else if (command.type == CMD_CONNECT && reconnecting) {
+                    //
+                    // An explicit open while waiting retries at once.  The models still
+                    // hold the broker's state so it is reconciled like any reconnect.
+                    //
+                    lastUrl = command.url;
+                    lastConnOptions = command.conn_options;
+                    lastQmfOptions = command.qmf_options;
+                    reconnectDelay = RECONNECT_DELAY_MIN;
+                    retryConnection();
+                } else if (command.type == CMD_CONNECT && !connected) {
+                    if (openSession(command.url, command.conn_options, command.qmf_options))
+                        emit isConnected(true);
+                }
+            } else if (reconnecting && !isCancelled() && reconnectTimer.elapsed() >= reconnectDelay)
+                retryConnection();
         }
 
-        if (cancelled) {
-            if (connected) {
-                sess.close();
-                conn.close();
-            }
+        if (isCancelled()) {
+            if (connected)
+                closeSession();
             break;
         }
     }
@@ -22,31 +22,63 @@
 #include <QThread>
 #include <QMutex>
 #include <QWaitCondition>
-#include <QLineEdit>
+#include <QElapsedTimer>
 #include <QStringList>
+#include <QVariantMap>
 
 #include <qpid/messaging/Connection.h>
 #include <qmf/ConsoleSession.h>
 #include <qmf/ConsoleEvent.h>
 #include <qmf/Data.h>
 #include <qmf/SchemaId.h>
+#include <qmf/DataAddr.h>
 #include "agent-model.h"
 #include "object-model.h"
+#include "agent-liveness.h"
 #include <sstream>
 #include <deque>
+#include <map>
+#include <set>
 
 class QmfThread : public QThread {
     Q_OBJECT
 
 public:
-    QmfThread(QObject* parent, AgentModel* agents, QLineEdit* agentFilter, ObjectModel* objects);
+    QmfThread(QObject* parent, AgentModel* agents, ObjectModel* objects);
     void cancel();
 
+    //
+    // The broker a signal came from.  Each thread is named after the URL of its
+    // broker so receivers can tell connections apart through QObject::sender().
+    // The name is empty when the sender is not a QmfThread.
+    //
+    static std::string brokerName(const QObject* sender);
+
+    //
+    // Whether the agent is currently known on this thread's broker.
+    //
+    bool hasAgent(const std::string&) const;
+
+    //
+    // Queue an asynchronous method call on an object.  Any number of calls may be
+    // outstanding; the result is reported through methodResponse under the given id,
+    // or as a failure if no response arrives within the timeout (in seconds).
+    //
+    void callMethod(quint64 id, const qmf::Data& object, const std::string& method,
+                    const qpid::types::Variant::Map& args, int timeout);
+
 public slots:
     void connect_localhost();
     void disconnect();
-    void applyAgentFilter();
+
+    //
+    // Replace the agent filter, a QMF query predicate already checked with
+    // AgentFilter::validate.  It is queued like a connect and kept for reconnects.
+    //
+    void setAgentFilter(const QString&);
     void connect_url(const QString&, const QString&, const QString&);
+    void setPollInterval(int);
+    void setConnectTimeout(int);
 
 signals:
     void connectionStatusChanged(const QString&);
@@ -58,21 +90,73 @@ signals:
     void newClass(const QStringList&);
     void newEvent(const qmf::ConsoleEvent&);
 
+    //
+    // Bracket the initial download after an automatic reconnect.  Receivers keep
+    // what they already know from this broker and drop whatever was not reported
+    // again by the time the resync finishes.
+    //
+    void resyncStarted();
+    void resyncFinished();
+
+    void methodResponse(quint64, bool, const QVariantMap&);
+
+    //
+    // An agent changed liveness state (AgentLiveness::State) or restarted.
+    //
+    void agentLiveness(const qmf::Agent&, int, uint);
+
 protected:
     void run();
 
 private:
+    typedef enum { CMD_CONNECT, CMD_DISCONNECT, CMD_FILTER } CommandType;
+
     struct Command {
-        bool connect;
+        CommandType type;
         std::string url;
         std::string conn_options;
         std::string qmf_options;
+        std::string filter;
 
-        Command(bool _c, const std::string& _u, const std::string& _co, const std::string& _qo) :
-            connect(_c), url(_u), conn_options(_co), qmf_options(_qo) {}
+        Command(CommandType _t, const std::string& _u, const std::string& _co, const std::string& _qo) :
+            type(_t), url(_u), conn_options(_co), qmf_options(_qo) {}
+        Command(const std::string& _f) : type(CMD_FILTER), filter(_f) {}
     };
     typedef std::deque<Command> command_queue_t;
 
+    //
+    // The data classes of each agent, keyed by agent and class, so they can be
+    // queried again.  Only classes with a property that has a history are queried
+    // on every poll; which those are is learned from the first object received.
+    //
+    struct PollEntry {
+        qmf::Agent agent;
+        qmf::SchemaId schemaId;
+        bool checked;
+        bool periodic;
+    };
+    typedef std::map<std::string, PollEntry> poll_map_t;
+
+    //
+    // Method calls waiting to be sent, and those sent and awaiting their response
+    // keyed by the QMF correlator.
+    //
+    struct MethodCall {
+        quint64 id;
+        qmf::DataAddr addr;
+        std::string method;
+        qpid::types::Variant::Map args;
+        int timeout;
+    };
+    typedef std::deque<MethodCall> method_queue_t;
+
+    struct PendingCall {
+        quint64 id;
+        qint64 deadline;
+    };
+    typedef std::map<uint32_t, PendingCall> pending_map_t;
+    typedef std::map<std::string, qmf::Agent> agent_map_t;
+
     mutable QMutex lock;
     QWaitCondition cond;
     qpid::messaging::Connection conn;
@@ -80,9 +164,65 @@ private:
     bool cancelled;
     bool connected;
     command_queue_t command_queue;
+    poll_map_t polled;
+    std::set<std::string> polledProperties;
+    agent_map_t agents;
+    method_queue_t method_queue;
+    pending_map_t pendingCalls;
+    QElapsedTimer callClock;
+    int pollInterval;
+    int connectTimeout;
+    QElapsedTimer pollTimer;
+
+    //
+    // Automatic reconnect after the connection drops.  The last connect command is
+    // retried with an exponentially growing delay.
+    //
+    bool reconnecting;
+    int reconnectDelay;
+    QElapsedTimer reconnectTimer;
+    std::string lastUrl;
+    std::string lastConnOptions;
+    std::string lastQmfOptions;
+    std::string agentFilter;
+
+    //
+    // Queries issued since the reconnect that have not had their final response.
+    //
+    bool resyncing;
+    std::set<uint32_t> resyncPending;
+    QElapsedTimer resyncTimer;
+
+    AgentLiveness liveness;
+    qint64 lastSweep;
+
+    void addPoll(const qmf::Agent&, const qmf::SchemaId&);
+    void classifyPoll(const qmf::Agent&, const qmf::Data&);
+    static std::string pollKey(const qmf::Agent&, const qmf::SchemaId&);
+    void removePolls(const qmf::Agent&);
+    void dropAgent(const qmf::Agent&);
+    void applyAgentFilter(const std::string&);
+    void poll();
+    void requery(const qmf::Agent&);
+    void agentSeen(const qmf::Agent&);
+    void sweepLiveness();
+    void livenessChanged(const AgentLiveness::ChangeList&);
+
+    bool interrupted() const;
+    bool isCancelled() const;
+    bool openSession(const std::string&, const std::string&, const std::string&);
+    void closeSession();
+    void connectionLost(const std::string&);
+    void retryConnection();
+    void trackQuery(uint32_t);
+    void checkResync();
+
+    void issueCalls();
+    void expireCalls();
+    void failCalls(const std::string&);
+    void methodResult(uint32_t, bool, const qpid::types::Variant::Map&);
 
     AgentModel* agentModel;
-    QLineEdit* agentFilter;
     ObjectModel* objectModel;
 };
 
@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "qmf-variant.h"
+
+using qpid::types::Variant;
+
+namespace {
+
+    typedef enum { CLASS_VOID, CLASS_UNSIGNED, CLASS_SIGNED, CLASS_FLOAT, CLASS_OTHER } TypeClass;
+
+    TypeClass typeClass(const Variant& value)
+    {
+        switch (value.getType()) {
+        case qpid::types::VAR_VOID:
+            return CLASS_VOID;
+        case qpid::types::VAR_BOOL:
+        case qpid::types::VAR_UINT8:
+        case qpid::types::VAR_UINT16:
+        case qpid::types::VAR_UINT32:
+        case qpid::types::VAR_UINT64:
+            return CLASS_UNSIGNED;
+        case qpid::types::VAR_INT8:
+        case qpid::types::VAR_INT16:
+        case qpid::types::VAR_INT32:
+        case qpid::types::VAR_INT64:
+            return CLASS_SIGNED;
+        case qpid::types::VAR_FLOAT:
+        case qpid::types::VAR_DOUBLE:
+            return CLASS_FLOAT;
+        default:
+            break;
+        }
+        return CLASS_OTHER;
+    }
+
+    uint64_t unsignedValue(const Variant& value)
+    {
+        if (value.getType() == qpid::types::VAR_BOOL)
+            return value.asBool() ? 1 : 0;
+        return value.asUint64();
+    }
+
+    template <class T> int threeWay(T left, T right)
+    {
+        if (left < right)
+            return -1;
+        if (right < left)
+            return 1;
+        return 0;
+    }
+}
+
+
+bool QmfVariant::isNumeric(const Variant& value)
+{
+    TypeClass tc(typeClass(value));
+    return tc == CLASS_UNSIGNED || tc == CLASS_SIGNED || tc == CLASS_FLOAT;
+}
+
+
+QVariant QmfVariant::toQVariant(const Variant& value)
+{
+    switch (typeClass(value)) {
+    case CLASS_VOID:
+        return QVariant();
+    case CLASS_UNSIGNED:
+        if (value.getType() == qpid::types::VAR_BOOL)
+            return QVariant(value.asBool());
+        return QVariant((qulonglong) value.asUint64());
+    case CLASS_SIGNED:
+        return QVariant((qlonglong) value.asInt64());
+    case CLASS_FLOAT:
+        return QVariant(value.asDouble());
+    case CLASS_OTHER:
+        break;
+    }
+    return QVariant(QString(value.asString().c_str()));
+}
+
+
+int QmfVariant::compare(const Variant& left, const Variant& right)
+{
+    TypeClass lc(typeClass(left));
+    TypeClass rc(typeClass(right));
+
+    //
+    // Void sorts before anything else.
+    //
+    if (lc == CLASS_VOID || rc == CLASS_VOID)
+        return threeWay<int>(lc == CLASS_VOID ? 0 : 1, rc == CLASS_VOID ? 0 : 1);
+
+    //
+    // Non-numeric values sort after the numeric ones and compare as strings.
+    //
+    if (lc == CLASS_OTHER || rc == CLASS_OTHER) {
+        if (lc != rc)
+            return lc == CLASS_OTHER ? 1 : -1;
+        return left.asString().compare(right.asString());
+    }
+
+    if (lc == CLASS_FLOAT || rc == CLASS_FLOAT)
+        return threeWay<double>(lc == CLASS_UNSIGNED ? (double) unsignedValue(left) : left.asDouble(),
+                                rc == CLASS_UNSIGNED ? (double) unsignedValue(right) : right.asDouble());
+
+    if (lc == CLASS_UNSIGNED && rc == CLASS_UNSIGNED)
+        return threeWay<uint64_t>(unsignedValue(left), unsignedValue(right));
+
+    if (lc == CLASS_SIGNED && rc == CLASS_SIGNED)
+        return threeWay<int64_t>(left.asInt64(), right.asInt64());
+
+    //
+    // Mixed signed/unsigned.  A negative signed value is always the smaller one,
+    // otherwise both fit in an unsigned comparison.
+    //
+    if (lc == CLASS_SIGNED) {
+        int64_t l(left.asInt64());
+        if (l < 0)
+            return -1;
+        return threeWay<uint64_t>((uint64_t) l, unsignedValue(right));
+    }
+
+    int64_t r(right.asInt64());
+    if (r < 0)
+        return 1;
+    return threeWay<uint64_t>(unsignedValue(left), (uint64_t) r);
+}
+
@@ -0,0 +1,52 @@
+#ifndef _qe_qmf_variant_h
+#define _qe_qmf_variant_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QVariant>
+#include <qpid/types/Variant.h>
+
+//
+// Helpers for working with the typed values carried in QMF data.  These let
+// the table models sort and display numbers as numbers instead of going
+// through a string conversion for every comparison.
+//
+namespace QmfVariant {
+
+    //
+    // True if the value is a boolean, integer or floating point type.
+    //
+    bool isNumeric(const qpid::types::Variant&);
+
+    //
+    // Convert a QMF value into the closest QVariant type.  Maps, lists and
+    // UUIDs are converted to their string representation.
+    //
+    QVariant toQVariant(const qpid::types::Variant&);
+
+    //
+    // Three-way comparison of two QMF values.  Void values sort first,
+    // followed by numeric values (compared by magnitude), followed by
+    // everything else (compared as strings).
+    //
+    int compare(const qpid::types::Variant&, const qpid::types::Variant&);
+}
+
+#endif
+
@@ -17,7 +17,36 @@ SOURCES += main.cpp\
     object-model.cpp \
     qmf-thread.cpp \
     opendialog.cpp \
-    event-detail-model.cpp
+    event-detail-model.cpp \
+    class-table-model.cpp \
+    qmf-variant.cpp \
+    typed-sort-proxy.cpp \
+    search-index.cpp \
+    series-store.cpp \
+    sparkline-delegate.cpp \
+    rate-engine.cpp \
+    json-writer.cpp \
+    headless-monitor.cpp \
+    session-opener.cpp \
+    method-response-model.cpp \
+    explorer-stats.cpp \
+    stats-dialog.cpp \
+    trace.cpp \
+    snapshot-writer.cpp \
+    snapshot-file.cpp \
+    json-reader.cpp \
+    snapshot-diff.cpp \
+    diff-model.cpp \
+    event-journal.cpp \
+    event-history-model.cpp \
+    event-aggregate-model.cpp \
+    event-rates.cpp \
+    event-rate-widget.cpp \
+    agent-liveness.cpp \
+    agent-filter.cpp \
+    reference-index.cpp \
+    topology-layout.cpp \
+    topology-view.cpp
 
 HEADERS  += \
     agent-detail-model.h \
@@ -27,7 +56,36 @@ HEADERS  += \
     object-model.h \
     qmf-thread.h \
     opendialog.h \
-    event-detail-model.h
+    event-detail-model.h \
+    class-table-model.h \
+    qmf-variant.h \
+    typed-sort-proxy.h \
+    search-index.h \
+    series-store.h \
+    sparkline-delegate.h \
+    rate-engine.h \
+    json-writer.h \
+    headless-monitor.h \
+    session-opener.h \
+    method-response-model.h \
+    explorer-stats.h \
+    stats-dialog.h \
+    trace.h \
+    snapshot-writer.h \
+    snapshot-file.h \
+    json-reader.h \
+    snapshot-diff.h \
+    diff-model.h \
+    event-journal.h \
+    event-history-model.h \
+    event-aggregate-model.h \
+    event-rates.h \
+    event-rate-widget.h \
+    agent-liveness.h \
+    agent-filter.h \
+    reference-index.h \
+    topology-layout.h \
+    topology-view.h
 
 FORMS    += \
     explorer_main.ui \
@@ -0,0 +1,226 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rate-engine.h"
+#include "object-model.h"
+#include <qmf/DataAddr.h>
+#include <QDateTime>
+#include <QSettings>
+#include <QStringList>
+#include <cmath>
+
+namespace {
+    //
+    // Counter statistics of the broker management schema that do not follow the
+    // "...Total..." naming convention.
+    //
+    const char* DEFAULT_COUNTERS[] = {
+        "msgTxnEnqueues", "msgTxnDequeues", "byteTxnEnqueues", "byteTxnDequeues",
+        "msgPersistEnqueues", "msgPersistDequeues", "bytePersistEnqueues", "bytePersistDequeues",
+        "msgFtdEnqueues", "msgFtdDequeues", "byteFtdEnqueues", "byteFtdDequeues",
+        "discardsTtl", "discardsRing", "discardsLvq", "discardsOverflow", "discardsSubscriber",
+        "discardsPurge", "acquires", "releases", "reroutes",
+        "msgReceives", "msgDrops", "msgRoutes", "byteReceives", "byteDrops", "byteRoutes",
+        "framesFromClient", "framesToClient", "bytesFromClient", "bytesToClient",
+        "msgsFromClient", "msgsToClient", "delivered",
+        0
+    };
+
+    const double WINDOW_1M = 60.0;
+    const double WINDOW_5M = 300.0;
+
+    bool counterValue(const qpid::types::Variant& value, quint64& result)
+    {
+        switch (value.getType()) {
+        case qpid::types::VAR_UINT8:
+        case qpid::types::VAR_UINT16:
+        case qpid::types::VAR_UINT32:
+        case qpid::types::VAR_UINT64:
+            result = value.asUint64();
+            return true;
+        case qpid::types::VAR_INT8:
+        case qpid::types::VAR_INT16:
+        case qpid::types::VAR_INT32:
+        case qpid::types::VAR_INT64:
+            if (value.asInt64() < 0)
+                return false;
+            result = (quint64) value.asInt64();
+            return true;
+        default:
+            break;
+        }
+        return false;
+    }
+}
+
+
+RateEngine::RateEngine(QObject* parent) : QObject(parent), count(0)
+{
+    QStringList defaults;
+    for (int idx = 0; DEFAULT_COUNTERS[idx]; idx++)
+        defaults << DEFAULT_COUNTERS[idx];
+
+    QSettings settings;
+    QStringList names(settings.value("Rates/counters", defaults).toStringList());
+    for (QStringList::const_iterator iter = names.begin(); iter != names.end(); iter++)
+        counters.insert(iter->toStdString());
+}
+
+
+bool RateEngine::isCounter(const std::string& property) const
+{
+    return property.find("Total") != std::string::npos || counters.find(property) != counters.end();
+}
+
+
+void RateEngine::sample(Counter& counter, qint64 now, quint64 value, quint32 epoch)
+{
+    //
+    // The first sample, or the first after the agent restarted, only sets the baseline.
+    //
+    if (counter.samples == 0 || epoch != counter.epoch) {
+        counter.lastTime = now;
+        counter.lastValue = value;
+        counter.epoch = epoch;
+        counter.samples = 1;
+        counter.perSecond = counter.priorPerSecond = 0.0;
+        counter.average1m = counter.average5m = 0.0;
+        return;
+    }
+
+    double dt((now - counter.lastTime) / 1000.0);
+    if (dt <= 0.0)
+        return;
+
+    //
+    // A counter that went backwards was reset; everything it holds now was
+    // counted since the reset.
+    //
+    quint64 delta(value >= counter.lastValue ? value - counter.lastValue : value);
+
+    counter.priorPerSecond = counter.perSecond;
+    counter.perSecond = (double) delta / dt;
+
+    //
+    // Time-weighted moving averages so irregular poll intervals are handled.  The
+    // second sample seeds the averages directly.
+    //
+    if (counter.samples == 1) {
+        counter.average1m = counter.perSecond;
+        counter.average5m = counter.perSecond;
+    } else {
+        counter.average1m += (1.0 - std::exp(-dt / WINDOW_1M)) * (counter.perSecond - counter.average1m);
+        counter.average5m += (1.0 - std::exp(-dt / WINDOW_5M)) * (counter.perSecond - counter.average5m);
+    }
+
+    counter.lastTime = now;
+    counter.lastValue = value;
+    counter.samples++;
+}
+
+
+void RateEngine::addObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+
+    qint64 now(QDateTime::currentMSecsSinceEpoch());
+    quint32 epoch(object.getAddr().getAgentEpoch());
+    CounterMap* objectCounters(0);
+
+    const qpid::types::Variant::Map& props(object.getProperties());
+    for (qpid::types::Variant::Map::const_iterator iter = props.begin(); iter != props.end(); iter++) {
+        quint64 value;
+        if (!isCounter(iter->first) || !counterValue(iter->second, value))
+            continue;
+
+        if (!objectCounters)
+            objectCounters = &objects[ObjectModel::objectKey(object)];
+
+        CounterMap::iterator citer(objectCounters->find(iter->first));
+        if (citer == objectCounters->end()) {
+            Counter counter;
+            counter.samples = 0;
+            citer = objectCounters->insert(CounterMap::value_type(iter->first, counter)).first;
+            count++;
+        }
+        sample(citer->second, now, value, epoch);
+    }
+}
+
+
+size_t RateEngine::memoryUsage() const
+{
+    size_t total(count * (sizeof(Counter) + 48));
+    for (ObjectMap::const_iterator iter = objects.begin(); iter != objects.end(); iter++)
+        total += 48 + iter->first.capacity();
+    return total;
+}
+
+
+void RateEngine::delObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+    ObjectMap::iterator iter(objects.find(ObjectModel::objectKey(object)));
+    if (iter == objects.end())
+        return;
+    count -= iter->second.size();
+    objects.erase(iter);
+}
+
+
+void RateEngine::clear()
+{
+    objects.clear();
+    count = 0;
+}
+
+
+const RateEngine::Counter* RateEngine::find(const std::string& key, const std::string& property) const
+{
+    ObjectMap::const_iterator oiter(objects.find(key));
+    if (oiter == objects.end())
+        return 0;
+    CounterMap::const_iterator citer(oiter->second.find(property));
+    if (citer == oiter->second.end())
+        return 0;
+    return &citer->second;
+}
+
+
+bool RateEngine::rate(const std::string& key, const std::string& property, Rate& result) const
+{
+    const Counter* counter(find(key, property));
+    if (!counter || counter->samples < 2)
+        return false;
+
+    result.perSecond = counter->perSecond;
+    result.average1m = counter->average1m;
+    result.average5m = counter->average5m;
+    return true;
+}
+
+
+bool RateEngine::rateChanged(const std::string& key, const std::string& property) const
+{
+    const Counter* counter(find(key, property));
+    return counter && counter->perSecond != counter->priorPerSecond;
+}
+
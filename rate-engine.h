@@ -0,0 +1,81 @@
+#ifndef _qe_rate_engine_h
+#define _qe_rate_engine_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QObject>
+#include <qmf/Data.h>
+#include <string>
+#include <map>
+#include <set>
+
+//
+// Derived metrics for monotonically increasing counter properties.  Every
+// sample of an object updates the per-second rate of each of its counters and
+// two exponentially weighted moving averages of that rate.  A counter that
+// goes backwards is treated as having been reset, and a change in the agent
+// epoch of the object's address (a broker restart) starts the counter over.
+//
+class RateEngine : public QObject {
+    Q_OBJECT
+
+public:
+    struct Rate {
+        double perSecond;
+        double average1m;
+        double average5m;
+    };
+
+    RateEngine(QObject* parent = 0);
+
+    bool isCounter(const std::string& property) const;
+    bool rate(const std::string& key, const std::string& property, Rate&) const;
+    bool rateChanged(const std::string& key, const std::string& property) const;
+    size_t counterCount() const { return count; }
+    size_t memoryUsage() const;
+
+public slots:
+    void addObject(const qmf::Data&);
+    void delObject(const qmf::Data&);
+    void clear();
+
+private:
+    struct Counter {
+        qint64 lastTime;
+        quint64 lastValue;
+        quint32 epoch;
+        int samples;
+        double perSecond;
+        double priorPerSecond;
+        double average1m;
+        double average5m;
+    };
+    typedef std::map<std::string, Counter> CounterMap;
+    typedef std::map<std::string, CounterMap> ObjectMap;
+
+    std::set<std::string> counters;
+    ObjectMap objects;
+    size_t count;
+
+    void sample(Counter&, qint64, quint64, quint32);
+    const Counter* find(const std::string&, const std::string&) const;
+};
+
+#endif
+
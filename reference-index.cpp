@@ -0,0 +1,287 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "reference-index.h"
+#include "object-model.h"
+#include "trace.h"
+#include <qmf/DataAddr.h>
+#include <algorithm>
+
+namespace {
+    const std::string AGENT_NAME("_agent_name");
+    const std::string OBJECT_NAME("_object_name");
+
+    //
+    // The name of the object a reference points at, and its agent (the
+    // referring object's own agent when the reference leaves it out).
+    //
+    bool referenceTarget(const qpid::types::Variant& value, const std::string& defaultAgent,
+                         std::string& agent, std::string& name)
+    {
+        if (!ReferenceIndex::isReference(value))
+            return false;
+        const qpid::types::Variant::Map& map(value.asMap());
+        name = map.find(OBJECT_NAME)->second.asString();
+        qpid::types::Variant::Map::const_iterator iter(map.find(AGENT_NAME));
+        agent = iter == map.end() ? defaultAgent : iter->second.asString();
+        return true;
+    }
+}
+
+
+ReferenceIndex::ReferenceIndex(QObject* parent) : QObject(parent)
+{
+    // Intentionally Left Blank
+}
+
+
+std::string ReferenceIndex::addrKey(const std::string& agent, const std::string& name)
+{
+    //
+    // Agent names contain colons, so a separator that cannot appear keeps the
+    // keys of one agent together and apart from every other agent's.
+    //
+    std::string key(agent);
+    key += '\0';
+    key += name;
+    return key;
+}
+
+
+bool ReferenceIndex::isReference(const qpid::types::Variant& value)
+{
+    if (value.getType() != qpid::types::VAR_MAP)
+        return false;
+    const qpid::types::Variant::Map& map(value.asMap());
+    qpid::types::Variant::Map::const_iterator iter(map.find(OBJECT_NAME));
+    return iter != map.end() && iter->second.getType() == qpid::types::VAR_STRING;
+}
+
+
+void ReferenceIndex::addObject(const qmf::Data& object)
+{
+    QE_TRACE_SCOPE("ReferenceIndex::addObject");
+    if (!object.hasAddr())
+        return;
+    const qmf::DataAddr& addr(object.getAddr());
+    const std::string& agent(addr.getAgentName());
+
+    //
+    // Collect the references, including those inside list properties.
+    //
+    std::vector<Edge> outbound;
+    std::string targetAgent;
+    std::string targetName;
+    const qpid::types::Variant::Map& properties(object.getProperties());
+    for (qpid::types::Variant::Map::const_iterator iter = properties.begin(); iter != properties.end(); iter++) {
+        if (referenceTarget(iter->second, agent, targetAgent, targetName))
+            outbound.push_back(Edge(iter->first, addrKey(targetAgent, targetName)));
+        else if (iter->second.getType() == qpid::types::VAR_LIST) {
+            const qpid::types::Variant::List& list(iter->second.asList());
+            for (qpid::types::Variant::List::const_iterator item = list.begin(); item != list.end(); item++)
+                if (referenceTarget(*item, agent, targetAgent, targetName))
+                    outbound.push_back(Edge(iter->first, addrKey(targetAgent, targetName)));
+        }
+    }
+    std::sort(outbound.begin(), outbound.end());
+
+    NodeMap::iterator node(nodes.insert(std::make_pair(addrKey(agent, addr.getName()), Node())).first);
+    bool known(!node->second.objectKey.empty());
+
+    //
+    // References rarely change once an object exists, so the usual update is a
+    // comparison and nothing more.
+    //
+    if (known && outbound == node->second.outbound)
+        return;
+
+    std::vector<std::string> changed(1, node->first);
+    if (!known) {
+        //
+        // Objects that referred to this one before it arrived now resolve.
+        //
+        node->second.objectKey = ObjectModel::objectKey(object);
+        node->second.name = addr.getName();
+        referrers(node, changed);
+    }
+    setOutbound(node, outbound, changed);
+    notify(changed);
+}
+
+
+void ReferenceIndex::setOutbound(NodeMap::iterator node, std::vector<Edge>& outbound,
+                                 std::vector<std::string>& changed)
+{
+    const std::string& source(node->first);
+    std::vector<Edge>& current(node->second.outbound);
+
+    //
+    // Both lists are sorted; walk them together to find what went and what came.
+    //
+    std::vector<Edge>::const_iterator oiter(current.begin());
+    std::vector<Edge>::const_iterator niter(outbound.begin());
+    while (oiter != current.end() || niter != outbound.end()) {
+        if (niter == outbound.end() || (oiter != current.end() && *oiter < *niter)) {
+            NodeMap::iterator target(nodes.find(oiter->second));
+            if (target != nodes.end()) {
+                target->second.inbound.erase(Edge(source, oiter->first));
+                changed.push_back(target->first);
+                release(target);
+            }
+            oiter++;
+        } else if (oiter == current.end() || *niter < *oiter) {
+            NodeMap::iterator target(nodes.insert(std::make_pair(niter->second, Node())).first);
+            target->second.inbound.insert(Edge(source, niter->first));
+            changed.push_back(target->first);
+            if (target->second.name.empty())
+                target->second.name = niter->second.substr(niter->second.find('\0') + 1);
+            niter++;
+        } else {
+            oiter++;
+            niter++;
+        }
+    }
+    current.swap(outbound);
+}
+
+
+void ReferenceIndex::release(NodeMap::iterator node)
+{
+    //
+    // A target that was never seen itself is only kept while something refers
+    // to it.
+    //
+    if (node->second.objectKey.empty() && node->second.inbound.empty() && node->second.outbound.empty())
+        nodes.erase(node);
+}
+
+
+void ReferenceIndex::delObject(const qmf::Data& object)
+{
+    QE_TRACE_SCOPE("ReferenceIndex::delObject");
+    if (!object.hasAddr())
+        return;
+    const qmf::DataAddr& addr(object.getAddr());
+    NodeMap::iterator node(nodes.find(addrKey(addr.getAgentName(), addr.getName())));
+    if (node == nodes.end() || node->second.objectKey.empty())
+        return;
+
+    //
+    // The object's own references are dropped, while references to it stay,
+    // unresolved, until their holders go too or the object returns.
+    //
+    std::vector<std::string> changed;
+    referrers(node, changed);
+    std::vector<Edge> none;
+    setOutbound(node, none, changed);
+    node->second.objectKey.clear();
+    release(node);
+    notify(changed);
+}
+
+
+void ReferenceIndex::referrers(NodeMap::const_iterator node, std::vector<std::string>& changed) const
+{
+    for (std::set<Edge>::const_iterator iter = node->second.inbound.begin(); iter != node->second.inbound.end(); iter++)
+        changed.push_back(iter->first);
+}
+
+
+void ReferenceIndex::notify(std::vector<std::string>& addrs)
+{
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+    for (std::vector<std::string>::const_iterator iter = addrs.begin(); iter != addrs.end(); iter++) {
+        NodeMap::const_iterator node(nodes.find(*iter));
+        if (node != nodes.end() && !node->second.objectKey.empty())
+            emit referencesChanged(QString(node->second.objectKey.c_str()));
+    }
+}
+
+
+void ReferenceIndex::outbound(const std::string& addr, ReferenceList& references) const
+{
+    NodeMap::const_iterator node(nodes.find(addr));
+    if (node == nodes.end())
+        return;
+    for (std::vector<Edge>::const_iterator iter = node->second.outbound.begin(); iter != node->second.outbound.end(); iter++) {
+        Reference reference;
+        reference.property = iter->first;
+        NodeMap::const_iterator target(nodes.find(iter->second));
+        if (target != nodes.end()) {
+            reference.objectKey = target->second.objectKey;
+            reference.objectName = target->second.name;
+        }
+        references.push_back(reference);
+    }
+}
+
+
+void ReferenceIndex::inbound(const std::string& addr, ReferenceList& references) const
+{
+    NodeMap::const_iterator node(nodes.find(addr));
+    if (node == nodes.end())
+        return;
+    for (std::set<Edge>::const_iterator iter = node->second.inbound.begin(); iter != node->second.inbound.end(); iter++) {
+        Reference reference;
+        reference.property = iter->second;
+        NodeMap::const_iterator source(nodes.find(iter->first));
+        if (source != nodes.end()) {
+            reference.objectKey = source->second.objectKey;
+            reference.objectName = source->second.name;
+        }
+        references.push_back(reference);
+    }
+}
+
+
+void ReferenceIndex::edges(EdgeList& result) const
+{
+    for (NodeMap::const_iterator node = nodes.begin(); node != nodes.end(); node++) {
+        if (node->second.objectKey.empty())
+            continue;
+        for (std::vector<Edge>::const_iterator iter = node->second.outbound.begin();
+             iter != node->second.outbound.end(); iter++) {
+            NodeMap::const_iterator target(nodes.find(iter->second));
+            if (target != nodes.end() && !target->second.objectKey.empty())
+                result.push_back(std::make_pair(node->second.objectKey, target->second.objectKey));
+        }
+    }
+}
+
+
+size_t ReferenceIndex::memoryUsage() const
+{
+    //
+    // An estimate: each node with its map entry and strings, and each edge as it
+    // is held at both ends.
+    //
+    size_t total(0);
+    for (NodeMap::const_iterator iter = nodes.begin(); iter != nodes.end(); iter++)
+        total += sizeof(Node) + 64 + iter->first.capacity() + iter->second.objectKey.capacity() +
+            iter->second.name.capacity() + 120 * (iter->second.outbound.size() + iter->second.inbound.size());
+    return total;
+}
+
+
+void ReferenceIndex::clear()
+{
+    nodes.clear();
+}
+
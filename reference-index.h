@@ -0,0 +1,114 @@
+#ifndef _qe_reference_index_h
+#define _qe_reference_index_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QObject>
+#include <qmf/Data.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+//
+// The references between objects, in both directions.  QMF objects point at
+// each other through reference properties (a binding at its queue and exchange,
+// a session at its connection); this index records every such edge as objects
+// arrive, so both "what does this object point at" and "what points at this
+// object" are a lookup.  A reference may name an object not seen yet; it is
+// resolved as soon as that object arrives, and unresolved again when it leaves
+// the object store.
+//
+class ReferenceIndex : public QObject {
+    Q_OBJECT
+
+public:
+    ReferenceIndex(QObject* parent = 0);
+
+    struct Reference {
+        std::string property;
+
+        //
+        // The object at the other end: its object key when it is known, and its
+        // name as given in the reference.
+        //
+        std::string objectKey;
+        std::string objectName;
+    };
+    typedef std::vector<Reference> ReferenceList;
+
+    //
+    // Index key for an object address.
+    //
+    static std::string addrKey(const std::string& agent, const std::string& name);
+
+    //
+    // True if the value is a reference to another object.
+    //
+    static bool isReference(const qpid::types::Variant&);
+
+    void outbound(const std::string& addr, ReferenceList&) const;
+    void inbound(const std::string& addr, ReferenceList&) const;
+
+    //
+    // Every edge, as (source, target) pairs of object keys, both ends known.
+    //
+    typedef std::vector<std::pair<std::string, std::string> > EdgeList;
+    void edges(EdgeList&) const;
+
+    size_t size() const { return nodes.size(); }
+    size_t memoryUsage() const;
+
+public slots:
+    void addObject(const qmf::Data&);
+    void delObject(const qmf::Data&);
+    void clear();
+
+signals:
+    //
+    // The references held by, or pointing at, an object have changed.
+    //
+    void referencesChanged(const QString& objectKey);
+
+private:
+    typedef std::pair<std::string, std::string> Edge;
+
+    struct Node {
+        std::string objectKey;
+        std::string name;
+
+        //
+        // (property, target address) for references held by this object and
+        // (source address, property) for references to it.
+        //
+        std::vector<Edge> outbound;
+        std::set<Edge> inbound;
+    };
+    typedef std::map<std::string, Node> NodeMap;
+
+    NodeMap nodes;
+
+    void setOutbound(NodeMap::iterator, std::vector<Edge>&, std::vector<std::string>&);
+    void release(NodeMap::iterator);
+    void referrers(NodeMap::const_iterator, std::vector<std::string>&) const;
+    void notify(std::vector<std::string>&);
+};
+
+#endif
+
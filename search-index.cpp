@@ -0,0 +1,321 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "search-index.h"
+#include "object-model.h"
+#include <qmf/SchemaId.h>
+#include <qmf/DataAddr.h>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+
+namespace {
+    //
+    // Compaction is skipped for small indexes where the tombstones cost little.
+    //
+    const size_t COMPACT_THRESHOLD = 10000;
+
+    quint32 trigram(const std::string& text, size_t pos)
+    {
+        return ((quint32) (unsigned char) text[pos] << 16) |
+               ((quint32) (unsigned char) text[pos + 1] << 8) |
+               (quint32) (unsigned char) text[pos + 2];
+    }
+
+    bool isWordChar(char c)
+    {
+        return std::isalnum((unsigned char) c) || c == '_';
+    }
+}
+
+
+SearchIndex::SearchIndex(QObject* parent) : QObject(parent), deadCount(0)
+{
+    // Intentionally Left Blank
+}
+
+
+std::string SearchIndex::normalize(const std::string& text)
+{
+    std::string result(text);
+    for (std::string::iterator iter = result.begin(); iter != result.end(); iter++)
+        *iter = std::tolower((unsigned char) *iter);
+    return result;
+}
+
+
+quint32 SearchIndex::addEntry(HitType type, const std::string& text, const std::string& key, quint64 sequence)
+{
+    quint32 id((quint32) entries.size());
+    Entry entry;
+    entry.type = type;
+    entry.live = true;
+    entry.text = normalize(text);
+    entry.key = key;
+    entry.sequence = sequence;
+    entries.push_back(entry);
+    indexEntry(id);
+    return id;
+}
+
+
+void SearchIndex::indexEntry(quint32 id)
+{
+    const std::string& text(entries[id].text);
+
+    //
+    // Each distinct trigram and word of the entry is posted once.  Ids are
+    // assigned in increasing order so every posting list stays sorted.
+    //
+    if (text.size() >= 3) {
+        std::vector<quint32> grams;
+        grams.reserve(text.size() - 2);
+        for (size_t pos = 0; pos + 2 < text.size(); pos++)
+            grams.push_back(trigram(text, pos));
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        for (std::vector<quint32>::const_iterator iter = grams.begin(); iter != grams.end(); iter++)
+            trigrams[*iter].push_back(id);
+    }
+
+    std::vector<std::string> words;
+    size_t pos(0);
+    while (pos < text.size()) {
+        while (pos < text.size() && !isWordChar(text[pos]))
+            pos++;
+        size_t start(pos);
+        while (pos < text.size() && isWordChar(text[pos]))
+            pos++;
+        if (pos > start)
+            words.push_back(text.substr(start, pos - start));
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    for (std::vector<std::string>::const_iterator iter = words.begin(); iter != words.end(); iter++)
+        tokens[*iter].push_back(id);
+}
+
+
+void SearchIndex::addObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+
+    const qmf::DataAddr& addr(object.getAddr());
+    std::string key(ObjectModel::objectKey(object));
+
+    //
+    // The entry covers the object name and its string-valued properties.
+    // Numeric properties are left out; they are mostly statistics that change on
+    // every update and are not useful search terms.
+    //
+    std::string text(addr.getAgentName() + ":" + addr.getName());
+    const qpid::types::Variant::Map& props(object.getProperties());
+    for (qpid::types::Variant::Map::const_iterator iter = props.begin(); iter != props.end(); iter++)
+        if (iter->second.getType() == qpid::types::VAR_STRING) {
+            text += " ";
+            text += iter->first;
+            text += "=";
+            text += iter->second.asString();
+        }
+
+    ObjectMap::iterator existing(objects.find(key));
+    if (existing != objects.end()) {
+        Entry& old(entries[existing->second]);
+        if (old.text == normalize(text))
+            return;
+        old.live = false;
+        deadCount++;
+    }
+
+    objects[key] = addEntry(HIT_OBJECT, text, key, 0);
+
+    if (deadCount > COMPACT_THRESHOLD && deadCount * 2 > entries.size())
+        compact();
+}
+
+
+void SearchIndex::delObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+
+    ObjectMap::iterator existing(objects.find(ObjectModel::objectKey(object)));
+    if (existing == objects.end())
+        return;
+    entries[existing->second].live = false;
+    deadCount++;
+    objects.erase(existing);
+
+    if (deadCount > COMPACT_THRESHOLD && deadCount * 2 > entries.size())
+        compact();
+}
+
+
+void SearchIndex::addEvent(quint64 sequence, const QString& text)
+{
+    addEntry(HIT_EVENT, text.toStdString(), std::string(), sequence);
+}
+
+
+size_t SearchIndex::memoryUsage() const
+{
+    size_t total(entries.capacity() * sizeof(Entry));
+    for (std::vector<Entry>::const_iterator iter = entries.begin(); iter != entries.end(); iter++)
+        total += iter->text.capacity() + iter->key.capacity();
+    for (TrigramMap::const_iterator iter = trigrams.begin(); iter != trigrams.end(); iter++)
+        total += 32 + iter.value().capacity() * sizeof(quint32);
+    for (TokenMap::const_iterator iter = tokens.begin(); iter != tokens.end(); iter++)
+        total += 48 + iter->first.capacity() + iter->second.capacity() * sizeof(quint32);
+    for (ObjectMap::const_iterator iter = objects.begin(); iter != objects.end(); iter++)
+        total += 48 + iter->first.capacity();
+    return total;
+}
+
+
+void SearchIndex::clear()
+{
+    entries.clear();
+    trigrams.clear();
+    tokens.clear();
+    objects.clear();
+    deadCount = 0;
+}
+
+
+void SearchIndex::compact()
+{
+    std::vector<Entry> old;
+    old.swap(entries);
+    trigrams.clear();
+    tokens.clear();
+    objects.clear();
+    deadCount = 0;
+
+    entries.reserve(old.size() / 2);
+    for (std::vector<Entry>::const_iterator iter = old.begin(); iter != old.end(); iter++) {
+        if (!iter->live)
+            continue;
+        quint32 id((quint32) entries.size());
+        entries.push_back(*iter);
+        indexEntry(id);
+        if (iter->type == HIT_OBJECT)
+            objects[iter->key] = id;
+    }
+}
+
+
+void SearchIndex::substringQuery(const std::string& q, std::vector<quint32>& ids) const
+{
+    //
+    // Gather the posting list of every trigram in the query, smallest first, and
+    // intersect them.  Any trigram that has never been seen means no match.
+    //
+    std::vector<const Postings*> lists;
+    for (size_t pos = 0; pos + 2 < q.size(); pos++) {
+        TrigramMap::const_iterator iter(trigrams.find(trigram(q, pos)));
+        if (iter == trigrams.end())
+            return;
+        lists.push_back(&iter.value());
+    }
+
+    std::vector<const Postings*>::iterator smallest(lists.begin());
+    for (std::vector<const Postings*>::iterator iter = lists.begin(); iter != lists.end(); iter++)
+        if ((*iter)->size() < (*smallest)->size())
+            smallest = iter;
+
+    std::vector<quint32> candidates(**smallest);
+    for (std::vector<const Postings*>::const_iterator iter = lists.begin();
+         iter != lists.end() && !candidates.empty(); iter++) {
+        if (*iter == *smallest)
+            continue;
+        std::vector<quint32> merged;
+        std::set_intersection(candidates.begin(), candidates.end(), (*iter)->begin(), (*iter)->end(),
+                              std::back_inserter(merged));
+        candidates.swap(merged);
+    }
+
+    //
+    // The trigrams only guarantee the pieces are present; confirm the whole
+    // query appears in the text.
+    //
+    for (std::vector<quint32>::const_iterator iter = candidates.begin(); iter != candidates.end(); iter++)
+        if (entries[*iter].text.find(q) != std::string::npos)
+            ids.push_back(*iter);
+}
+
+
+void SearchIndex::prefixQuery(const std::string& q, std::vector<quint32>& ids) const
+{
+    //
+    // Tokens are walked in alphabetical order, not by age, so every matching id is
+    // collected before the caller keeps the newest.
+    //
+    for (TokenMap::const_iterator iter = tokens.lower_bound(q);
+         iter != tokens.end() && iter->first.compare(0, q.size(), q) == 0; iter++)
+        ids.insert(ids.end(), iter->second.begin(), iter->second.end());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+
+bool SearchIndex::matches(const QString& query, const QString& text)
+{
+    std::string q(normalize(query.trimmed().toStdString()));
+    if (q.empty())
+        return false;
+    std::string t(normalize(text.toStdString()));
+    if (q.size() >= 3)
+        return t.find(q) != std::string::npos;
+
+    //
+    // Short queries match the start of a word.
+    //
+    for (size_t pos = t.find(q); pos != std::string::npos; pos = t.find(q, pos + 1))
+        if (pos == 0 || !isWordChar(t[pos - 1]))
+            return true;
+    return false;
+}
+
+
+void SearchIndex::query(const QString& text, HitList& hits, size_t limit) const
+{
+    std::string q(normalize(text.trimmed().toStdString()));
+    if (q.empty())
+        return;
+
+    std::vector<quint32> ids;
+    if (q.size() < 3)
+        prefixQuery(q, ids);
+    else
+        substringQuery(q, ids);
+
+    for (std::vector<quint32>::const_reverse_iterator iter = ids.rbegin();
+         iter != ids.rend() && (limit == 0 || hits.size() < limit); iter++) {
+        const Entry& entry(entries[*iter]);
+        if (!entry.live)
+            continue;
+        Hit hit;
+        hit.type = entry.type;
+        hit.key = entry.key;
+        hit.sequence = entry.sequence;
+        hits.push_back(hit);
+    }
+}
+
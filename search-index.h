@@ -0,0 +1,103 @@
+#ifndef _qe_search_index_h
+#define _qe_search_index_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <qmf/Data.h>
+#include <string>
+#include <vector>
+#include <map>
+
+//
+// Inverted index over object names, string-valued object properties and event
+// text.  Queries of three or more characters are answered as substring
+// matches through a trigram index; shorter queries are answered as prefix
+// matches against the word dictionary.  The index is updated incrementally as
+// objects and events arrive; superseded object entries are tombstoned and
+// reclaimed by an occasional compaction.
+//
+class SearchIndex : public QObject {
+    Q_OBJECT
+
+public:
+    typedef enum { HIT_OBJECT, HIT_EVENT } HitType;
+
+    struct Hit {
+        HitType type;
+        std::string key;
+        quint64 sequence;
+    };
+    typedef std::vector<Hit> HitList;
+
+    SearchIndex(QObject* parent = 0);
+
+    //
+    // Hits are returned newest first, so a limited query keeps the latest events.
+    // A limit of zero returns every hit.
+    //
+    void query(const QString&, HitList&, size_t limit = 0) const;
+
+    //
+    // True if a query would match the text, by the same rules as query().  Used to
+    // extend a search to events that arrive after it ran.
+    //
+    static bool matches(const QString& query, const QString& text);
+
+    size_t size() const { return entries.size() - deadCount; }
+    size_t memoryUsage() const;
+
+public slots:
+    void addObject(const qmf::Data&);
+    void delObject(const qmf::Data&);
+    void addEvent(quint64, const QString&);
+    void clear();
+
+private:
+    struct Entry {
+        HitType type;
+        bool live;
+        std::string text;
+        std::string key;
+        quint64 sequence;
+    };
+
+    typedef std::vector<quint32> Postings;
+    typedef QHash<quint32, Postings> TrigramMap;
+    typedef std::map<std::string, Postings> TokenMap;
+    typedef std::map<std::string, quint32> ObjectMap;
+
+    std::vector<Entry> entries;
+    TrigramMap trigrams;
+    TokenMap tokens;
+    ObjectMap objects;
+    size_t deadCount;
+
+    quint32 addEntry(HitType, const std::string&, const std::string&, quint64);
+    void indexEntry(quint32);
+    void compact();
+    void substringQuery(const std::string&, std::vector<quint32>&) const;
+    void prefixQuery(const std::string&, std::vector<quint32>&) const;
+    static std::string normalize(const std::string&);
+};
+
+#endif
+
@@ -0,0 +1,270 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "series-store.h"
+#include "object-model.h"
+#include <QDateTime>
+#include <QSettings>
+#include <limits>
+
+namespace {
+    const char* DEFAULT_PROPERTIES[] = {
+        "msgDepth", "byteDepth", "consumerCount", "bindingCount",
+        "msgTotalEnqueues", "msgTotalDequeues", "byteTotalEnqueues", "byteTotalDequeues",
+        "msgFtdDepth", "msgFtdEnqueues", "msgFtdDequeues",
+        0
+    };
+
+    //
+    // Megabytes of history to keep at most; zero is no limit.
+    //
+    const int DEFAULT_MAX_MEMORY = 0;
+}
+
+//
+// One property's history.  The oldest sample is held in full; every later
+// sample is the difference from the one before it.  When the ring is full the
+// oldest delta is folded into the base sample and its slot reused.
+//
+class SeriesStore::Series {
+public:
+    Series() : head(0), samples(0) {}
+
+    void append(qint64 time, qint64 value)
+    {
+        if (samples > 0) {
+            qint64 dt(time - lastTime);
+            qint64 dv(value - lastValue);
+
+            //
+            // A step that does not fit the compact encoding (or time going
+            // backwards) starts the series over.
+            //
+            if (dt < 0 || dt > (qint64) std::numeric_limits<quint32>::max() ||
+                dv < (qint64) std::numeric_limits<qint32>::min() ||
+                dv > (qint64) std::numeric_limits<qint32>::max())
+                samples = 0;
+            else {
+                if (samples == CAPACITY) {
+                    baseTime += timeDeltas[head];
+                    baseValue += valueDeltas[head];
+                    head = (head + 1) % DELTAS;
+                    samples--;
+                }
+                int slot((head + samples - 1) % DELTAS);
+                timeDeltas[slot] = (quint32) dt;
+                valueDeltas[slot] = (qint32) dv;
+                samples++;
+                lastTime = time;
+                lastValue = value;
+                return;
+            }
+        }
+
+        head = 0;
+        samples = 1;
+        baseTime = lastTime = time;
+        baseValue = lastValue = value;
+    }
+
+    void decode(SampleList& list) const
+    {
+        list.clear();
+        if (samples == 0)
+            return;
+        list.reserve(samples);
+
+        Sample sample;
+        sample.time = baseTime;
+        sample.value = baseValue;
+        list.push_back(sample);
+        for (int idx = 0; idx < samples - 1; idx++) {
+            int slot((head + idx) % DELTAS);
+            sample.time += timeDeltas[slot];
+            sample.value += valueDeltas[slot];
+            list.push_back(sample);
+        }
+    }
+
+    bool lastStep(qint64& dt, qint64& dv) const
+    {
+        if (samples < 2)
+            return false;
+        int slot((head + samples - 2) % DELTAS);
+        dt = timeDeltas[slot];
+        dv = valueDeltas[slot];
+        return true;
+    }
+
+private:
+    enum { DELTAS = CAPACITY - 1 };
+
+    qint64 baseTime;
+    qint64 baseValue;
+    qint64 lastTime;
+    qint64 lastValue;
+    int head;
+    int samples;
+    quint32 timeDeltas[DELTAS];
+    qint32 valueDeltas[DELTAS];
+};
+
+
+SeriesStore::SeriesStore(QObject* parent) : QObject(parent), count(0), dropped(0)
+{
+    //
+    // The limit is set in memory and turned into series by what one costs.
+    //
+    QSettings settings;
+    size_t megabytes(settings.value("History/maxMemoryMB", DEFAULT_MAX_MEMORY).toUInt());
+    maxSeries = megabytes > 0 ? megabytes * 1024 * 1024 / sizeof(Series) : std::numeric_limits<size_t>::max();
+
+    QStringList properties(trackedProperties());
+    for (QStringList::const_iterator iter = properties.begin(); iter != properties.end(); iter++)
+        tracked.insert(iter->toStdString());
+}
+
+
+QStringList SeriesStore::trackedProperties()
+{
+    QStringList defaults;
+    for (int idx = 0; DEFAULT_PROPERTIES[idx]; idx++)
+        defaults << DEFAULT_PROPERTIES[idx];
+
+    QSettings settings;
+    return settings.value("History/properties", defaults).toStringList();
+}
+
+
+bool SeriesStore::isTracked(const std::string& property) const
+{
+    return tracked.find(property) != tracked.end();
+}
+
+
+void SeriesStore::addObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+
+    qint64 now(QDateTime::currentMSecsSinceEpoch());
+    std::string key(ObjectModel::objectKey(object));
+    PropertyMap* series(0);
+
+    const qpid::types::Variant::Map& props(object.getProperties());
+    for (qpid::types::Variant::Map::const_iterator iter = props.begin(); iter != props.end(); iter++) {
+        if (!isTracked(iter->first))
+            continue;
+
+        qint64 value;
+        switch (iter->second.getType()) {
+        case qpid::types::VAR_UINT8:
+        case qpid::types::VAR_UINT16:
+        case qpid::types::VAR_UINT32:
+        case qpid::types::VAR_UINT64:
+            value = (qint64) iter->second.asUint64();
+            break;
+        case qpid::types::VAR_INT8:
+        case qpid::types::VAR_INT16:
+        case qpid::types::VAR_INT32:
+        case qpid::types::VAR_INT64:
+            value = iter->second.asInt64();
+            break;
+        default:
+            continue;
+        }
+
+        if (!series)
+            series = &objects[key];
+        SeriesPtr& ptr((*series)[iter->first]);
+        if (!ptr) {
+            if (count >= maxSeries) {
+                series->erase(iter->first);
+                if (dropped++ == 0)
+                    emit limitReached(QString("History memory limit reached: %1 series tracked, new ones are not")
+                                      .arg(count));
+                continue;
+            }
+            ptr.reset(new Series());
+            count++;
+        }
+        ptr->append(now, value);
+    }
+}
+
+
+void SeriesStore::delObject(const qmf::Data& object)
+{
+    if (!object.hasAddr())
+        return;
+    ObjectMap::iterator iter(objects.find(ObjectModel::objectKey(object)));
+    if (iter == objects.end())
+        return;
+    count -= iter->second.size();
+    objects.erase(iter);
+}
+
+
+void SeriesStore::clear()
+{
+    objects.clear();
+    count = 0;
+    dropped = 0;
+}
+
+
+const SeriesStore::Series* SeriesStore::find(const std::string& key, const std::string& property) const
+{
+    ObjectMap::const_iterator oiter(objects.find(key));
+    if (oiter == objects.end())
+        return 0;
+    PropertyMap::const_iterator piter(oiter->second.find(property));
+    if (piter == oiter->second.end())
+        return 0;
+    return piter->second.get();
+}
+
+
+bool SeriesStore::history(const std::string& key, const std::string& property, SampleList& list) const
+{
+    const Series* series(find(key, property));
+    if (!series)
+        return false;
+    series->decode(list);
+    return true;
+}
+
+
+bool SeriesStore::rate(const std::string& key, const std::string& property, double& perSecond) const
+{
+    const Series* series(find(key, property));
+    qint64 dt;
+    qint64 dv;
+    if (!series || !series->lastStep(dt, dv) || dt == 0)
+        return false;
+    perSecond = (double) dv * 1000.0 / (double) dt;
+    return true;
+}
+
+
+size_t SeriesStore::memoryUsage() const
+{
+    return count * sizeof(Series);
+}
+
@@ -0,0 +1,95 @@
+#ifndef _qe_series_store_h
+#define _qe_series_store_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QObject>
+#include <QStringList>
+#include <qmf/Data.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <boost/shared_ptr.hpp>
+
+//
+// Bounded history of selected numeric object properties.  Each tracked
+// property of each object has a fixed-size ring of samples stored as deltas
+// from the previous sample, so a full series costs about 2KB regardless of
+// how long the explorer runs.  By default every object is tracked; a memory
+// limit can be set, and reaching it is reported.
+//
+class SeriesStore : public QObject {
+    Q_OBJECT
+
+public:
+    enum { CAPACITY = 240 };
+
+    struct Sample {
+        qint64 time;
+        qint64 value;
+    };
+    typedef std::vector<Sample> SampleList;
+
+    SeriesStore(QObject* parent = 0);
+
+    //
+    // The properties given a history, from the settings.
+    //
+    static QStringList trackedProperties();
+
+    bool isTracked(const std::string& property) const;
+    bool history(const std::string& key, const std::string& property, SampleList&) const;
+    bool rate(const std::string& key, const std::string& property, double&) const;
+    size_t seriesCount() const { return count; }
+
+    //
+    // Samples not recorded because the memory limit was reached.
+    //
+    size_t droppedCount() const { return dropped; }
+    size_t memoryUsage() const;
+
+public slots:
+    void addObject(const qmf::Data&);
+    void delObject(const qmf::Data&);
+    void clear();
+
+signals:
+    //
+    // The memory limit was reached; properties not yet tracked are left out.
+    //
+    void limitReached(const QString& message);
+
+private:
+    class Series;
+    typedef boost::shared_ptr<Series> SeriesPtr;
+    typedef std::map<std::string, SeriesPtr> PropertyMap;
+    typedef std::map<std::string, PropertyMap> ObjectMap;
+
+    std::set<std::string> tracked;
+    ObjectMap objects;
+    size_t count;
+    size_t maxSeries;
+    size_t dropped;
+
+    const Series* find(const std::string&, const std::string&) const;
+};
+
+#endif
+
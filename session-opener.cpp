@@ -0,0 +1,235 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "session-opener.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <qpid/messaging/exceptions.h>
+#include <sstream>
+
+namespace {
+    //
+    // Opens to one broker still in flight, counting those abandoned after a
+    // timeout.  An unreachable host keeps each in connect for as long as TCP takes
+    // to give up, so retries are refused until one of them finishes.
+    //
+    const size_t MAX_PENDING_OPENS = 2;
+}
+
+QMutex SessionOpener::registryLock;
+SessionOpener::OpenerSet SessionOpener::registry;
+
+bool SessionOpener::Result::wait(unsigned long msec)
+{
+    QMutexLocker locker(&lock);
+    if (!done)
+        cond.wait(&lock, msec);
+    return done;
+}
+
+
+void SessionOpener::Result::abandon()
+{
+    bool wasOpened;
+    {
+        QMutexLocker locker(&lock);
+        abandoned = true;
+        wasOpened = done && opened;
+    }
+
+    //
+    // If the open already completed, close it off the caller's thread as well.
+    //
+    if (wasOpened)
+        SessionOpener::close(conn, sess);
+}
+
+
+bool SessionOpener::Result::succeeded() const
+{
+    QMutexLocker locker(&lock);
+    return done && opened;
+}
+
+
+std::string SessionOpener::Result::error() const
+{
+    QMutexLocker locker(&lock);
+    return message;
+}
+
+
+qpid::messaging::Connection SessionOpener::Result::connection() const
+{
+    QMutexLocker locker(&lock);
+    return conn;
+}
+
+
+qmf::ConsoleSession SessionOpener::Result::session() const
+{
+    QMutexLocker locker(&lock);
+    return sess;
+}
+
+
+SessionOpener::SessionOpener(const ResultPtr& r, const std::string& u, const std::string& co, const std::string& qo,
+                             const std::string& af) :
+    closing(false), result(r), url(u), connOptions(co), qmfOptions(qo), agentFilter(af)
+{
+    // Intentionally Left Blank
+}
+
+
+SessionOpener::SessionOpener(const qpid::messaging::Connection& c, const qmf::ConsoleSession& s) :
+    closing(true), conn(c), sess(s)
+{
+    // Intentionally Left Blank
+}
+
+
+SessionOpener::ResultPtr SessionOpener::open(const std::string& url, const std::string& connOptions,
+                                             const std::string& qmfOptions, const std::string& agentFilter)
+{
+    ResultPtr result(new Result());
+    if (!mayOpen(url)) {
+        std::stringstream line;
+        line << "earlier attempts to reach " << url << " are still pending";
+        result->done = true;
+        result->message = line.str();
+        return result;
+    }
+    (new SessionOpener(result, url, connOptions, qmfOptions, agentFilter))->launch();
+    return result;
+}
+
+
+bool SessionOpener::mayOpen(const std::string& url)
+{
+    QMutexLocker locker(&registryLock);
+    size_t pending(0);
+    for (OpenerSet::const_iterator iter = registry.begin(); iter != registry.end(); iter++)
+        if (!(*iter)->closing && (*iter)->url == url)
+            pending++;
+    return pending < MAX_PENDING_OPENS;
+}
+
+
+void SessionOpener::close(const qpid::messaging::Connection& conn, const qmf::ConsoleSession& sess)
+{
+    (new SessionOpener(conn, sess))->launch();
+}
+
+
+void SessionOpener::launch()
+{
+    //
+    // The creating thread has no event loop of its own, so the deferred delete is
+    // handled by the application's main thread.
+    //
+    moveToThread(QCoreApplication::instance()->thread());
+    connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+    {
+        QMutexLocker locker(&registryLock);
+        registry.insert(this);
+    }
+    start();
+}
+
+
+void SessionOpener::waitAll(unsigned long msec)
+{
+    //
+    // Called on the main thread, so no helper in the registry can be deleted
+    // while this runs: the deferred delete needs the event loop.
+    //
+    OpenerSet openers;
+    {
+        QMutexLocker locker(&registryLock);
+        openers = registry;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (OpenerSet::const_iterator iter = openers.begin(); iter != openers.end(); iter++) {
+        qint64 left((qint64) msec - timer.elapsed());
+        (*iter)->wait(left > 0 ? (unsigned long) left : 0);
+    }
+}
+
+
+void SessionOpener::run()
+{
+    if (closing) {
+        try {
+            if (sess.isValid())
+                sess.close();
+        } catch (std::exception&) {}
+        try {
+            if (conn.isValid())
+                conn.close();
+        } catch (std::exception&) {}
+        QMutexLocker locker(&registryLock);
+        registry.erase(this);
+        return;
+    }
+
+    qpid::messaging::Connection openConn;
+    qmf::ConsoleSession openSess;
+    std::string error;
+    bool opened(false);
+
+    try {
+        openConn = qpid::messaging::Connection(url, connOptions);
+        openConn.open();
+        openSess = qmf::ConsoleSession(openConn, qmfOptions);
+        openSess.setAgentFilter(agentFilter);
+        openSess.open();
+        opened = true;
+    } catch (qpid::messaging::MessagingException& ex) {
+        error = ex.what();
+    } catch (std::exception& ex) {
+        error = ex.what();
+    }
+
+    bool abandoned;
+    {
+        QMutexLocker locker(&result->lock);
+        result->done = true;
+        result->opened = opened;
+        result->message = error;
+        result->conn = openConn;
+        result->sess = openSess;
+        abandoned = result->abandoned;
+        result->cond.wakeAll();
+    }
+
+    if (abandoned || !opened) {
+        try {
+            if (opened)
+                openSess.close();
+            if (openConn.isValid())
+                openConn.close();
+        } catch (std::exception&) {}
+    }
+
+    QMutexLocker locker(&registryLock);
+    registry.erase(this);
+}
+
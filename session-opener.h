@@ -0,0 +1,116 @@
+#ifndef _qe_session_opener_h
+#define _qe_session_opener_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <qpid/messaging/Connection.h>
+#include <qmf/ConsoleSession.h>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <set>
+
+//
+// Opens (or closes) a broker connection and its QMF session on a throw-away
+// thread so that the caller can give up at any moment.  Opening a connection to an
+// unreachable host blocks until the TCP connect fails; with the blocking calls moved
+// here the QMF thread keeps servicing cancel and disconnect requests in the meantime.
+//
+// An abandoned open is left to finish on its own, after which anything it managed to
+// open is closed again.  The helper thread deletes itself once done.  Live helpers
+// are kept in a registry so the number of opens to one broker still in flight can
+// be capped and the application can join them before it exits.
+//
+class SessionOpener : public QThread {
+    Q_OBJECT
+
+public:
+    class Result {
+    public:
+        Result() : done(false), abandoned(false), opened(false) {}
+
+        //
+        // Wait up to msec for the open to complete.  Returns true once it has.
+        //
+        bool wait(unsigned long msec);
+
+        //
+        // The caller is no longer interested.  Whatever gets opened is closed.
+        //
+        void abandon();
+
+        bool succeeded() const;
+        std::string error() const;
+        qpid::messaging::Connection connection() const;
+        qmf::ConsoleSession session() const;
+
+    private:
+        friend class SessionOpener;
+        mutable QMutex lock;
+        QWaitCondition cond;
+        bool done;
+        bool abandoned;
+        bool opened;
+        std::string message;
+        qpid::messaging::Connection conn;
+        qmf::ConsoleSession sess;
+    };
+    typedef boost::shared_ptr<Result> ResultPtr;
+
+    //
+    // The agent filter is set before the session opens, so agents it excludes are
+    // never reported.
+    //
+    static ResultPtr open(const std::string& url, const std::string& connOptions, const std::string& qmfOptions,
+                          const std::string& agentFilter);
+    static void close(const qpid::messaging::Connection&, const qmf::ConsoleSession&);
+
+    //
+    // Wait up to msec in all for the helper threads still running.  Any still
+    // blocked after that are abandoned to the process exit.
+    //
+    static void waitAll(unsigned long msec);
+
+protected:
+    void run();
+
+private:
+    SessionOpener(const ResultPtr&, const std::string&, const std::string&, const std::string&, const std::string&);
+    SessionOpener(const qpid::messaging::Connection&, const qmf::ConsoleSession&);
+    void launch();
+    static bool mayOpen(const std::string&);
+
+    typedef std::set<SessionOpener*> OpenerSet;
+    static QMutex registryLock;
+    static OpenerSet registry;
+
+    bool closing;
+    ResultPtr result;
+    std::string url;
+    std::string connOptions;
+    std::string qmfOptions;
+    std::string agentFilter;
+    qpid::messaging::Connection conn;
+    qmf::ConsoleSession sess;
+};
+
+#endif
+
@@ -0,0 +1,229 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "snapshot-diff.h"
+#include "json-writer.h"
+#include "trace.h"
+#include <QElapsedTimer>
+#include <sstream>
+#include <boost/shared_ptr.hpp>
+
+using qpid::types::Variant;
+
+namespace {
+    //
+    // How often (in objects) progress and cancellation are checked.
+    //
+    const size_t PROGRESS_STEP = 10000;
+
+    //
+    // One side of the comparison, read in key order.
+    //
+    class DiffInput {
+    public:
+        virtual ~DiffInput() {}
+        virtual bool next() = 0;
+        virtual void properties(Variant::Map&) = 0;
+        virtual void rawProperties(std::string&) = 0;
+        virtual int percent() const = 0;
+        const std::string& key() const { return current; }
+
+    protected:
+        std::string current;
+    };
+
+    class FileInput : public DiffInput {
+    public:
+        FileInput(const SnapshotFilePtr& f) : file(f), offset(f->firstObject()), record(0) {}
+
+        bool next() { return file->nextKey(offset, current, record); }
+        void properties(Variant::Map& map) { file->properties(record, map); }
+        void rawProperties(std::string& text) { file->rawProperties(record, text); }
+        int percent() const { return file->size() > 0 ? (int) (offset * 100 / file->size()) : 100; }
+
+    private:
+        SnapshotFilePtr file;
+        qint64 offset;
+        qint64 record;
+    };
+
+    class LiveInput : public DiffInput {
+    public:
+        LiveInput(const ObjectModel::BrokerObjectList& l) : list(l), position(0) {}
+
+        bool next()
+        {
+            if (position >= list.size())
+                return false;
+            current = ObjectModel::objectKey(list[position++].second);
+            return true;
+        }
+        void properties(Variant::Map& map) { map = list[position - 1].second.getProperties(); }
+        void rawProperties(std::string& text)
+        {
+            //
+            // Written exactly as SnapshotWriter would, so equal values give equal text.
+            //
+            std::ostringstream out;
+            JsonWriter json(out);
+            json.value(list[position - 1].second.getProperties());
+            text = out.str();
+        }
+        int percent() const { return list.empty() ? 100 : (int) (position * 100 / list.size()); }
+
+    private:
+        const ObjectModel::BrokerObjectList& list;
+        size_t position;
+    };
+
+    std::string jsonText(const Variant& value)
+    {
+        std::ostringstream out;
+        JsonWriter json(out);
+        json.value(value);
+        return out.str();
+    }
+
+    void addChange(SnapshotDiff::ChangeList& changes, SnapshotDiff::ChangeType type, const std::string& key,
+                   const std::string& property = std::string(), const std::string& before = std::string(),
+                   const std::string& after = std::string())
+    {
+        changes.push_back(SnapshotDiff::Change());
+        SnapshotDiff::Change& change(changes.back());
+        change.type = type;
+        change.key = key;
+        change.property = property;
+        change.before = before;
+        change.after = after;
+    }
+
+    void compareProperties(SnapshotDiff::ChangeList& changes, const std::string& key,
+                           const Variant::Map& before, const Variant::Map& after)
+    {
+        //
+        // Both maps are ordered by name; merge them the same way as the objects.
+        //
+        Variant::Map::const_iterator biter(before.begin());
+        Variant::Map::const_iterator aiter(after.begin());
+        while (biter != before.end() || aiter != after.end()) {
+            if (aiter == after.end() || (biter != before.end() && biter->first < aiter->first)) {
+                addChange(changes, SnapshotDiff::CHANGED, key, biter->first, jsonText(biter->second));
+                biter++;
+            } else if (biter == before.end() || aiter->first < biter->first) {
+                addChange(changes, SnapshotDiff::CHANGED, key, aiter->first, std::string(), jsonText(aiter->second));
+                aiter++;
+            } else {
+                std::string btext(jsonText(biter->second));
+                std::string atext(jsonText(aiter->second));
+                if (btext != atext)
+                    addChange(changes, SnapshotDiff::CHANGED, key, biter->first, btext, atext);
+                biter++;
+                aiter++;
+            }
+        }
+    }
+}
+
+
+SnapshotDiff::SnapshotDiff(const SnapshotFilePtr& before, const SnapshotFilePtr& after, QObject* parent) :
+    QThread(parent), beforeFile(before), afterFile(after), cancelled(0)
+{
+    // Intentionally Left Blank
+}
+
+
+SnapshotDiff::SnapshotDiff(const SnapshotFilePtr& before, const ObjectModel* live, QObject* parent) :
+    QThread(parent), beforeFile(before), cancelled(0)
+{
+    if (live)
+        live->allObjects(liveObjects);
+}
+
+
+void SnapshotDiff::takeChanges(ChangeList& list)
+{
+    list.swap(changes);
+    changes.clear();
+}
+
+
+void SnapshotDiff::run()
+{
+    QE_TRACE_SCOPE("SnapshotDiff::run");
+    QElapsedTimer timer;
+    timer.start();
+
+    boost::shared_ptr<DiffInput> before(new FileInput(beforeFile));
+    boost::shared_ptr<DiffInput> after(afterFile ? (DiffInput*) new FileInput(afterFile) :
+                                   (DiffInput*) new LiveInput(liveObjects));
+
+    size_t added(0);
+    size_t removed(0);
+    size_t changed(0);
+    size_t steps(0);
+    std::string btext;
+    std::string atext;
+
+    bool bvalid(before->next());
+    bool avalid(after->next());
+    while (bvalid || avalid) {
+        if (++steps % PROGRESS_STEP == 0) {
+            if (cancelled) {
+                changes.clear();
+                emit done(false, "Comparison cancelled");
+                return;
+            }
+            emit progress(qMin(before->percent(), after->percent()));
+        }
+
+        int order(!avalid ? -1 : !bvalid ? 1 : before->key().compare(after->key()));
+        if (order < 0) {
+            addChange(changes, REMOVED, before->key());
+            removed++;
+            bvalid = before->next();
+        } else if (order > 0) {
+            addChange(changes, ADDED, after->key());
+            added++;
+            avalid = after->next();
+        } else {
+            //
+            // Most objects are unchanged; equal text settles that without parsing.
+            //
+            before->rawProperties(btext);
+            after->rawProperties(atext);
+            if (btext != atext) {
+                Variant::Map bprops;
+                Variant::Map aprops;
+                before->properties(bprops);
+                after->properties(aprops);
+                size_t count(changes.size());
+                compareProperties(changes, before->key(), bprops, aprops);
+                if (changes.size() > count)
+                    changed++;
+            }
+            bvalid = before->next();
+            avalid = after->next();
+        }
+    }
+
+    emit progress(100);
+    emit done(true, QString("%1 added, %2 removed, %3 changed (%4 s)")
+              .arg(added).arg(removed).arg(changed).arg(timer.elapsed() / 1000.0, 0, 'f', 1));
+}
+
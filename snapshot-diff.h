@@ -0,0 +1,88 @@
+#ifndef _qe_snapshot_diff_h
+#define _qe_snapshot_diff_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QThread>
+#include <QString>
+#include <QAtomicInt>
+#include "snapshot-file.h"
+#include "object-model.h"
+#include <string>
+#include <vector>
+
+//
+// Compares two object states on a background thread: two snapshot files, or a
+// snapshot file and the objects currently in the tree.
+//
+// Both sides are in object-key order, so the comparison is a single merge-join
+// over the keys.  An object on both sides is compared first by the JSON text of
+// its properties and only parsed property by property when that differs.
+//
+class SnapshotDiff : public QThread {
+    Q_OBJECT
+
+public:
+    typedef enum { ADDED, REMOVED, CHANGED } ChangeType;
+
+    //
+    // One row of the result.  A changed object has one change per differing
+    // property; values are shown as JSON and are empty where absent.
+    //
+    struct Change {
+        ChangeType type;
+        std::string key;
+        std::string property;
+        std::string before;
+        std::string after;
+    };
+    typedef std::vector<Change> ChangeList;
+
+    SnapshotDiff(const SnapshotFilePtr& before, const SnapshotFilePtr& after, QObject* parent = 0);
+
+    //
+    // The live objects are taken from the model on the calling thread, as for
+    // SnapshotWriter.
+    //
+    SnapshotDiff(const SnapshotFilePtr& before, const ObjectModel* live, QObject* parent = 0);
+
+    void cancel() { cancelled = 1; }
+
+    //
+    // Hand over the result once done() has been emitted.
+    //
+    void takeChanges(ChangeList&);
+
+signals:
+    void progress(int percent);
+    void done(bool succeeded, const QString& message);
+
+protected:
+    void run();
+
+private:
+    SnapshotFilePtr beforeFile;
+    SnapshotFilePtr afterFile;
+    ObjectModel::BrokerObjectList liveObjects;
+    ChangeList changes;
+    QAtomicInt cancelled;
+};
+
+#endif
+
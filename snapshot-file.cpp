@@ -0,0 +1,302 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "snapshot-file.h"
+#include "json-reader.h"
+#include "trace.h"
+#include <qmf/Schema.h>
+#include <qmf/DataAddr.h>
+#include <algorithm>
+#include <cstring>
+
+using qpid::types::Variant;
+
+namespace {
+    //
+    // Sorts after every key that starts with a given prefix; the byte never
+    // occurs in UTF-8 text.
+    //
+    const char PREFIX_END = '\xff';
+
+    std::string stringField(const Variant::Map& map, const char* name)
+    {
+        Variant::Map::const_iterator iter(map.find(name));
+        if (iter == map.end() || iter->second.getType() != qpid::types::VAR_STRING)
+            return std::string();
+        return iter->second.asString();
+    }
+
+    qint64 intField(const Variant::Map& map, const char* name)
+    {
+        Variant::Map::const_iterator iter(map.find(name));
+        if (iter == map.end() || (iter->second.getType() != qpid::types::VAR_INT64 &&
+                                  iter->second.getType() != qpid::types::VAR_UINT64))
+            return 0;
+        return iter->second.asInt64();
+    }
+}
+
+
+SnapshotFile::SnapshotFile() : base(0), length(0), objectsBegin(0), snapshotTime(0), objects(0)
+{
+    // Intentionally Left Blank
+}
+
+
+SnapshotFile::~SnapshotFile()
+{
+    if (base)
+        file.unmap((uchar*) base);
+}
+
+
+bool SnapshotFile::open(const QString& fileName, QString& error)
+{
+    QE_TRACE_SCOPE("SnapshotFile::open");
+    name = fileName;
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Cannot open " + fileName + ": " + file.errorString();
+        return false;
+    }
+
+    length = file.size();
+    if (length > 0)
+        base = (const char*) file.map(0, length);
+    if (!base) {
+        error = "Cannot map " + fileName + (length > 0 ? ": " + file.errorString() : QString(": file is empty"));
+        return false;
+    }
+
+    Variant::Map header;
+    qint64 next;
+    if (!record(0, header, next) || stringField(header, "type") != "snapshot") {
+        error = fileName + " is not a snapshot file";
+        return false;
+    }
+    if (intField(header, "version") != 1) {
+        error = fileName + " has an unsupported snapshot version";
+        return false;
+    }
+    snapshotTime = intField(header, "time");
+    objects = intField(header, "objects");
+
+    //
+    // Agent records follow the header; there are few enough to read them all.
+    //
+    qint64 offset(next);
+    while (offset < length) {
+        Variant::Map map;
+        if (!record(offset, map, next) || stringField(map, "type") != "agent")
+            break;
+        AgentRecord agent;
+        agent.broker = stringField(map, "broker");
+        agent.name = stringField(map, "name");
+        agent.vendor = stringField(map, "vendor");
+        agent.product = stringField(map, "product");
+        agent.instance = stringField(map, "instance");
+        Variant::Map::const_iterator attrs(map.find("attributes"));
+        if (attrs != map.end() && attrs->second.getType() == qpid::types::VAR_MAP)
+            agent.attributes = attrs->second.asMap();
+        agentRecords.push_back(agent);
+        offset = next;
+    }
+    objectsBegin = offset;
+    return true;
+}
+
+
+qint64 SnapshotFile::lineEnd(qint64 offset) const
+{
+    const char* found((const char*) std::memchr(base + offset, '\n', length - offset));
+    return found ? found - base : length;
+}
+
+
+qint64 SnapshotFile::lineStart(qint64 offset) const
+{
+    //
+    // The first record beginning at or after offset.
+    //
+    if (offset <= 0 || base[offset - 1] == '\n')
+        return offset;
+    qint64 end(lineEnd(offset));
+    return end < length ? end + 1 : length;
+}
+
+
+bool SnapshotFile::record(qint64 offset, Variant::Map& map, qint64& next) const
+{
+    qint64 end(lineEnd(offset));
+    next = end < length ? end + 1 : length;
+
+    Variant value;
+    if (!JsonReader::parse(base + offset, base + end, value) || value.getType() != qpid::types::VAR_MAP)
+        return false;
+    map.swap(value.asMap());
+    return true;
+}
+
+
+std::string SnapshotFile::sortKey(qint64 offset, qint64& next) const
+{
+    //
+    // A schema record sorts just before the objects of its class.
+    //
+    qint64 end(lineEnd(offset));
+    next = end < length ? end + 1 : length;
+
+    std::string type;
+    std::string key;
+    JsonReader::findString(base + offset, base + end, "type", type);
+    if (type == "schema") {
+        std::string package;
+        std::string cls;
+        JsonReader::findString(base + offset, base + end, "package", package);
+        JsonReader::findString(base + offset, base + end, "class", cls);
+        return package + "/" + cls + "/";
+    }
+    JsonReader::findString(base + offset, base + end, "key", key);
+    return key;
+}
+
+
+qint64 SnapshotFile::lowerBound(const std::string& key) const
+{
+    //
+    // Bisect on byte offsets.  Every record starting before lo sorts before the
+    // key; every record starting at or after hi does not.
+    //
+    qint64 lo(objectsBegin);
+    qint64 hi(length);
+    while (lo < hi) {
+        qint64 mid(lo + (hi - lo) / 2);
+        qint64 line(lineStart(mid));
+        if (line >= hi) {
+            hi = mid;
+            continue;
+        }
+        qint64 next;
+        if (sortKey(line, next) < key)
+            lo = next;
+        else
+            hi = line;
+    }
+    return lo;
+}
+
+
+void SnapshotFile::classes(std::vector<ClassRange>& ranges) const
+{
+    QE_TRACE_SCOPE("SnapshotFile::classes");
+    qint64 offset(objectsBegin);
+    while (offset < length) {
+        qint64 next;
+        qint64 end(lineEnd(offset));
+        std::string type;
+        ClassRange range;
+
+        JsonReader::findString(base + offset, base + end, "type", type);
+        if (type != "schema" && type != "object") {
+            offset = end < length ? end + 1 : length;
+            continue;
+        }
+        JsonReader::findString(base + offset, base + end, "package", range.package);
+        JsonReader::findString(base + offset, base + end, "class", range.name);
+
+        sortKey(offset, next);
+        range.begin = type == "schema" ? next : offset;
+        range.end = lowerBound(range.package + "/" + range.name + "/" + PREFIX_END);
+        if (range.end < next)
+            range.end = next;
+        ranges.push_back(range);
+        offset = range.end;
+    }
+}
+
+
+bool SnapshotFile::nextKey(qint64& offset, std::string& key, qint64& record) const
+{
+    while (offset < length) {
+        qint64 end(lineEnd(offset));
+        bool found(JsonReader::findString(base + offset, base + end, "key", key));
+        record = offset;
+        offset = end < length ? end + 1 : length;
+        if (found && end > record)
+            return true;
+    }
+    return false;
+}
+
+
+bool SnapshotFile::properties(qint64 offset, Variant::Map& map) const
+{
+    Variant::Map record;
+    qint64 next;
+    if (offset < objectsBegin || offset >= length || !this->record(offset, record, next))
+        return false;
+    Variant::Map::const_iterator props(record.find("properties"));
+    if (props == record.end() || props->second.getType() != qpid::types::VAR_MAP)
+        return false;
+    map = props->second.asMap();
+    return true;
+}
+
+
+bool SnapshotFile::rawProperties(qint64 offset, std::string& text) const
+{
+    //
+    // Properties are the last field of an object record, so their text runs to
+    // the record's closing brace.
+    //
+    if (offset < objectsBegin || offset >= length)
+        return false;
+    qint64 end(lineEnd(offset));
+    static const std::string field("\"properties\":");
+    const char* found(std::search(base + offset, base + end, field.begin(), field.end()));
+    if (found == base + end || base[end - 1] != '}')
+        return false;
+    found += field.size();
+    text.assign(found, base + end - 1 - found);
+    return true;
+}
+
+
+qmf::Data SnapshotFile::object(qint64 offset) const
+{
+    QE_TRACE_SCOPE("SnapshotFile::object");
+    Variant::Map map;
+    qint64 next;
+    if (offset < objectsBegin || offset >= length || !record(offset, map, next) ||
+        stringField(map, "type") != "object")
+        return qmf::Data();
+
+    //
+    // The schema itself is not stored, only its identity, which is all the
+    // views use.
+    //
+    qmf::Schema schema(qmf::SCHEMA_TYPE_DATA, stringField(map, "package"), stringField(map, "class"));
+    qmf::Data data(schema);
+    data.setAddr(qmf::DataAddr(stringField(map, "name"), stringField(map, "agent"), 0));
+    Variant::Map::const_iterator props(map.find("properties"));
+    if (props != map.end() && props->second.getType() == qpid::types::VAR_MAP)
+        data.overwriteProperties(props->second.asMap());
+    return data;
+}
+
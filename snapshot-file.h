@@ -0,0 +1,116 @@
+#ifndef _qe_snapshot_file_h
+#define _qe_snapshot_file_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QFile>
+#include <QString>
+#include <qpid/types/Variant.h>
+#include <qmf/Data.h>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+//
+// Read-only view of a file written by SnapshotWriter.
+//
+// The file is memory-mapped and nothing is parsed up front beyond the header and
+// the agent records.  Because objects are stored in key order, the range of each
+// class is found by binary search over byte offsets, and individual objects are
+// parsed only when asked for, so opening a multi-gigabyte snapshot is quick.
+//
+class SnapshotFile {
+public:
+    SnapshotFile();
+    ~SnapshotFile();
+
+    bool open(const QString& fileName, QString& error);
+    const QString& fileName() const { return name; }
+    qint64 time() const { return snapshotTime; }
+    qint64 objectCount() const { return objects; }
+
+    struct AgentRecord {
+        std::string broker;
+        std::string name;
+        std::string vendor;
+        std::string product;
+        std::string instance;
+        qpid::types::Variant::Map attributes;
+    };
+    const std::vector<AgentRecord>& agents() const { return agentRecords; }
+
+    //
+    // The object records of one class occupy the byte range [begin, end).
+    //
+    struct ClassRange {
+        std::string package;
+        std::string name;
+        qint64 begin;
+        qint64 end;
+    };
+    void classes(std::vector<ClassRange>&) const;
+
+    //
+    // Read the key of the first object record at or after offset, setting record
+    // to where it starts and offset to the record after it.  Returns false at the
+    // end of the file.
+    //
+    bool nextKey(qint64& offset, std::string& key, qint64& record) const;
+    qint64 firstObject() const { return objectsBegin; }
+
+    //
+    // The properties of the object record at offset, parsed or as the JSON text
+    // they were written as.
+    //
+    bool properties(qint64 offset, qpid::types::Variant::Map&) const;
+    bool rawProperties(qint64 offset, std::string&) const;
+
+    //
+    // Parse the object record at offset.  Returns an invalid Data if the record
+    // is malformed.
+    //
+    qmf::Data object(qint64 offset) const;
+
+    //
+    // Offset of the first object record whose key is not less than the given key.
+    //
+    qint64 lowerBound(const std::string& key) const;
+
+    qint64 size() const { return length; }
+
+private:
+    QFile file;
+    QString name;
+    const char* base;
+    qint64 length;
+    qint64 objectsBegin;
+    qint64 snapshotTime;
+    qint64 objects;
+    std::vector<AgentRecord> agentRecords;
+
+    qint64 lineEnd(qint64) const;
+    qint64 lineStart(qint64) const;
+    bool record(qint64, qpid::types::Variant::Map&, qint64&) const;
+    std::string sortKey(qint64, qint64&) const;
+};
+
+typedef boost::shared_ptr<SnapshotFile> SnapshotFilePtr;
+
+#endif
+
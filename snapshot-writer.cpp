@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "snapshot-writer.h"
+#include "json-writer.h"
+#include "trace.h"
+#include <qmf/SchemaId.h>
+#include <qmf/DataAddr.h>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <fstream>
+#include <vector>
+
+namespace {
+    //
+    // Output buffer size, and how often (in objects) progress is reported.
+    //
+    const size_t BUFFER_SIZE = 1 << 20;
+    const size_t PROGRESS_STEP = 10000;
+}
+
+
+SnapshotWriter::SnapshotWriter(const QString& f, const AgentModel* agentModel, const ObjectModel* objectModel,
+                               QObject* parent) :
+    QThread(parent), fileName(f), cancelled(0)
+{
+    if (agentModel)
+        agentModel->allAgents(agents);
+    if (objectModel)
+        objectModel->allObjects(objects);
+}
+
+
+void SnapshotWriter::run()
+{
+    QE_TRACE_SCOPE("SnapshotWriter::run");
+    QElapsedTimer timer;
+    timer.start();
+
+    //
+    // The snapshot is written beside the chosen file and renamed over it once
+    // complete, so a cancelled or failed export leaves no partial file behind.
+    //
+    QString partName(fileName + ".part");
+    std::vector<char> buffer(BUFFER_SIZE);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+    out.open(partName.toLocal8Bit().constData(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out) {
+        emit done(false, "Cannot open " + partName);
+        return;
+    }
+
+    JsonWriter json(out);
+
+    json.beginObject();
+    json.field("type", "snapshot");
+    json.field("version", (qint64) 1);
+    json.field("time", (qint64) QDateTime::currentMSecsSinceEpoch());
+    json.field("agents", (qint64) agents.size());
+    json.field("objects", (qint64) objects.size());
+    json.endObject();
+    json.endLine();
+
+    for (AgentModel::BrokerAgentList::const_iterator iter = agents.begin(); iter != agents.end(); iter++) {
+        const qmf::Agent& agent(iter->second);
+        json.beginObject();
+        json.field("type", "agent");
+        json.field("broker", iter->first);
+        json.field("name", agent.getName());
+        json.field("vendor", agent.getVendor());
+        json.field("product", agent.getProduct());
+        json.field("instance", agent.getInstance());
+        json.field("attributes", agent.getAttributes());
+        json.endObject();
+        json.endLine();
+    }
+
+    std::string lastPackage;
+    std::string lastClass;
+    size_t written(0);
+
+    for (ObjectModel::BrokerObjectList::const_iterator iter = objects.begin(); iter != objects.end(); iter++) {
+        if (cancelled) {
+            out.close();
+            QFile::remove(partName);
+            emit done(false, "Export cancelled");
+            return;
+        }
+
+        const qmf::Data& object(iter->second);
+        const qmf::SchemaId& schemaId(object.getSchemaId());
+        const qmf::DataAddr& addr(object.getAddr());
+
+        if (schemaId.getPackageName() != lastPackage || schemaId.getName() != lastClass) {
+            lastPackage = schemaId.getPackageName();
+            lastClass = schemaId.getName();
+            json.beginObject();
+            json.field("type", "schema");
+            json.field("package", lastPackage);
+            json.field("class", lastClass);
+            json.endObject();
+            json.endLine();
+        }
+
+        json.beginObject();
+        json.field("type", "object");
+        json.field("key", ObjectModel::objectKey(object));
+        json.field("broker", iter->first);
+        json.field("package", lastPackage);
+        json.field("class", lastClass);
+        json.field("agent", addr.getAgentName());
+        json.field("name", addr.getName());
+        json.field("properties", object.getProperties());
+        json.endObject();
+        json.endLine();
+
+        if (++written % PROGRESS_STEP == 0)
+            emit progress((int) written, (int) objects.size());
+    }
+
+    out.close();
+    if (!out) {
+        QFile::remove(partName);
+        emit done(false, "Error writing " + fileName);
+        return;
+    }
+
+    QFile::remove(fileName);
+    if (!QFile::rename(partName, fileName)) {
+        QFile::remove(partName);
+        emit done(false, "Cannot replace " + fileName);
+        return;
+    }
+
+    emit progress((int) written, (int) objects.size());
+    emit done(true, QString("Exported %1 agents and %2 objects in %3 s")
+              .arg(agents.size()).arg(written).arg(timer.elapsed() / 1000.0, 0, 'f', 1));
+}
+
@@ -0,0 +1,69 @@
+#ifndef _qe_snapshot_writer_h
+#define _qe_snapshot_writer_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QThread>
+#include <QString>
+#include <QAtomicInt>
+#include "agent-model.h"
+#include "object-model.h"
+
+//
+// Writes the loaded broker state to a file on a background thread.
+//
+// The file is line-delimited JSON (NDJSON), one record per line:
+//
+//   {"type":"snapshot","version":1,"time":<ms since epoch>,"agents":N,"objects":N}
+//   {"type":"agent","broker":...,"name":...,"vendor":...,"product":...,"instance":...,"attributes":{...}}
+//   {"type":"schema","package":...,"class":...}
+//   {"type":"object","key":...,"broker":...,"package":...,"class":...,"agent":...,"name":...,
+//    "properties":{...}}
+//
+// Objects are written in key order (package/class/agent:name) and each class's
+// schema record precedes its first object, so a reader can stream the file once.
+//
+class SnapshotWriter : public QThread {
+    Q_OBJECT
+
+public:
+    //
+    // The lists are taken from the models on the calling thread; the QMF handles
+    // in them are shared, not copied, so this is quick even for large trees.
+    //
+    SnapshotWriter(const QString& fileName, const AgentModel*, const ObjectModel*, QObject* parent = 0);
+
+    void cancel() { cancelled = 1; }
+
+signals:
+    void progress(int written, int total);
+    void done(bool succeeded, const QString& message);
+
+protected:
+    void run();
+
+private:
+    QString fileName;
+    AgentModel::BrokerAgentList agents;
+    ObjectModel::BrokerObjectList objects;
+    QAtomicInt cancelled;
+};
+
+#endif
+
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "sparkline-delegate.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <QApplication>
+
+SparklineDelegate::SparklineDelegate(QObject* parent) : QStyledItemDelegate(parent)
+{
+    // Intentionally Left Blank
+}
+
+
+void SparklineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    QVariant data(index.data(Qt::UserRole));
+    if (data.type() != QVariant::List) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    //
+    // Draw the cell background (selection, alternating rows) without any text.
+    //
+    QStyleOptionViewItemV4 opt(option);
+    initStyleOption(&opt, index);
+    opt.text = QString();
+    const QWidget* widget(opt.widget);
+    QStyle* style(widget ? widget->style() : QApplication::style());
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+    QVariantList values(data.toList());
+    if (values.size() < 2)
+        return;
+
+    double low(values.at(0).toDouble());
+    double high(low);
+    for (QVariantList::const_iterator iter = values.begin(); iter != values.end(); iter++) {
+        double v(iter->toDouble());
+        if (v < low)
+            low = v;
+        if (v > high)
+            high = v;
+    }
+
+    QRectF area(QRectF(option.rect).adjusted(2, 2, -2, -2));
+    double span(high > low ? high - low : 1.0);
+    double step(area.width() / (values.size() - 1));
+
+    QPolygonF line;
+    for (int idx = 0; idx < values.size(); idx++) {
+        double y(area.bottom() - (values.at(idx).toDouble() - low) / span * area.height());
+        line << QPointF(area.left() + idx * step, y);
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(QPen(option.state & QStyle::State_Selected ?
+                         option.palette.highlightedText().color() : option.palette.text().color(), 1));
+    painter->drawPolyline(line);
+    painter->restore();
+}
+
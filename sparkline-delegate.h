@@ -0,0 +1,38 @@
+#ifndef _qe_sparkline_delegate_h
+#define _qe_sparkline_delegate_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QStyledItemDelegate>
+
+//
+// Draws the list of values a model returns under Qt::UserRole as a small
+// line chart filling the cell.  Cells without such a list are drawn normally.
+//
+class SparklineDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    SparklineDelegate(QObject* parent = 0);
+
+    void paint(QPainter*, const QStyleOptionViewItem&, const QModelIndex&) const;
+};
+
+#endif
+
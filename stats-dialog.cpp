@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "stats-dialog.h"
+#include "agent-model.h"
+#include "object-model.h"
+#include "event-detail-model.h"
+#include "search-index.h"
+#include "series-store.h"
+#include "rate-engine.h"
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QScrollBar>
+
+namespace {
+    const int REFRESH_INTERVAL = 1000;
+
+    QString formatBytes(size_t bytes)
+    {
+        if (bytes >= 1024 * 1024)
+            return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+        return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+    }
+}
+
+
+StatsDialog::StatsDialog(AgentModel* agents, ObjectModel* objects, EventDetailModel* events, SearchIndex* search,
+                         SeriesStore* series, RateEngine* rates, QWidget* parent) :
+    QDialog(parent), agentModel(agents), objectModel(objects), eventDetail(events), searchIndex(search),
+    seriesStore(series), rateEngine(rates), havePrevious(false)
+{
+    setWindowTitle("Explorer Statistics");
+    resize(560, 520);
+
+    tree = new QTreeWidget(this);
+    tree->setColumnCount(3);
+    tree->setHeaderLabels(QStringList() << "Counter" << "Value" << "Detail");
+    tree->setRootIsDecorated(false);
+    tree->header()->setStretchLastSection(true);
+
+    QVBoxLayout* layout(new QVBoxLayout(this));
+    layout->addWidget(tree);
+
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+
+void StatsDialog::showEvent(QShowEvent* event)
+{
+    refresh();
+    refreshTimer.start(REFRESH_INTERVAL);
+    ExplorerStats::instance().probeStalls(true);
+    QDialog::showEvent(event);
+}
+
+
+void StatsDialog::hideEvent(QHideEvent* event)
+{
+    refreshTimer.stop();
+    ExplorerStats::instance().probeStalls(false);
+    havePrevious = false;
+    QDialog::hideEvent(event);
+}
+
+
+QTreeWidgetItem* StatsDialog::section(const QString& title)
+{
+    QTreeWidgetItem* item(new QTreeWidgetItem(tree, QStringList() << title));
+    QFont font(item->font(0));
+    font.setBold(true);
+    item->setFont(0, font);
+    item->setFirstColumnSpanned(true);
+    return item;
+}
+
+
+void StatsDialog::addRow(QTreeWidgetItem* parent, const QString& name, const QString& value, const QString& detail)
+{
+    new QTreeWidgetItem(parent, QStringList() << name << value << detail);
+}
+
+
+void StatsDialog::refresh()
+{
+    ExplorerStats::Snapshot snap;
+    ExplorerStats::instance().snapshot(snap);
+    double seconds(havePrevious ? (snap.time - previous.time) / 1000.0 : 0.0);
+
+    int scroll(tree->verticalScrollBar()->value());
+    tree->clear();
+
+    QTreeWidgetItem* events(section("Console events"));
+    for (int type = 0; type < ExplorerStats::EVENT_TYPES; type++) {
+        const char* name(ExplorerStats::eventTypeName(type));
+        if (!name)
+            continue;
+        QString rate;
+        if (seconds > 0)
+            rate = QString::number((snap.events[type] - previous.events[type]) / seconds, 'f', 1) + "/s";
+        addRow(events, name, QString::number(snap.events[type]), rate);
+    }
+
+    QTreeWidgetItem* queues(section("Updates queued for the GUI thread"));
+    for (int channel = 0; channel < ExplorerStats::CHANNEL_COUNT; channel++)
+        addRow(queues, ExplorerStats::channelName(channel), QString::number(snap.queueDepth[channel]));
+
+    QTreeWidgetItem* timings(section("Latency and model time (microseconds)"));
+    for (int histogram = 0; histogram < ExplorerStats::HIST_COUNT; histogram++) {
+        const ExplorerStats::HistogramData& data(snap.histograms[histogram]);
+        addRow(timings, ExplorerStats::histogramName(histogram), QString::number(data.count),
+               QString("mean %1  p50 %2  p99 %3  max %4")
+               .arg(data.mean()).arg(data.percentile(0.5)).arg(data.percentile(0.99)).arg(data.max));
+    }
+
+    QTreeWidgetItem* memory(section("Memory (estimated)"));
+    addRow(memory, "agent tree", formatBytes(agentModel->memoryUsage()));
+    addRow(memory, "object tree", formatBytes(objectModel->memoryUsage()));
+    addRow(memory, "events", formatBytes(eventDetail->memoryUsage()), QString("%1 rows").arg(eventDetail->rowCount()));
+    addRow(memory, "search index", formatBytes(searchIndex->memoryUsage()), QString("%1 entries").arg(searchIndex->size()));
+    addRow(memory, "history", formatBytes(seriesStore->memoryUsage()),
+           QString("%1 series%2").arg(seriesStore->seriesCount())
+           .arg(seriesStore->droppedCount() > 0 ? ", limit reached" : ""));
+    addRow(memory, "rates", formatBytes(rateEngine->memoryUsage()), QString("%1 counters").arg(rateEngine->counterCount()));
+
+    tree->expandAll();
+    tree->resizeColumnToContents(0);
+    tree->resizeColumnToContents(1);
+    tree->verticalScrollBar()->setValue(scroll);
+
+    previous = snap;
+    havePrevious = true;
+}
+
@@ -0,0 +1,69 @@
+#ifndef _qe_stats_dialog_h
+#define _qe_stats_dialog_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QDialog>
+#include <QTimer>
+#include <QTreeWidget>
+#include "explorer-stats.h"
+
+class AgentModel;
+class ObjectModel;
+class EventDetailModel;
+class SearchIndex;
+class SeriesStore;
+class RateEngine;
+
+//
+// Shows the explorer's own counters, refreshed once a second while visible.
+//
+class StatsDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    StatsDialog(AgentModel*, ObjectModel*, EventDetailModel*, SearchIndex*, SeriesStore*, RateEngine*,
+                QWidget* parent = 0);
+
+protected:
+    void showEvent(QShowEvent*);
+    void hideEvent(QHideEvent*);
+
+private slots:
+    void refresh();
+
+private:
+    AgentModel* agentModel;
+    ObjectModel* objectModel;
+    EventDetailModel* eventDetail;
+    SearchIndex* searchIndex;
+    SeriesStore* seriesStore;
+    RateEngine* rateEngine;
+
+    QTreeWidget* tree;
+    QTimer refreshTimer;
+    ExplorerStats::Snapshot previous;
+    bool havePrevious;
+
+    QTreeWidgetItem* section(const QString&);
+    void addRow(QTreeWidgetItem*, const QString&, const QString&, const QString& detail = QString());
+};
+
+#endif
+
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "topology-layout.h"
+#include "trace.h"
+#include <algorithm>
+#include <climits>
+
+namespace {
+    //
+    // Sweeps over the columns, alternating direction.
+    //
+    const int SWEEPS = 4;
+
+    struct ByPosition {
+        const std::vector<double>& position;
+        ByPosition(const std::vector<double>& p) : position(p) {}
+        bool operator()(int a, int b) const { return position[a] < position[b]; }
+    };
+}
+
+
+TopologyLayout::TopologyLayout(const NodeList& n, const EdgeList& e, QObject* parent) :
+    QThread(parent), nodeList(n), edgeList(e), cancelled(0)
+{
+    // Intentionally Left Blank
+}
+
+
+void TopologyLayout::run()
+{
+    QE_TRACE_SCOPE("TopologyLayout::run");
+    size_t count(nodeList.size());
+
+    //
+    // Start from the previous order; new nodes follow, in the order given.
+    //
+    int columnCount(0);
+    for (NodeList::const_iterator iter = nodeList.begin(); iter != nodeList.end(); iter++)
+        columnCount = std::max(columnCount, iter->column + 1);
+
+    std::vector<double> position(count);
+    std::vector<std::vector<int> > columns(columnCount);
+    for (size_t node = 0; node < count; node++) {
+        position[node] = nodeList[node].previousRow < 0 ? INT_MAX : nodeList[node].previousRow;
+        columns[nodeList[node].column].push_back((int) node);
+    }
+
+    std::vector<std::vector<int> > neighbours(count);
+    for (EdgeList::const_iterator iter = edgeList.begin(); iter != edgeList.end(); iter++) {
+        neighbours[iter->first].push_back(iter->second);
+        neighbours[iter->second].push_back(iter->first);
+    }
+
+    //
+    // Positions are fractions of the column height, so a column of ten exchanges
+    // and one of ten thousand bindings can be compared.
+    //
+    for (int column = 0; column < columnCount; column++) {
+        std::vector<int>& order(columns[column]);
+        std::stable_sort(order.begin(), order.end(), ByPosition(position));
+        for (size_t row = 0; row < order.size(); row++)
+            position[order[row]] = (row + 0.5) / order.size();
+    }
+
+    std::vector<double> barycenter(count);
+    for (int sweep = 0; sweep < SWEEPS; sweep++) {
+        if (cancelled) {
+            emit done(false);
+            return;
+        }
+        bool forward(sweep % 2 == 0);
+        for (int step = 0; step < columnCount; step++) {
+            std::vector<int>& order(columns[forward ? step : columnCount - 1 - step]);
+            for (std::vector<int>::const_iterator node = order.begin(); node != order.end(); node++) {
+                const std::vector<int>& adjacent(neighbours[*node]);
+                if (adjacent.empty()) {
+                    barycenter[*node] = position[*node];
+                    continue;
+                }
+                double sum(0);
+                for (std::vector<int>::const_iterator other = adjacent.begin(); other != adjacent.end(); other++)
+                    sum += position[*other];
+                barycenter[*node] = sum / adjacent.size();
+            }
+            std::stable_sort(order.begin(), order.end(), ByPosition(barycenter));
+            for (size_t row = 0; row < order.size(); row++)
+                position[order[row]] = (row + 0.5) / order.size();
+        }
+    }
+
+    nodeRows.resize(count);
+    for (int column = 0; column < columnCount; column++)
+        for (size_t row = 0; row < columns[column].size(); row++)
+            nodeRows[columns[column][row]] = (int) row;
+
+    emit done(true);
+}
+
@@ -0,0 +1,83 @@
+#ifndef _qe_topology_layout_h
+#define _qe_topology_layout_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QThread>
+#include <QAtomicInt>
+#include <string>
+#include <vector>
+
+//
+// Places the nodes of the topology graph on a background thread.
+//
+// Each node belongs to a column (its object class) and the layout chooses the
+// row of every node within its column so that connected nodes sit near each
+// other: a few alternating sweeps order each column by the mean position of the
+// node's neighbours.  Nodes keep their previous row as the starting order, so a
+// graph that changed a little is laid out much as it was.  The cost is linear in
+// the edges and n log n in the nodes per sweep.
+//
+class TopologyLayout : public QThread {
+    Q_OBJECT
+
+public:
+    struct Node {
+        std::string key;
+        std::string label;
+        int column;
+
+        //
+        // The node's row in the previous layout, or -1 when it is new.
+        //
+        int previousRow;
+    };
+    typedef std::vector<Node> NodeList;
+
+    //
+    // Edges as pairs of indices into the node list.
+    //
+    typedef std::vector<std::pair<int, int> > EdgeList;
+
+    TopologyLayout(const NodeList&, const EdgeList&, QObject* parent = 0);
+
+    void cancel() { cancelled = 1; }
+
+    //
+    // Valid once done() has been emitted with true: the row of each node.
+    //
+    const NodeList& nodes() const { return nodeList; }
+    const EdgeList& edges() const { return edgeList; }
+    const std::vector<int>& rows() const { return nodeRows; }
+
+signals:
+    void done(bool completed);
+
+protected:
+    void run();
+
+private:
+    NodeList nodeList;
+    EdgeList edgeList;
+    std::vector<int> nodeRows;
+    QAtomicInt cancelled;
+};
+
+#endif
+
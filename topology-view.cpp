@@ -0,0 +1,428 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "topology-view.h"
+#include "topology-layout.h"
+#include "object-model.h"
+#include "reference-index.h"
+#include <qmf/DataAddr.h>
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int REFRESH_INTERVAL = 1000;
+    const std::string PACKAGE("org.apache.qpid.broker");
+
+    //
+    // The columns, left to right in the direction messages flow.
+    //
+    const int COLUMNS = 5;
+    const char* CLASSES[COLUMNS] = { "exchange", "binding", "queue", "subscription", "session" };
+    const char* TITLES[COLUMNS] = { "Exchanges", "Bindings", "Queues", "Subscriptions", "Sessions" };
+    const QColor COLORS[COLUMNS] = { QColor(230, 160, 60), QColor(170, 170, 170), QColor(80, 140, 220),
+                                     QColor(110, 190, 110), QColor(180, 120, 200) };
+
+    const qreal NODE_WIDTH = 160;
+    const qreal NODE_HEIGHT = 20;
+    const qreal COLUMN_SPACING = 320;
+    const qreal ROW_SPACING = 28;
+
+    //
+    // Below these scales a node drops its label, then its outline.
+    //
+    const qreal LOD_LABEL = 0.6;
+    const qreal LOD_OUTLINE = 0.25;
+
+    QPointF nodePosition(int column, int row, int rows)
+    {
+        return QPointF(column * COLUMN_SPACING, (row - rows / 2.0) * ROW_SPACING);
+    }
+
+    std::string nodeLabel(const qmf::Data& object, int column)
+    {
+        //
+        // getProperty throws for a property the object lacks, so the map is
+        // searched instead.
+        //
+        const qpid::types::Variant::Map& properties(object.getProperties());
+        qpid::types::Variant::Map::const_iterator iter;
+        if (column == 1) {
+            iter = properties.find("bindingKey");
+            if (iter != properties.end() && iter->second.getType() == qpid::types::VAR_STRING)
+                return iter->second.asString().empty() ? std::string("(no key)") : iter->second.asString();
+        }
+        iter = properties.find("name");
+        if (iter != properties.end() && iter->second.getType() == qpid::types::VAR_STRING)
+            return iter->second.asString();
+        return object.getAddr().getName();
+    }
+}
+
+
+//
+// One object of the graph.
+//
+class TopologyNode : public QGraphicsItem {
+public:
+    enum { Type = UserType + 1 };
+
+    TopologyNode(const std::string& k, int c) : key(k), column(c), row(-1), present(false)
+    {
+        setToolTip(QString(key.c_str()));
+    }
+
+    std::string key;
+    QString label;
+    int column;
+    int row;
+    bool present;
+
+    int type() const { return Type; }
+
+    QRectF boundingRect() const
+    {
+        return QRectF(-NODE_WIDTH / 2, -NODE_HEIGHT / 2, NODE_WIDTH, NODE_HEIGHT);
+    }
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*)
+    {
+        qreal lod(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()));
+        const QColor& color(COLORS[column]);
+        if (lod < LOD_OUTLINE) {
+            painter->fillRect(boundingRect(), color);
+            return;
+        }
+        painter->setPen(QPen(color.darker(150), 0));
+        painter->setBrush(color.lighter(140));
+        painter->drawRect(boundingRect());
+        if (lod < LOD_LABEL)
+            return;
+        painter->setPen(Qt::black);
+        QRectF text(boundingRect().adjusted(4, 0, -4, 0));
+        painter->drawText(text, Qt::AlignVCenter | Qt::AlignLeft,
+                          painter->fontMetrics().elidedText(label, Qt::ElideMiddle, (int) text.width()));
+    }
+};
+
+
+//
+// Every edge of the graph in one item.  Tens of thousands of line items would
+// each carry the cost of an item; here only the lines in the exposed area are
+// drawn, in a single call.
+//
+class TopologyEdges : public QGraphicsItem {
+public:
+    TopologyEdges()
+    {
+        setZValue(-1);
+        setFlag(ItemUsesExtendedStyleOption);
+    }
+
+    void setLines(QVector<QLineF>& replacement)
+    {
+        prepareGeometryChange();
+        lines.swap(replacement);
+        bounds = QRectF();
+        for (QVector<QLineF>::const_iterator iter = lines.begin(); iter != lines.end(); iter++)
+            bounds |= QRectF(iter->p1(), iter->p2()).normalized();
+        update();
+    }
+
+    QRectF boundingRect() const { return bounds; }
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
+    {
+        qreal lod(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()));
+        const QRectF& exposed(option->exposedRect);
+        QVector<QLineF> visible;
+        for (QVector<QLineF>::const_iterator iter = lines.begin(); iter != lines.end(); iter++)
+            if (exposed.intersects(QRectF(iter->p1(), iter->p2()).normalized().adjusted(0, -1, 0, 1)))
+                visible.append(*iter);
+        painter->setPen(QPen(QColor(120, 120, 120, lod < LOD_OUTLINE ? 60 : 160), 0));
+        painter->drawLines(visible);
+    }
+
+private:
+    QVector<QLineF> lines;
+    QRectF bounds;
+};
+
+
+//
+// The view: the wheel zooms about the pointer and a double-click on a node opens
+// its object.
+//
+class TopologyCanvas : public QGraphicsView {
+public:
+    TopologyCanvas(QGraphicsScene* scene, TopologyView* o) : QGraphicsView(scene, o), owner(o)
+    {
+        setDragMode(ScrollHandDrag);
+        setTransformationAnchor(AnchorUnderMouse);
+        setViewportUpdateMode(SmartViewportUpdate);
+        setOptimizationFlags(DontSavePainterState | DontAdjustForAntialiasing);
+        setCacheMode(CacheBackground);
+    }
+
+protected:
+    void wheelEvent(QWheelEvent* event)
+    {
+        qreal factor(std::pow(1.2, event->delta() / 120.0));
+        scale(factor, factor);
+    }
+
+    void mouseDoubleClickEvent(QMouseEvent* event)
+    {
+        QGraphicsItem* item(itemAt(event->pos()));
+        if (item && item->type() == TopologyNode::Type)
+            owner->activate(static_cast<TopologyNode*>(item));
+        else
+            QGraphicsView::mouseDoubleClickEvent(event);
+    }
+
+private:
+    TopologyView* owner;
+};
+
+
+TopologyView::TopologyView(ObjectModel* objects, ReferenceIndex* references, QWidget* parent) :
+    QDialog(parent), objectModel(objects), referenceIndex(references), layout(0), dirty(true), fitted(false)
+{
+    setWindowTitle("Broker Topology");
+    resize(900, 640);
+
+    canvas = new TopologyCanvas(&scene, this);
+    status = new QLabel(this);
+    QPushButton* fitButton(new QPushButton("Fit", this));
+
+    QHBoxLayout* controls(new QHBoxLayout());
+    controls->addWidget(status, 1);
+    controls->addWidget(fitButton);
+
+    QVBoxLayout* layoutBox(new QVBoxLayout(this));
+    layoutBox->addWidget(canvas);
+    layoutBox->addLayout(controls);
+
+    for (int column = 0; column < COLUMNS; column++) {
+        QGraphicsSimpleTextItem* title(scene.addSimpleText(TITLES[column]));
+        QFont font(title->font());
+        font.setBold(true);
+        title->setFont(font);
+        columnTitles.push_back(title);
+    }
+    edgeItem = new TopologyEdges();
+    scene.addItem(edgeItem);
+
+    //
+    // Any change to the objects or their references marks the graph out of date;
+    // the refresh timer lays it out again, at most once per interval.
+    //
+    connect(objectModel, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(changed()));
+    connect(objectModel, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(changed()));
+    connect(objectModel, SIGNAL(modelReset()), this, SLOT(changed()));
+    connect(referenceIndex, SIGNAL(referencesChanged(QString)), this, SLOT(changed()));
+    connect(fitButton, SIGNAL(clicked()), this, SLOT(fit()));
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+
+TopologyView::~TopologyView()
+{
+    if (layout) {
+        layout->cancel();
+        layout->wait();
+    }
+}
+
+
+void TopologyView::showEvent(QShowEvent* event)
+{
+    refresh();
+    refreshTimer.start(REFRESH_INTERVAL);
+    QDialog::showEvent(event);
+}
+
+
+void TopologyView::hideEvent(QHideEvent* event)
+{
+    refreshTimer.stop();
+    QDialog::hideEvent(event);
+}
+
+
+void TopologyView::changed()
+{
+    dirty = true;
+}
+
+
+void TopologyView::refresh()
+{
+    if (!dirty || layout)
+        return;
+    dirty = false;
+
+    //
+    // Gather the nodes and edges here, where the models live; the layout thread
+    // gets copies.  Nodes already shown start from the row they are in.
+    //
+    TopologyLayout::NodeList graphNodes;
+    std::map<std::string, int> indexOf;
+    for (int column = 0; column < COLUMNS; column++) {
+        std::vector<qmf::Data> objects;
+        objectModel->classObjects(PACKAGE, CLASSES[column], objects);
+        for (std::vector<qmf::Data>::const_iterator iter = objects.begin(); iter != objects.end(); iter++) {
+            TopologyLayout::Node node;
+            node.key = ObjectModel::objectKey(*iter);
+            node.label = nodeLabel(*iter, column);
+            node.column = column;
+            NodeMap::const_iterator shown(nodes.find(node.key));
+            node.previousRow = shown == nodes.end() ? -1 : shown->second->row;
+            indexOf[node.key] = (int) graphNodes.size();
+            graphNodes.push_back(node);
+        }
+    }
+
+    ReferenceIndex::EdgeList references;
+    referenceIndex->edges(references);
+    TopologyLayout::EdgeList graphEdges;
+    for (ReferenceIndex::EdgeList::const_iterator iter = references.begin(); iter != references.end(); iter++) {
+        std::map<std::string, int>::const_iterator source(indexOf.find(iter->first));
+        std::map<std::string, int>::const_iterator target(indexOf.find(iter->second));
+        if (source != indexOf.end() && target != indexOf.end())
+            graphEdges.push_back(std::make_pair(source->second, target->second));
+    }
+
+    layout = new TopologyLayout(graphNodes, graphEdges, this);
+    connect(layout, SIGNAL(done(bool)), this, SLOT(layoutDone(bool)));
+    status->setText(QString("Laying out %1 objects...").arg(graphNodes.size()));
+    layout->start();
+}
+
+
+void TopologyView::layoutDone(bool completed)
+{
+    layout->wait();
+    if (!completed) {
+        layout->deleteLater();
+        layout = 0;
+        return;
+    }
+
+    const TopologyLayout::NodeList& graphNodes(layout->nodes());
+    const TopologyLayout::EdgeList& graphEdges(layout->edges());
+    const std::vector<int>& rows(layout->rows());
+
+    int columnRows[COLUMNS] = { 0 };
+    int tallest(0);
+    for (TopologyLayout::NodeList::const_iterator iter = graphNodes.begin(); iter != graphNodes.end(); iter++)
+        tallest = std::max(tallest, ++columnRows[iter->column]);
+
+    //
+    // Apply the layout: nodes that kept their place are not touched, new ones
+    // are added, and those no longer in the graph are removed afterwards.
+    //
+    for (NodeMap::iterator iter = nodes.begin(); iter != nodes.end(); iter++)
+        iter->second->present = false;
+
+    std::vector<TopologyNode*> placed(graphNodes.size());
+    for (size_t index = 0; index < graphNodes.size(); index++) {
+        const TopologyLayout::Node& node(graphNodes[index]);
+        NodeMap::iterator shown(nodes.find(node.key));
+        TopologyNode* item;
+        if (shown == nodes.end()) {
+            item = new TopologyNode(node.key, node.column);
+            scene.addItem(item);
+            nodes[node.key] = item;
+        } else
+            item = shown->second;
+        QString label(node.label.c_str());
+        if (item->label != label) {
+            item->label = label;
+            item->update();
+        }
+        QPointF position(nodePosition(node.column, rows[index], columnRows[node.column]));
+        if (item->pos() != position)
+            item->setPos(position);
+        item->row = rows[index];
+        item->present = true;
+        placed[index] = item;
+    }
+
+    for (NodeMap::iterator iter = nodes.begin(); iter != nodes.end();) {
+        if (iter->second->present) {
+            iter++;
+            continue;
+        }
+        scene.removeItem(iter->second);
+        delete iter->second;
+        nodes.erase(iter++);
+    }
+
+    //
+    // Edges run from the right side of the node further left to the left side of
+    // the other.
+    //
+    QVector<QLineF> lines;
+    lines.reserve(graphEdges.size());
+    for (TopologyLayout::EdgeList::const_iterator iter = graphEdges.begin(); iter != graphEdges.end(); iter++) {
+        const TopologyNode* left(placed[iter->first]);
+        const TopologyNode* right(placed[iter->second]);
+        if (left->column > right->column)
+            std::swap(left, right);
+        lines.append(QLineF(left->pos() + QPointF(NODE_WIDTH / 2, 0), right->pos() - QPointF(NODE_WIDTH / 2, 0)));
+    }
+    edgeItem->setLines(lines);
+
+    qreal top((-tallest / 2.0 - 2) * ROW_SPACING);
+    for (int column = 0; column < COLUMNS; column++)
+        columnTitles[column]->setPos(column * COLUMN_SPACING - NODE_WIDTH / 2, top);
+    scene.setSceneRect(-NODE_WIDTH, top - ROW_SPACING, (COLUMNS - 1) * COLUMN_SPACING + 2 * NODE_WIDTH,
+                       (tallest + 5) * ROW_SPACING);
+
+    status->setText(QString("%1 objects, %2 references").arg(graphNodes.size()).arg(graphEdges.size()));
+    if (!fitted && !graphNodes.empty()) {
+        fitted = true;
+        fit();
+    }
+
+    layout->deleteLater();
+    layout = 0;
+}
+
+
+void TopologyView::fit()
+{
+    canvas->fitInView(scene.sceneRect(), Qt::KeepAspectRatio);
+}
+
+
+void TopologyView::activate(const TopologyNode* node)
+{
+    emit objectActivated(QString(node->key.c_str()));
+}
+
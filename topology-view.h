@@ -0,0 +1,90 @@
+#ifndef _qe_topology_view_h
+#define _qe_topology_view_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QDialog>
+#include <QTimer>
+#include <QGraphicsScene>
+#include <QLabel>
+#include <map>
+#include <string>
+#include <vector>
+
+class ObjectModel;
+class ReferenceIndex;
+class TopologyLayout;
+class TopologyCanvas;
+class TopologyNode;
+class TopologyEdges;
+
+//
+// A graph of how messages route through the broker: exchanges, the bindings
+// from them to queues, and the subscriptions and sessions consuming from those
+// queues, one column per class.  The nodes are the objects of the object model
+// and the edges come from the reference index.
+//
+// Layout runs on a background thread and its result is applied to the scene
+// incrementally: only nodes that moved, appeared or went are touched.  Nodes
+// draw less as they get smaller on screen, so a zoomed-out graph of tens of
+// thousands of nodes stays responsive.
+//
+class TopologyView : public QDialog {
+    Q_OBJECT
+
+public:
+    TopologyView(ObjectModel*, ReferenceIndex*, QWidget* parent = 0);
+    ~TopologyView();
+
+signals:
+    void objectActivated(const QString& objectKey);
+
+protected:
+    void showEvent(QShowEvent*);
+    void hideEvent(QHideEvent*);
+
+private slots:
+    void changed();
+    void refresh();
+    void layoutDone(bool);
+    void fit();
+
+private:
+    friend class TopologyCanvas;
+    typedef std::map<std::string, TopologyNode*> NodeMap;
+
+    ObjectModel* objectModel;
+    ReferenceIndex* referenceIndex;
+
+    QGraphicsScene scene;
+    TopologyCanvas* canvas;
+    QLabel* status;
+    QTimer refreshTimer;
+    std::vector<QGraphicsSimpleTextItem*> columnTitles;
+    TopologyEdges* edgeItem;
+    NodeMap nodes;
+    TopologyLayout* layout;
+    bool dirty;
+    bool fitted;
+
+    void activate(const TopologyNode*);
+};
+
+#endif
+
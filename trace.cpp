@@ -0,0 +1,227 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "trace.h"
+#include "json-writer.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QThreadStorage>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <deque>
+#include <string>
+
+namespace {
+    //
+    // Scopes kept per thread, and the number of rings kept for threads that have
+    // already exited.
+    //
+    const size_t RING_CAPACITY = 16384;
+    const size_t MAX_DEAD_RINGS = 32;
+
+    struct Span {
+        const char* name;
+        qint64 start;
+        qint64 end;
+    };
+
+    struct Ring {
+        QMutex lock;
+        int tid;
+        std::string threadName;
+        bool alive;
+        std::vector<Span> spans;
+        size_t next;
+        bool wrapped;
+
+        Ring(int t, const std::string& n) : tid(t), threadName(n), alive(true), next(0), wrapped(false) {}
+    };
+    typedef boost::shared_ptr<Ring> RingPtr;
+
+    //
+    // Held in thread-local storage; marks the ring dead when the thread exits.
+    //
+    struct RingHandle {
+        RingPtr ring;
+        RingHandle(const RingPtr& r) : ring(r) {}
+        ~RingHandle() {
+            QMutexLocker locker(&ring->lock);
+            ring->alive = false;
+        }
+    };
+
+    QMutex registryLock;
+    std::deque<RingPtr> registry;
+    int nextTid(1);
+    QThreadStorage<RingHandle*> threadRing;
+
+    QElapsedTimer& clock()
+    {
+        static QElapsedTimer timer;
+        if (!timer.isValid())
+            timer.start();
+        return timer;
+    }
+
+    Ring& currentRing()
+    {
+        if (!threadRing.hasLocalData()) {
+            QThread* thread(QThread::currentThread());
+            std::string name(thread ? thread->objectName().toStdString() : std::string());
+            if (name.empty() && thread) {
+                if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+                    name = "main";
+                else
+                    name = thread->metaObject()->className();
+            }
+
+            QMutexLocker locker(&registryLock);
+            RingPtr ring(new Ring(nextTid++, name));
+            registry.push_back(ring);
+
+            //
+            // Drop the oldest rings of exited threads beyond the limit.
+            //
+            size_t dead(0);
+            for (std::deque<RingPtr>::const_iterator iter = registry.begin(); iter != registry.end(); iter++)
+                if (!(*iter)->alive)
+                    dead++;
+            for (std::deque<RingPtr>::iterator iter = registry.begin(); dead > MAX_DEAD_RINGS && iter != registry.end();) {
+                if (!(*iter)->alive) {
+                    iter = registry.erase(iter);
+                    dead--;
+                } else
+                    iter++;
+            }
+
+            threadRing.setLocalData(new RingHandle(ring));
+        }
+        return *threadRing.localData()->ring;
+    }
+}
+
+
+namespace Trace {
+    volatile bool enabled(false);
+}
+
+
+void Trace::enable(bool on)
+{
+    clock();
+    enabled = on;
+}
+
+
+void Trace::clear()
+{
+    QMutexLocker locker(&registryLock);
+    for (std::deque<RingPtr>::const_iterator iter = registry.begin(); iter != registry.end(); iter++) {
+        QMutexLocker ringLocker(&(*iter)->lock);
+        (*iter)->spans.clear();
+        (*iter)->next = 0;
+        (*iter)->wrapped = false;
+    }
+}
+
+
+qint64 Trace::now()
+{
+    return clock().nsecsElapsed();
+}
+
+
+void Trace::record(const char* name, qint64 start, qint64 end)
+{
+    Ring& ring(currentRing());
+    Span span;
+    span.name = name;
+    span.start = start;
+    span.end = end;
+
+    //
+    // Only the owning thread writes; the lock is uncontended except during export.
+    //
+    QMutexLocker locker(&ring.lock);
+    if (ring.spans.size() < RING_CAPACITY)
+        ring.spans.push_back(span);
+    else {
+        ring.spans[ring.next] = span;
+        ring.wrapped = true;
+    }
+    ring.next = (ring.next + 1) % RING_CAPACITY;
+}
+
+
+void Trace::exportChrome(std::ostream& out)
+{
+    JsonWriter json(out);
+    json.beginObject();
+    json.field("displayTimeUnit", "ms");
+    json.key("traceEvents");
+    json.beginArray();
+
+    std::deque<RingPtr> rings;
+    {
+        QMutexLocker locker(&registryLock);
+        rings = registry;
+    }
+
+    for (std::deque<RingPtr>::const_iterator iter = rings.begin(); iter != rings.end(); iter++) {
+        Ring& ring(**iter);
+        QMutexLocker locker(&ring.lock);
+
+        json.beginObject();
+        json.field("name", "thread_name");
+        json.field("ph", "M");
+        json.field("pid", (qint64) 1);
+        json.field("tid", (qint64) ring.tid);
+        json.key("args");
+        json.beginObject();
+        json.field("name", ring.threadName);
+        json.endObject();
+        json.endObject();
+
+        //
+        // Oldest first: once the ring has wrapped, the oldest span is the next one
+        // to be overwritten.
+        //
+        size_t count(ring.spans.size());
+        size_t first(ring.wrapped ? ring.next : 0);
+        for (size_t idx = 0; idx < count; idx++) {
+            const Span& span(ring.spans[(first + idx) % count]);
+            json.beginObject();
+            json.field("name", span.name);
+            json.field("ph", "X");
+            json.field("pid", (qint64) 1);
+            json.field("tid", (qint64) ring.tid);
+            json.field("ts", span.start / 1000.0);
+            json.field("dur", (span.end - span.start) / 1000.0);
+            json.endObject();
+        }
+    }
+
+    json.endArray();
+    json.endObject();
+    out << '\n';
+    out.flush();
+}
+
@@ -0,0 +1,70 @@
+#ifndef _qe_trace_h
+#define _qe_trace_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QtGlobal>
+#include <ostream>
+
+//
+// Scoped trace points for following updates through the QMF threads and the
+// models.  Each thread records completed scopes into its own ring buffer, which
+// keeps the most recent ones; the rings can be exported together as Chrome Trace
+// Event JSON (chrome://tracing, Perfetto).
+//
+// Recording is off until enabled.  A disabled trace point costs one test of a
+// flag; building with QE_NO_TRACE removes the trace points entirely.
+//
+namespace Trace {
+    extern volatile bool enabled;
+
+    void enable(bool);
+    void clear();
+    qint64 now();
+    void record(const char* name, qint64 start, qint64 end);
+    void exportChrome(std::ostream&);
+
+    class Scope {
+    public:
+        Scope(const char* n) : name(0) {
+            if (enabled) {
+                name = n;
+                start = now();
+            }
+        }
+        ~Scope() {
+            if (name)
+                record(name, start, now());
+        }
+    private:
+        const char* name;
+        qint64 start;
+    };
+}
+
+#ifdef QE_NO_TRACE
+#define QE_TRACE_SCOPE(name)
+#else
+#define QE_TRACE_JOIN2(a, b) a##b
+#define QE_TRACE_JOIN(a, b) QE_TRACE_JOIN2(a, b)
+#define QE_TRACE_SCOPE(name) Trace::Scope QE_TRACE_JOIN(traceScope, __LINE__)(name)
+#endif
+
+#endif
+
@@ -0,0 +1,273 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "typed-sort-proxy.h"
+#include <QDateTime>
+
+namespace {
+    template <class T> int threeWay(T left, T right)
+    {
+        if (left < right)
+            return -1;
+        if (right < left)
+            return 1;
+        return 0;
+    }
+}
+
+
+TypedSortProxy::TypedSortProxy(QObject* parent) :
+    QSortFilterProxyModel(parent), keyColumn(-1), keyFilterActive(false), keyFilterRole(Qt::UserRole)
+{
+    setDynamicSortFilter(true);
+}
+
+
+void TypedSortProxy::setSourceModel(QAbstractItemModel* model)
+{
+    QAbstractItemModel* old(sourceModel());
+    if (old)
+        QObject::disconnect(old, 0, this, 0);
+
+    invalidateKeys();
+
+    //
+    // These connections are made before the base class makes its own so the
+    // cached keys are brought up to date before the proxy re-sorts anything in
+    // response to the same signal.
+    //
+    if (model) {
+        connect(model, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)),
+                this, SLOT(sourceRowsAboutToBeInserted(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                this, SLOT(sourceRowsRemoved(QModelIndex,int,int)));
+        connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                this, SLOT(sourceDataChanged(QModelIndex,QModelIndex)));
+        connect(model, SIGNAL(modelReset()), this, SLOT(invalidateKeys()));
+        connect(model, SIGNAL(layoutChanged()), this, SLOT(invalidateKeys()));
+        connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(invalidateKeys()));
+    }
+
+    QSortFilterProxyModel::setSourceModel(model);
+}
+
+
+void TypedSortProxy::sort(int column, Qt::SortOrder order)
+{
+    if (column != keyColumn)
+        invalidateKeys();
+    QSortFilterProxyModel::sort(column, order);
+}
+
+
+void TypedSortProxy::sourceRowsAboutToBeInserted(const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid() || keys.isEmpty())
+        return;
+
+    //
+    // Open a gap of unset keys for the new rows.  They are filled lazily when the
+    // proxy compares them during its sorted insertion.
+    //
+    if (start <= keys.size())
+        keys.insert(start, end - start + 1, SortKey());
+    else
+        keys.clear();
+}
+
+
+void TypedSortProxy::sourceRowsRemoved(const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid() || keys.isEmpty())
+        return;
+
+    if (end < keys.size())
+        keys.remove(start, end - start + 1);
+    else
+        keys.clear();
+}
+
+
+void TypedSortProxy::sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    if (topLeft.parent().isValid())
+        return;
+    if (keyColumn < topLeft.column() || keyColumn > bottomRight.column())
+        return;
+
+    for (int row = topLeft.row(); row <= bottomRight.row() && row < keys.size(); row++)
+        keys[row].type = KEY_UNSET;
+}
+
+
+void TypedSortProxy::invalidateKeys()
+{
+    keys.clear();
+    keyColumn = -1;
+}
+
+
+void TypedSortProxy::prepareKeys(int column) const
+{
+    if (column != keyColumn) {
+        keys.clear();
+        keyColumn = column;
+    }
+
+    int count(sourceModel()->rowCount());
+    if (keys.size() < count)
+        keys.resize(count);
+}
+
+
+const TypedSortProxy::SortKey& TypedSortProxy::sortKey(const QModelIndex& index) const
+{
+    SortKey& key(keys[index.row()]);
+    if (key.type != KEY_UNSET)
+        return key;
+
+    QVariant value(sourceModel()->data(index, Qt::UserRole));
+    if (!value.isValid())
+        value = sourceModel()->data(index, Qt::DisplayRole);
+
+    switch (value.type()) {
+    case QVariant::Invalid:
+        key.type = KEY_NONE;
+        break;
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::LongLong:
+        key.type = KEY_SIGNED;
+        key.n.i = value.toLongLong();
+        break;
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        key.type = KEY_UNSIGNED;
+        key.n.u = value.toULongLong();
+        break;
+    case QVariant::Double:
+        key.type = KEY_DOUBLE;
+        key.n.d = value.toDouble();
+        break;
+    case QVariant::DateTime:
+        key.type = KEY_SIGNED;
+        key.n.i = value.toDateTime().toMSecsSinceEpoch();
+        break;
+    default:
+        key.type = KEY_STRING;
+        key.s = value.toString();
+        break;
+    }
+
+    return key;
+}
+
+
+int TypedSortProxy::compareKeys(const SortKey& left, const SortKey& right)
+{
+    //
+    // Rows without a value sort first, strings sort after all numbers.
+    //
+    bool leftString(left.type == KEY_STRING);
+    bool rightString(right.type == KEY_STRING);
+
+    if (left.type == KEY_NONE || right.type == KEY_NONE)
+        return threeWay<int>(left.type == KEY_NONE ? 0 : 1, right.type == KEY_NONE ? 0 : 1);
+    if (leftString || rightString) {
+        if (leftString != rightString)
+            return leftString ? 1 : -1;
+        return left.s.compare(right.s);
+    }
+
+    if (left.type == right.type)
+        switch (left.type) {
+        case KEY_SIGNED:   return threeWay<qint64>(left.n.i, right.n.i);
+        case KEY_UNSIGNED: return threeWay<quint64>(left.n.u, right.n.u);
+        default:           return threeWay<double>(left.n.d, right.n.d);
+        }
+
+    if (left.type == KEY_DOUBLE || right.type == KEY_DOUBLE) {
+        double l(left.type == KEY_DOUBLE ? left.n.d :
+                 left.type == KEY_SIGNED ? (double) left.n.i : (double) left.n.u);
+        double r(right.type == KEY_DOUBLE ? right.n.d :
+                 right.type == KEY_SIGNED ? (double) right.n.i : (double) right.n.u);
+        return threeWay<double>(l, r);
+    }
+
+    //
+    // Mixed signed and unsigned.
+    //
+    if (left.type == KEY_SIGNED)
+        return left.n.i < 0 ? -1 : threeWay<quint64>((quint64) left.n.i, right.n.u);
+    return right.n.i < 0 ? 1 : threeWay<quint64>(left.n.u, (quint64) right.n.i);
+}
+
+
+bool TypedSortProxy::lessThan(const QModelIndex& left, const QModelIndex& right) const
+{
+    //
+    // Only top-level rows of the source are cached; anything else falls back to
+    // the default comparison.
+    //
+    if (left.parent().isValid() || right.parent().isValid())
+        return QSortFilterProxyModel::lessThan(left, right);
+
+    //
+    // Size the cache once up front so neither key reference below can be
+    // invalidated by the other lookup.
+    //
+    prepareKeys(left.column());
+    int result(compareKeys(sortKey(left), sortKey(right)));
+    if (result == 0)
+        return left.row() < right.row();
+    return result < 0;
+}
+
+
+
+void TypedSortProxy::setKeyFilter(int role, const QSet<quint64>& accepted)
+{
+    keyFilterActive = true;
+    keyFilterRole = role;
+    keyFilter = accepted;
+    invalidateFilter();
+}
+
+
+void TypedSortProxy::clearKeyFilter()
+{
+    if (!keyFilterActive)
+        return;
+    keyFilterActive = false;
+    keyFilter.clear();
+    invalidateFilter();
+}
+
+
+bool TypedSortProxy::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+    if (keyFilterActive) {
+        QModelIndex index(sourceModel()->index(sourceRow, 0, sourceParent));
+        if (!keyFilter.contains(sourceModel()->data(index, keyFilterRole).toULongLong()))
+            return false;
+    }
+
+    return QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent);
+}
+
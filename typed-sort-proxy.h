@@ -0,0 +1,94 @@
+#ifndef _qe_typed_sort_proxy_h
+#define _qe_typed_sort_proxy_h
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <QSortFilterProxyModel>
+#include <QVector>
+#include <QSet>
+#include <QString>
+
+//
+// Sort/filter proxy that orders rows by the typed value a source model
+// publishes under Qt::UserRole (falling back to the display text).  The sort
+// key of each source row in the sort column is computed once and cached, so a
+// comparison never has to build a QString.  New source rows are placed with
+// the proxy's incremental insertion rather than a full re-sort.
+//
+class TypedSortProxy : public QSortFilterProxyModel {
+    Q_OBJECT
+
+public:
+    TypedSortProxy(QObject* parent = 0);
+
+    void setSourceModel(QAbstractItemModel*);
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+    //
+    // Restrict the visible rows to those whose value for the given role (read
+    // from column 0) is in the set.  This is used to show search results.
+    //
+    void setKeyFilter(int role, const QSet<quint64>&);
+    void clearKeyFilter();
+
+    //
+    // Add a key to an active filter without re-filtering.  A key added while its
+    // source row is being inserted takes effect as the row is placed.
+    //
+    void acceptKey(quint64 key) { if (keyFilterActive) keyFilter.insert(key); }
+    bool keyFilterEnabled() const { return keyFilterActive; }
+
+protected:
+    bool lessThan(const QModelIndex&, const QModelIndex&) const;
+    bool filterAcceptsRow(int, const QModelIndex&) const;
+
+private slots:
+    void sourceRowsAboutToBeInserted(const QModelIndex&, int, int);
+    void sourceRowsRemoved(const QModelIndex&, int, int);
+    void sourceDataChanged(const QModelIndex&, const QModelIndex&);
+    void invalidateKeys();
+
+private:
+    typedef enum { KEY_UNSET, KEY_NONE, KEY_SIGNED, KEY_UNSIGNED, KEY_DOUBLE, KEY_STRING } KeyType;
+
+    struct SortKey {
+        KeyType type;
+        union {
+            qint64 i;
+            quint64 u;
+            double d;
+        } n;
+        QString s;
+
+        SortKey() : type(KEY_UNSET) {}
+    };
+
+    mutable QVector<SortKey> keys;
+    mutable int keyColumn;
+    bool keyFilterActive;
+    int keyFilterRole;
+    QSet<quint64> keyFilter;
+
+    void prepareKeys(int column) const;
+    const SortKey& sortKey(const QModelIndex&) const;
+    static int compareKeys(const SortKey&, const SortKey&);
+};
+
+#endif
+